@@ -4,13 +4,21 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <climits>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <exception>
 #include <functional>
-#include <map>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <m/byte_streams/byte_streams.h>
 
 namespace m
 {
@@ -18,8 +26,6 @@ namespace m
     {
         using file_position_t = uint64_t;
 
-        using fetch_bytes_t = std::function<void()>;
-
         template <std::size_t Log2BufferCount = 6, // 64 buffer by default
                   std::size_t Log2BufferSize  = 16 // 65536 (64kb) bytes in each buffer
                   >
@@ -36,23 +42,95 @@ namespace m
             constexpr static inline std::size_t buffer_size  = 1ull << Log2BufferSize;
         };
 
-        class block_buffer
+        struct block_buffer_options
+        {
+            // How many buffers to cache; each is block_buffer::buffer_size bytes
+            std::size_t m_buffer_count = buffer_traits<>::buffer_count;
+
+            //
+            // How many buffers past the end of a sequential run of reads to
+            // fetch ahead of time on the threadpool's blocking workers. Zero
+            // turns read-ahead off.
+            //
+            std::size_t m_read_ahead = 4;
+        };
+
+        /// <summary>
+        /// What a block_buffer has done since it was created, from
+        /// `block_buffer::statistics()`.
+        /// </summary>
+        struct block_buffer_statistics
+        {
+            std::uint64_t m_hits{};            // Buffer reads served from the cache
+            std::uint64_t m_misses{};          // Buffer reads that went to the source
+            std::uint64_t m_evictions{};       // Cached buffers given over to another block
+            std::uint64_t m_read_ahead{};      // Buffers fetched ahead of being asked for
+            std::uint64_t m_read_ahead_hits{}; // ... and later read
+        };
+
+        //
+        // A caching random access stream over another one. The source is
+        // read a whole buffer at a time, at positions that are a multiple of
+        // the buffer size. Reads that carry on from where the same thread's
+        // last one stopped count as sequential, and once there is a run of
+        // them the buffers that follow are fetched before they are asked
+        // for.
+        //
+        // Wrapping a slow source, a file or a decompressor say, makes small
+        // and scattered reads cheap. Reads may come from any number of
+        // threads at once. A read of a cached block takes no lock: the
+        // buffers are found in an open addressing table whose slots are
+        // claimed, pinned and released with 128-bit compare and swap. Only
+        // misses, read-ahead and eviction serialize on a mutex, and the
+        // source is read with that released too.
+        //
+        // Always owned by a std::shared_ptr, from make_block_buffer;
+        // read-ahead keeps a reference until it has finished.
+        //
+        class block_buffer :
+            public byte_streams::ra_in,
+            public std::enable_shared_from_this<block_buffer>
         {
             // workaround while figuring out how to templatize
             using traits_type = buffer_traits<>;
 
-        public:
-            constexpr static inline std::size_t buffer_count = 100; // traits_type::buffer_count;
+            //
+            // Only make_block_buffer can name this, so every block_buffer
+            // has the std::shared_ptr that read-ahead takes a reference from.
+            //
+            struct construction_key
+            {
+                explicit construction_key() = default;
+            };
 
+            friend std::shared_ptr<block_buffer>
+            make_block_buffer(std::shared_ptr<byte_streams::ra_in> source,
+                              block_buffer_options const&          options);
+
+        public:
             constexpr static inline std::size_t buffer_size = traits_type::buffer_size;
 
-            template <typename Callable, typename... Types>
-            block_buffer(Callable f, Types... args): m_fetch_bytes(std::bind(f, args...))
-            {}
+            block_buffer(construction_key,
+                         std::shared_ptr<byte_streams::ra_in> source,
+                         block_buffer_options const&          options);
+            block_buffer(block_buffer const&) = delete;
+            block_buffer(block_buffer&&)      = delete;
 
-        private:
-            fetch_bytes_t m_fetch_bytes;
+            void
+            operator=(block_buffer const&) = delete;
 
+            void
+            operator=(block_buffer&&) = delete;
+
+            block_buffer_statistics
+            statistics();
+
+        protected:
+            // byte_streams::ra_in
+            std::size_t
+            do_read(position_t position, std::span<std::byte>& s) override;
+
+        private:
             using buffer_type = std::array<std::byte, buffer_size>;
 
             //
@@ -62,50 +140,145 @@ namespace m
             // a single type for all the fields.
             //
             // Many of the fields are logically Boolean valued, but as some
-            // may hold non-Boolean values, uintmax_t is used so that unsigned
-            // values are stored and are almost certainly packed together.
+            // may hold non-Boolean values, std::uint64_t is used so that
+            // unsigned values are stored and are almost certainly packed
+            // together.
             //
-            // The entire struct is unioned with a value which is usable with
-            // the InterlockedCompareExchange128 intrinsic. The
-            // InterlockedCompareExchange128 primitive is somewhat strangely
-            // specified, but it's best to be able to avoid casting.
+            // Together with the file position the word makes up a
+            // buffer_control_block, sixteen bytes aligned to sixteen, which
+            // is the unit of the 128-bit compare and swap (cmpxchg16b,
+            // InterlockedCompareExchange128) that every change goes through.
             //
             struct buffer_control_word
             {
-                constexpr buffer_control_word(): m_busy(0), m_reserved_unused(0) {}
+                constexpr buffer_control_word():
+                    m_busy(0),
+                    m_valid(0),
+                    m_referenced(0),
+                    m_read_ahead(0),
+                    m_size(0),
+                    m_pins(0),
+                    m_reserved_unused(0)
+                {}
 
-                uintptr_t m_busy : 1;
+                std::uint64_t m_busy : 1;       // Being filled from the source
+                std::uint64_t m_valid : 1;      // Holds the block at m_file_position
+                std::uint64_t m_referenced : 1; // Read since eviction last passed it over
+                std::uint64_t m_read_ahead : 1; // Filled by read-ahead and not read since
+                std::uint64_t m_size : 17;      // Bytes held, short at the end of the source
+                std::uint64_t m_pins : 16;      // Readers copying out of the buffer
 
-                uintptr_t m_reserved_unused : 63;
+                std::uint64_t m_reserved_unused : 27;
             };
 
-            static_assert(sizeof(buffer_control_word) == sizeof(uintptr_t));
+            static_assert(sizeof(buffer_control_word) == sizeof(std::uint64_t));
+            static_assert(buffer_size < (1ull << 17));
 
-            struct buffer_control_block
+            struct alignas(16) buffer_control_block
             {
-                constexpr buffer_control_block(): m_control_word() {}
+                constexpr buffer_control_block(): m_file_position(), m_control_word() {}
                 file_position_t     m_file_position;
                 buffer_control_word m_control_word;
             };
 
+            static_assert(sizeof(buffer_control_block) == 16);
+
             //
-            // TODO: Change this constant to the constant that represents the
-            // cache line size, can't remember it offhand. The control block
-            // may have several pointers etc in it but don't let it get out
-            // of hand.
+            // A block can live in any of the slots from the one its index
+            // maps to onwards, this many at most, so that consecutive blocks
+            // land in consecutive slots and a lookup touches a few cache
+            // lines at most.
             //
-            static_assert(sizeof(buffer_control_block) <= 64);
+            constexpr static inline std::size_t probe_length = 16;
 
-            std::mutex m_mutex;
+            //
+            // Copies what it can of `to` from the block at `block_position`,
+            // `offset` bytes in, fetching the block first if need be.
+            // Returns the number of bytes copied, which is short only at the
+            // end of the source.
+            //
+            std::size_t
+            read_block(file_position_t block_position, std::size_t offset, std::span<std::byte> to);
+
+            //
+            // The lock-free path: if the block is cached and filled, pins
+            // it, copies out of it and unpins it. Returns nothing if it is
+            // not there.
+            //
+            std::optional<std::size_t>
+            read_cached(file_position_t      block_position,
+                        std::size_t          offset,
+                        std::span<std::byte> to,
+                        bool                 count_hit);
+
+            // The slot holding or filling the block, if any
+            buffer_control_block*
+            find(file_position_t block_position) noexcept;
+
+            // A slot to give over to the block, marked busy, or nullptr if
+            // none can be had. Called with m_mutex held.
+            buffer_control_block*
+            claim_buffer(file_position_t block_position);
+
+            // Reads the block into its buffer, called without m_mutex
+            std::size_t
+            fill(buffer_control_block& bcb);
+
+            //
+            // Called with m_mutex held once fill has returned `size`, or
+            // thrown when `size` is empty.
+            //
+            void
+            filled(buffer_control_block& bcb, std::optional<std::size_t> size);
+
+            // Starts read-ahead of the blocks after `block_position`. Called
+            // with m_mutex held.
+            void
+            read_ahead(file_position_t block_position);
+
+            buffer_type&
+            buffer(buffer_control_block const& bcb) noexcept
+            {
+                return m_buffers[static_cast<std::size_t>(&bcb - m_control_blocks.data())];
+            }
+
+            std::shared_ptr<byte_streams::ra_in> m_source;
+            std::size_t                          m_read_ahead_count;
+
+            std::vector<buffer_control_block> m_control_blocks;
+            std::unique_ptr<buffer_type[]>    m_buffers;
+
+            //
+            // Hits are counted without the lock, spread over several cache
+            // lines so that readers on different threads do not fight over
+            // one.
+            //
+            struct alignas(64) hit_counter
+            {
+                std::atomic<std::uint64_t> m_hits;
+                std::atomic<std::uint64_t> m_read_ahead_hits;
+            };
+
+            std::array<hit_counter, 16> m_hit_counters{};
+
+            std::mutex              m_mutex;
+            std::condition_variable m_filled; // A busy buffer stopped being busy
 
             //
-            // Counter for which block to use next. always increment, use modulus
-            // to determine which buffer/control block is selected.
+            // The end of the source, once a short block has shown where it
+            // is, so that read-ahead does not go past it.
             //
-            // std::size_t                                            m_allocated_buffer_counter;
-            std::map<file_position_t, buffer_control_block const*> m_bcbmap;
-            std::array<buffer_control_block, buffer_count>         m_control_blocks;
-            // std::array<buffer_type, buffer_count>                  m_buffers;
+            file_position_t m_end{(std::numeric_limits<file_position_t>::max)()};
+
+            // Counted under m_mutex; m_hits and m_read_ahead_hits are not used
+            block_buffer_statistics m_statistics;
         };
+
+        /// <summary>
+        /// Creates a block_buffer caching `source`.
+        /// </summary>
+        std::shared_ptr<block_buffer>
+        make_block_buffer(std::shared_ptr<byte_streams::ra_in> source,
+                          block_buffer_options const&          options = {});
     } // namespace block_buffer
-} // namespace m
\ No newline at end of file
+} // namespace m
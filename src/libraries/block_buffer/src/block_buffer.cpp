@@ -1,5 +1,535 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #include <m/block_buffer/block_buffer.h>
+#include <m/threadpool/threadpool.h>
+
+namespace
+{
+#ifndef _MSC_VER
+    __extension__ typedef unsigned __int128 uint128_t;
+#endif
+
+    //
+    // Compare and swap of a whole control block. With cmpxchg16b available
+    // (-mcx16) it is inline; elsewhere the compiler's 16 byte atomics do
+    // what the platform allows. On failure `expected` is updated with what
+    // was there.
+    //
+    template <typename T>
+    bool
+    compare_exchange(T& target, T& expected, T const& desired) noexcept
+    {
+        static_assert(sizeof(T) == 16 && alignof(T) == 16);
+
+#ifdef _MSC_VER
+        long long d[2];
+        std::memcpy(d, &desired, sizeof(d));
+
+        return _InterlockedCompareExchange128(reinterpret_cast<long long volatile*>(&target),
+                                              d[1],
+                                              d[0],
+                                              reinterpret_cast<long long*>(&expected)) != 0;
+#else
+        uint128_t e;
+        uint128_t d;
+
+        std::memcpy(&e, &expected, sizeof(e));
+        std::memcpy(&d, &desired, sizeof(d));
+
+        auto const p = reinterpret_cast<uint128_t*>(&target);
+
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_16
+        auto const was       = __sync_val_compare_and_swap(p, e, d);
+        auto const exchanged = was == e;
+        e                    = was;
+#else
+        auto const exchanged =
+            __atomic_compare_exchange_n(p, &e, d, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+        if (!exchanged)
+            std::memcpy(static_cast<void*>(&expected), &e, sizeof(e));
+
+        return exchanged;
+#endif
+    }
+
+    //
+    // The two halves are loaded separately, so may come from different
+    // values; anything made of the result goes through compare_exchange,
+    // which catches that.
+    //
+    template <typename T>
+    T
+    load(T& target) noexcept
+    {
+        T v;
+        v.m_file_position = std::atomic_ref(target.m_file_position).load(std::memory_order_acquire);
+        v.m_control_word  = std::atomic_ref(target.m_control_word).load(std::memory_order_acquire);
+        return v;
+    }
+
+    //
+    // Applies `f` to a copy of the control block and swaps it in, over and
+    // over until nothing has changed it in the meantime. `f` returns false
+    // to leave the block as it is, and update then returns false too.
+    //
+    template <typename T, typename F>
+    bool
+    update(T& target, F&& f)
+    {
+        auto expected = load(target);
+
+        for (;;)
+        {
+            auto desired = expected;
+
+            if (!f(desired))
+                return false;
+
+            if (compare_exchange(target, expected, desired))
+                return true;
+        }
+    }
+
+    // Which of the hit counters this thread adds to
+    std::size_t
+    shard() noexcept
+    {
+        static std::atomic<std::size_t> s_next;
+        thread_local std::size_t const  t_shard = s_next.fetch_add(1, std::memory_order_relaxed);
+        return t_shard;
+    }
+
+    //
+    // Sequential runs are tracked per thread, so that readers on different
+    // threads neither break each other's runs nor share a cache line to
+    // keep track. Only the block_buffer the thread read last is followed.
+    //
+    struct sequential_state
+    {
+        void const*                      m_owner{};
+        m::block_buffer::file_position_t m_next{};
+        std::size_t                      m_run{};
+    };
+
+    thread_local sequential_state t_sequential;
+} // namespace
+
+m::block_buffer::block_buffer::block_buffer(construction_key,
+                                            std::shared_ptr<byte_streams::ra_in> source,
+                                            block_buffer_options const&          options):
+    m_source(std::move(source)),
+    m_read_ahead_count(options.m_read_ahead),
+    m_control_blocks(options.m_buffer_count),
+    m_buffers(std::make_unique<buffer_type[]>(options.m_buffer_count))
+{
+    if (!m_source)
+        throw std::invalid_argument("block_buffer needs a source");
+
+    if (options.m_buffer_count == 0)
+        throw std::invalid_argument("block_buffer needs at least one buffer");
+}
+
+m::block_buffer::block_buffer_statistics
+m::block_buffer::block_buffer::statistics()
+{
+    auto const l = std::unique_lock(m_mutex);
+    auto       s = m_statistics;
+
+    for (auto const& counter: m_hit_counters)
+    {
+        s.m_hits += counter.m_hits.load(std::memory_order_relaxed);
+        s.m_read_ahead_hits += counter.m_read_ahead_hits.load(std::memory_order_relaxed);
+    }
+
+    return s;
+}
+
+std::size_t
+m::block_buffer::block_buffer::do_read(position_t position, std::span<std::byte>& s)
+{
+    auto const start = std::to_underlying(position);
+
+    std::size_t done{};
+
+    while (done < s.size())
+    {
+        auto const p              = start + done;
+        auto const block_position = p - p % buffer_size;
+        auto const offset         = static_cast<std::size_t>(p - block_position);
+        auto const n              = read_block(block_position, offset, s.subspan(done));
+
+        done += n;
+
+        if (n == 0 || (offset + n < buffer_size && done < s.size()))
+            break; // The end of the source
+    }
+
+    auto& sequential = t_sequential;
+
+    if (sequential.m_owner != this)
+        sequential = {this, (std::numeric_limits<file_position_t>::max)(), 0};
+
+    sequential.m_run  = start == sequential.m_next ? sequential.m_run + 1 : 0;
+    sequential.m_next = start + done;
+
+    //
+    // Two reads in a row that follow on from each other make a run; one on
+    // its own is as likely as not a coincidence. After that, only reads
+    // that reach a new block have anything new to read ahead.
+    //
+    if (sequential.m_run != 0 && m_read_ahead_count != 0 && done != 0)
+    {
+        auto const last = start + done - 1;
+
+        if (sequential.m_run == 1 || start % buffer_size == 0 ||
+            (start - 1) / buffer_size != last / buffer_size)
+        {
+            auto const l = std::unique_lock(m_mutex);
+            read_ahead(last - last % buffer_size);
+        }
+    }
+
+    s = s.first(done);
+    return done;
+}
+
+std::size_t
+m::block_buffer::block_buffer::read_block(file_position_t      block_position,
+                                          std::size_t          offset,
+                                          std::span<std::byte> to)
+{
+    if (auto const n = read_cached(block_position, offset, to, true))
+        return *n;
+
+    auto l       = std::unique_lock(m_mutex);
+    bool counted = false;
+
+    for (;;)
+    {
+        //
+        // Misses take the lock, and with it their turn at claiming a
+        // buffer. Look again, as the block may have turned up while this
+        // thread waited for it.
+        //
+        if (auto const n = read_cached(block_position, offset, to, !counted))
+            return *n;
+
+        if (find(block_position))
+        {
+            if (!counted)
+            {
+                m_hit_counters[shard() % m_hit_counters.size()].m_hits.fetch_add(
+                    1, std::memory_order_relaxed);
+                counted = true;
+            }
+
+            // Someone else is fetching it, most likely read-ahead
+            m_filled.wait(l);
+            continue;
+        }
+
+        if (!counted)
+        {
+            m_statistics.m_misses++;
+            counted = true;
+        }
+
+        auto const bcb = claim_buffer(block_position);
+
+        if (!bcb)
+        {
+            //
+            // Every buffer the block could go in is busy or being read.
+            // Rather than wait for one, read around the cache.
+            //
+            l.unlock();
+
+            auto const size = (std::min)(to.size(), buffer_size - offset);
+            return m_source->read(position_t{block_position + offset}, to.first(size));
+        }
+
+        l.unlock();
+
+        std::optional<std::size_t> size;
+
+        try
+        {
+            size = fill(*bcb);
+        }
+        catch (...)
+        {
+            l.lock();
+            filled(*bcb, std::nullopt);
+            throw;
+        }
+
+        l.lock();
+        filled(*bcb, size);
+    }
+}
+
+std::optional<std::size_t>
+m::block_buffer::block_buffer::read_cached(file_position_t      block_position,
+                                           std::size_t          offset,
+                                           std::span<std::byte> to,
+                                           bool                 count_hit)
+{
+    auto const count = m_control_blocks.size();
+    auto const probe = (std::min)(probe_length, count);
+    auto const home  = static_cast<std::size_t>(block_position / buffer_size % count);
+
+    for (std::size_t i = 0; i < probe; i++)
+    {
+        auto& bcb = m_control_blocks[(home + i) % count];
+
+        std::size_t size{};
+        bool        read_ahead{};
+
+        auto const pinned = update(bcb, [&](buffer_control_block& b) {
+            auto& cw = b.m_control_word;
+
+            if (b.m_file_position != block_position || !cw.m_valid || cw.m_busy)
+                return false;
+
+            size       = cw.m_size;
+            read_ahead = cw.m_read_ahead;
+
+            cw.m_pins++;
+            cw.m_referenced = 1;
+            cw.m_read_ahead = 0;
+
+            return true;
+        });
+
+        if (!pinned)
+            continue;
+
+        auto& counter = m_hit_counters[shard() % m_hit_counters.size()];
+
+        if (count_hit)
+            counter.m_hits.fetch_add(1, std::memory_order_relaxed);
+
+        if (read_ahead)
+            counter.m_read_ahead_hits.fetch_add(1, std::memory_order_relaxed);
+
+        auto const n = offset < size ? (std::min)(to.size(), size - offset) : 0;
+        std::memcpy(to.data(), buffer(bcb).data() + offset, n);
+
+        update(bcb, [](buffer_control_block& b) {
+            b.m_control_word.m_pins--;
+            return true;
+        });
+
+        return n;
+    }
+
+    return std::nullopt;
+}
+
+m::block_buffer::block_buffer::buffer_control_block*
+m::block_buffer::block_buffer::find(file_position_t block_position) noexcept
+{
+    auto const count = m_control_blocks.size();
+    auto const probe = (std::min)(probe_length, count);
+    auto const home  = static_cast<std::size_t>(block_position / buffer_size % count);
+
+    for (std::size_t i = 0; i < probe; i++)
+    {
+        auto&      bcb = m_control_blocks[(home + i) % count];
+        auto const b   = load(bcb);
+
+        if (b.m_file_position == block_position &&
+            (b.m_control_word.m_valid || b.m_control_word.m_busy))
+            return &bcb;
+    }
+
+    return nullptr;
+}
+
+m::block_buffer::block_buffer::buffer_control_block*
+m::block_buffer::block_buffer::claim_buffer(file_position_t block_position)
+{
+    auto const count = m_control_blocks.size();
+    auto const probe = (std::min)(probe_length, count);
+    auto const home  = static_cast<std::size_t>(block_position / buffer_size % count);
+
+    enum class outcome
+    {
+        passed_over,
+        second_chance,
+        claimed,
+    };
+
+    //
+    // Twice along the probe sequence at most: the first pass may do no
+    // more than take away second chances. Buffers that are being filled
+    // or copied out of are passed over.
+    //
+    for (std::size_t pass = 0; pass < 2; pass++)
+    {
+        for (std::size_t i = 0; i < probe; i++)
+        {
+            auto& bcb = m_control_blocks[(home + i) % count];
+
+            auto result  = outcome::passed_over;
+            auto evicted = false;
+
+            update(bcb, [&](buffer_control_block& b) {
+                auto& cw = b.m_control_word;
+
+                result = outcome::passed_over;
+
+                if (cw.m_busy || cw.m_pins != 0)
+                    return false;
+
+                if (cw.m_valid && cw.m_referenced)
+                {
+                    cw.m_referenced = 0;
+                    result          = outcome::second_chance;
+                    return true;
+                }
+
+                evicted = cw.m_valid;
+
+                b.m_file_position = block_position;
+                cw                = buffer_control_word();
+                cw.m_busy         = 1;
+                result            = outcome::claimed;
+
+                return true;
+            });
+
+            if (result == outcome::claimed)
+            {
+                if (evicted)
+                    m_statistics.m_evictions++;
+
+                return &bcb;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+std::size_t
+m::block_buffer::block_buffer::fill(buffer_control_block& bcb)
+{
+    // Nothing else changes the position of a busy buffer
+    return m_source->read(position_t{bcb.m_file_position}, std::span(buffer(bcb)));
+}
+
+void
+m::block_buffer::block_buffer::filled(buffer_control_block& bcb, std::optional<std::size_t> size)
+{
+    if (size)
+    {
+        if (*size < buffer_size)
+            m_end = (std::min)(m_end, bcb.m_file_position + *size);
+
+        update(bcb, [&](buffer_control_block& b) {
+            auto& cw        = b.m_control_word;
+            cw.m_busy       = 0;
+            cw.m_valid      = 1;
+            cw.m_referenced = 1;
+            cw.m_size       = *size;
+            return true;
+        });
+    }
+    else
+    {
+        // Whoever asks next reads it again and sees the error for themselves
+        update(bcb, [](buffer_control_block& b) {
+            b = buffer_control_block();
+            return true;
+        });
+    }
+
+    m_filled.notify_all();
+}
+
+void
+m::block_buffer::block_buffer::read_ahead(file_position_t block_position)
+{
+    //
+    // Never more than half the buffers, or read-ahead would push out the
+    // very blocks it was fetched in front of.
+    //
+    auto const count = (std::min)(m_read_ahead_count, m_control_blocks.size() / 2);
+
+    for (std::size_t i = 1; i <= count; i++)
+    {
+        auto const next = block_position + i * buffer_size;
+
+        if (next >= m_end)
+            break;
+
+        if (find(next))
+            continue;
+
+        auto const bcb = claim_buffer(next);
+
+        if (!bcb)
+            break;
+
+        update(*bcb, [](buffer_control_block& b) {
+            b.m_control_word.m_read_ahead = 1;
+            return true;
+        });
+
+        try
+        {
+            m::threadpool->submit_blocking([self = shared_from_this(), bcb]() {
+                std::optional<std::size_t> size;
+
+                try
+                {
+                    size = self->fill(*bcb);
+                }
+                catch (...)
+                {
+                }
+
+                auto const l = std::unique_lock(self->m_mutex);
+                self->filled(*bcb, size);
+            });
+        }
+        catch (...)
+        {
+            //
+            // Read-ahead is only ever a guess, so the read that asked for
+            // it goes on; the buffer is handed back rather than left busy.
+            //
+            filled(*bcb, std::nullopt);
+            break;
+        }
+
+        m_statistics.m_read_ahead++;
+    }
+}
 
+std::shared_ptr<m::block_buffer::block_buffer>
+m::block_buffer::make_block_buffer(std::shared_ptr<byte_streams::ra_in> source,
+                                   block_buffer_options const&          options)
+{
+    return std::make_shared<block_buffer>(
+        block_buffer::construction_key(), std::move(source), options);
+}
@@ -0,0 +1,131 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <m/block_buffer/block_buffer.h>
+#include <m/byte_streams/byte_streams.h>
+#include <m/byte_streams/memory_based_byte_streams.h>
+
+//
+// Small random reads from many threads over a block_buffer that already
+// holds the whole source, so that every read is a hit. The lock-free
+// lookup is run against the same cache behind a mutex, which is how
+// lookups went before, to show what the lock costs as threads are added.
+//
+
+namespace
+{
+    constexpr std::size_t block_count    = 256;
+    constexpr std::size_t reads_per_pass = 1'000'000;
+    constexpr std::size_t read_size      = 64;
+
+    class locked_ra_in : public m::byte_streams::ra_in
+    {
+    public:
+        explicit locked_ra_in(std::shared_ptr<m::byte_streams::ra_in> inner): m_inner(inner) {}
+
+    protected:
+        std::size_t
+        do_read(position_t position, std::span<std::byte>& s) override
+        {
+            auto const l = std::unique_lock(m_mutex);
+            return m_inner->read(position, s);
+        }
+
+        std::mutex                              m_mutex;
+        std::shared_ptr<m::byte_streams::ra_in> m_inner;
+    };
+
+    void
+    run(std::string_view name, m::byte_streams::ra_in& in, std::size_t size, std::size_t threads)
+    {
+        std::atomic<std::uint64_t> checksum{};
+        std::vector<std::thread>   workers;
+
+        auto const start = std::chrono::steady_clock::now();
+
+        for (std::size_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&, t]() {
+                std::array<std::byte, read_size> buffer{};
+                std::uint64_t                    sum{};
+                std::uint64_t                    x = 0x9e3779b97f4a7c15ull * (t + 1);
+
+                for (std::size_t i = 0; i < reads_per_pass / threads; i++)
+                {
+                    x ^= x << 13;
+                    x ^= x >> 7;
+                    x ^= x << 17;
+
+                    auto const position = x % (size - read_size);
+                    auto const n = in.read(m::io::position_t{position}, std::span(buffer));
+
+                    sum += n + std::to_integer<std::uint64_t>(buffer[0]);
+                }
+
+                checksum += sum;
+            });
+        }
+
+        for (auto& w: workers)
+            w.join();
+
+        auto const elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        std::println("{:10} threads {:>3}  {} reads of {} bytes {:>10}  {:>6.1f}M reads/s",
+                     name,
+                     threads,
+                     reads_per_pass,
+                     read_size,
+                     elapsed,
+                     static_cast<double>(reads_per_pass) / static_cast<double>(elapsed.count()));
+
+        EXPECT_NE(checksum.load(), 0u);
+    }
+} // namespace
+
+TEST(BlockBufferBenchmark, RandomReads)
+{
+    auto const size = block_count * m::block_buffer::block_buffer::buffer_size;
+    auto const data = std::make_unique<std::byte[]>(size);
+
+    for (std::size_t i = 0; i < size; i++)
+        data[i] = static_cast<std::byte>(i * 31 + i / 4093);
+
+    auto const source = m::byte_streams::make_memory_based_byte_stream(data.get(), size);
+    auto const cache  = m::block_buffer::make_block_buffer(
+        source, {.m_buffer_count = block_count, .m_read_ahead = 0});
+
+    // Fill the cache
+    std::vector<std::byte> all(size);
+    EXPECT_EQ(cache->read(m::io::position_t{0}, std::span(all)), size);
+
+    locked_ra_in locked(cache);
+
+    // Past the number of cores too, where a preempted lock holder hurts most
+    auto const most = (std::max)(std::thread::hardware_concurrency(), 8u);
+
+    for (std::size_t threads = 1; threads <= most; threads *= 2)
+    {
+        run("lock-free", *cache, size, threads);
+        run("locked", locked, size, threads);
+    }
+
+    auto const statistics = cache->statistics();
+    EXPECT_EQ(statistics.m_misses, block_count);
+}
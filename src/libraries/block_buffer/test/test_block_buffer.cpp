@@ -0,0 +1,203 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <m/block_buffer/block_buffer.h>
+#include <m/byte_streams/byte_streams.h>
+
+#include "test_bytes.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    constexpr std::size_t block_size = m::block_buffer::block_buffer::buffer_size;
+
+    //
+    // An in-memory source that counts how often it is read and can be
+    // told to fail.
+    //
+    class counting_source : public m::byte_streams::ra_in
+    {
+    public:
+        explicit counting_source(std::size_t size): m_bytes(pattern(size)) {}
+
+        std::span<std::byte const>
+        bytes() const noexcept
+        {
+            return m_bytes;
+        }
+
+        std::atomic<std::size_t> m_reads{};
+        std::atomic<bool>        m_fail{};
+
+    protected:
+        std::size_t
+        do_read(position_t position, std::span<std::byte>& s) override
+        {
+            m_reads++;
+
+            if (m_fail)
+                throw std::system_error(std::make_error_code(std::errc::io_error));
+
+            auto const p = std::to_underlying(position);
+
+            if (p >= m_bytes.size())
+            {
+                s = s.first(0);
+                return 0;
+            }
+
+            auto const n = (std::min)(s.size(), m_bytes.size() - static_cast<std::size_t>(p));
+            std::copy_n(m_bytes.begin() + static_cast<std::ptrdiff_t>(p), n, s.begin());
+
+            s = s.first(n);
+            return n;
+        }
+
+        std::vector<std::byte> m_bytes;
+    };
+
+    bool
+    read_matches(m::byte_streams::ra_in&  in,
+                 counting_source const& source,
+                 std::size_t            position,
+                 std::size_t            size)
+    {
+        std::vector<std::byte> buffer(size);
+
+        auto const n    = in.read(m::io::position_t{position}, std::span(buffer));
+        auto const want =
+            position < source.bytes().size() ? (std::min)(size, source.bytes().size() - position)
+                                             : 0;
+
+        return n == want &&
+               std::ranges::equal(std::span(buffer).first(n), source.bytes().subspan(position, n));
+    }
+} // namespace
+
+TEST(block_buffer, small_reads_hit_the_cache)
+{
+    auto const source = std::make_shared<counting_source>(4 * block_size + 1000);
+    auto const cache  = m::block_buffer::make_block_buffer(source, {.m_read_ahead = 0});
+
+    for (std::size_t i = 0; i < 1000; i++)
+        ASSERT_TRUE(read_matches(*cache, *source, (i * 7919) % (4 * block_size), 16));
+
+    // One source read per block, however many reads land in it
+    EXPECT_EQ(source->m_reads.load(), 4u);
+
+    auto const statistics = cache->statistics();
+    EXPECT_EQ(statistics.m_misses, 4u);
+    EXPECT_EQ(statistics.m_hits, 996u);
+    EXPECT_EQ(statistics.m_evictions, 0u);
+}
+
+TEST(block_buffer, reads_span_blocks_and_stop_at_the_end)
+{
+    auto const size   = 3 * block_size + 123;
+    auto const source = std::make_shared<counting_source>(size);
+    auto const cache  = m::block_buffer::make_block_buffer(source, {.m_read_ahead = 0});
+
+    EXPECT_TRUE(read_matches(*cache, *source, block_size - 10, 2 * block_size + 20));
+    EXPECT_TRUE(read_matches(*cache, *source, size - 50, 1000));
+    EXPECT_TRUE(read_matches(*cache, *source, size, 10));
+    EXPECT_TRUE(read_matches(*cache, *source, size + block_size, 10));
+}
+
+TEST(block_buffer, eviction)
+{
+    auto const source = std::make_shared<counting_source>(16 * block_size);
+    auto const cache  = m::block_buffer::make_block_buffer(
+        source, {.m_buffer_count = 4, .m_read_ahead = 0});
+
+    for (std::size_t i = 0; i < 16; i++)
+        ASSERT_TRUE(read_matches(*cache, *source, i * block_size + 5, 100));
+
+    EXPECT_EQ(cache->statistics().m_evictions, 12u);
+
+    // The last blocks read are still there
+    auto const reads = source->m_reads.load();
+    ASSERT_TRUE(read_matches(*cache, *source, 15 * block_size, 100));
+    EXPECT_EQ(source->m_reads.load(), reads);
+
+    // and the first are long gone
+    ASSERT_TRUE(read_matches(*cache, *source, 0, 100));
+    EXPECT_EQ(source->m_reads.load(), reads + 1);
+}
+
+TEST(block_buffer, sequential_reads_are_read_ahead)
+{
+    // The last block is a short one
+    auto const blocks = std::size_t{33};
+    auto const size   = (blocks - 1) * block_size + 100;
+    auto const source = std::make_shared<counting_source>(size);
+    auto const cache  = m::block_buffer::make_block_buffer(
+        source, {.m_buffer_count = 16, .m_read_ahead = 4});
+
+    for (std::size_t p = 0; p < size; p += 4096)
+        ASSERT_TRUE(read_matches(*cache, *source, p, 4096));
+
+    auto const statistics = cache->statistics();
+
+    EXPECT_GT(statistics.m_read_ahead, 0u);
+    EXPECT_GT(statistics.m_read_ahead_hits, 0u);
+    EXPECT_EQ(statistics.m_misses + statistics.m_read_ahead, blocks);
+
+    // Read-ahead goes no further than the short block
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(source->m_reads.load(), blocks);
+}
+
+TEST(block_buffer, concurrent_readers)
+{
+    auto const source = std::make_shared<counting_source>(64 * block_size);
+    auto const cache  = m::block_buffer::make_block_buffer(source, {.m_buffer_count = 8});
+
+    std::atomic<std::size_t> mismatches{};
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&, t]() {
+            for (std::size_t i = 0; i < 2000; i++)
+            {
+                auto const position = (t * 104729 + i * 15485863) % (64 * block_size);
+
+                if (!read_matches(*cache, *source, position, 1 + i % 3000))
+                    mismatches++;
+            }
+        });
+    }
+
+    for (auto& t: threads)
+        t.join();
+
+    EXPECT_EQ(mismatches.load(), 0u);
+}
+
+TEST(block_buffer, errors_are_not_cached)
+{
+    auto const source = std::make_shared<counting_source>(2 * block_size);
+    auto const cache  = m::block_buffer::make_block_buffer(source, {.m_read_ahead = 0});
+
+    std::vector<std::byte> buffer(10);
+
+    source->m_fail = true;
+    EXPECT_THROW((void)cache->read(m::io::position_t{0}, std::span(buffer)), std::system_error);
+
+    source->m_fail = false;
+    EXPECT_TRUE(read_matches(*cache, *source, 0, 10));
+}
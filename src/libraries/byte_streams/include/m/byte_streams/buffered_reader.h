@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include <m/byte_streams/byte_streams.h>
+
+namespace m
+{
+    namespace byte_streams
+    {
+        //
+        // Reads a sequential stream a large chunk at a time into one
+        // contiguous, cache line aligned buffer and lets a parser look at
+        // the bytes in place. The loop over the input works on the spans
+        // from peek and read_until, such as handing them straight to
+        // utf::decode_utf8, and calls back into the source only when the
+        // buffer runs dry.
+        //
+        // Spans returned stay valid until the next call that may refill
+        // the buffer: peek, read_until or read. consume only moves past
+        // bytes and never invalidates them.
+        //
+        // Is itself a seq_in, so that it can stand in for its source, and
+        // like its source is for one reader at a time.
+        //
+        class buffered_reader : public seq_in
+        {
+        public:
+            constexpr static inline std::size_t default_capacity = 64 * 1024;
+
+            buffered_reader(std::shared_ptr<seq_in> source,
+                            std::size_t             capacity = default_capacity);
+            buffered_reader(buffered_reader const&) = delete;
+            buffered_reader(buffered_reader&&)      = default;
+            virtual ~buffered_reader()              = default;
+
+            void
+            operator=(buffered_reader const&) = delete;
+
+            buffered_reader&
+            operator=(buffered_reader&&) = default;
+
+            /// <summary>
+            /// The next `n` bytes without consuming them, refilling first if fewer are
+            /// buffered. Fewer than `n` bytes are returned only at the end of the stream. The
+            /// buffer grows if `n` is larger than it.
+            /// </summary>
+            std::span<std::byte const>
+            peek(std::size_t n);
+
+            /// <summary>
+            /// Whatever is already buffered, without reading the source.
+            /// </summary>
+            std::span<std::byte const>
+            buffered() const noexcept
+            {
+                return {buffer_data() + m_begin, m_end - m_begin};
+            }
+
+            /// <summary>
+            /// Moves past `n` buffered bytes. Throws std::out_of_range if fewer than `n` are
+            /// buffered; peek them first.
+            /// </summary>
+            void
+            consume(std::size_t n);
+
+            /// <summary>
+            /// Consumes and returns the bytes up to and including the next `delimiter`, or up
+            /// to the end of the stream if there is none. An empty span means the end of the
+            /// stream. The buffer grows to hold a run longer than it.
+            /// </summary>
+            std::span<std::byte const>
+            read_until(std::byte delimiter);
+
+            /// <summary>
+            /// True once everything has been consumed and the source has nothing more.
+            /// </summary>
+            bool
+            at_end()
+            {
+                return peek(1).empty();
+            }
+
+        protected:
+            // byte_streams::seq_in
+            std::size_t
+            do_read(std::span<std::byte>& span) override;
+
+        private:
+            struct alignas(64) chunk
+            {
+                std::byte m_bytes[64];
+            };
+
+            std::byte*
+            buffer_data() const noexcept
+            {
+                return m_buffer[0].m_bytes;
+            }
+
+            //
+            // Reads until at least `n` bytes are buffered or the source
+            // ends, moving the buffered bytes to the front and growing the
+            // buffer as needed.
+            //
+            void
+            fill(std::size_t n);
+
+            std::shared_ptr<seq_in>  m_source;
+            std::unique_ptr<chunk[]> m_buffer;
+            std::size_t              m_capacity{};
+            std::size_t              m_begin{}; // First unconsumed byte
+            std::size_t              m_end{};   // One past the last buffered byte
+            bool                     m_source_done{};
+        };
+
+        /// <summary>
+        /// Creates a buffered_reader over `source`.
+        /// </summary>
+        std::shared_ptr<buffered_reader>
+        make_buffered_reader(std::shared_ptr<seq_in> source,
+                             std::size_t             capacity = buffered_reader::default_capacity);
+    } // namespace byte_streams
+} // namespace m
@@ -3,10 +3,14 @@
 
 #pragma once
 
+#include <coroutine>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <span>
 #include <stdexcept>
+#include <system_error>
 
 #include <m/io/units.h>
 
@@ -62,6 +66,17 @@ namespace m
             do_read(std::span<std::byte>& span) = 0;
         };
 
+        /// <summary>
+        /// One read of a batch handed to ra_in::read_many.
+        /// </summary>
+        struct read_request
+        {
+            using position_t = m::io::position_t;
+
+            position_t           m_position;
+            std::span<std::byte> m_buffer; // Trimmed to the bytes read
+        };
+
         class ra_in
         {
         public:
@@ -93,9 +108,191 @@ namespace m
                     throw std::runtime_error("end of file");
             }
 
+            /// <summary>
+            /// Performs every read of `requests`, each as `read` would and each buffer trimmed
+            /// to the bytes read into it, in whatever order and with as few underlying reads
+            /// as the stream can manage. Streams over files merge requests for adjacent
+            /// ranges, so a caller gathering many small fields should hand them over
+            /// together rather than one at a time.
+            /// </summary>
+            void
+            read_many(std::span<read_request> requests)
+            {
+                do_read_many(requests);
+            }
+
         protected:
             virtual size_t
             do_read(position_t position, std::span<std::byte>& s) = 0;
+
+            virtual void
+            do_read_many(std::span<read_request> requests)
+            {
+                for (auto& r: requests)
+                    do_read(r.m_position, r.m_buffer);
+            }
+        };
+
+        /// <summary>
+        /// Bytes lent out by an ra_view_in. `m_bytes` stays valid for as long as `m_guard`, or a
+        /// copy of it, is held, even once the stream itself is gone.
+        /// </summary>
+        struct ra_view
+        {
+            std::span<std::byte const>  m_bytes;
+            std::shared_ptr<void const> m_guard;
+        };
+
+        /// <summary>
+        /// Optional capability of a random access stream whose bytes already sit in memory: it
+        /// lends them out in place instead of copying them into the caller's span. Streams that
+        /// have it derive from it alongside ra_in, so a consumer holding only an ra_in finds it
+        /// with `dynamic_cast`, once rather than for every read.
+        /// </summary>
+        class ra_view_in
+        {
+        public:
+            using position_t = m::io::position_t;
+
+            /// <summary>
+            /// The `size` bytes at `position`, fewer if the end of the stream comes first and
+            /// none at all past it. Valid only for as long as the stream is, which costs nothing
+            /// to ensure on a hot path where the caller holds the stream anyway.
+            /// </summary>
+            std::span<std::byte const>
+            borrow(position_t position, std::size_t size)
+            {
+                return do_borrow(position, size);
+            }
+
+            /// <summary>
+            /// The same bytes as `borrow`, with a guard that keeps them valid on its own.
+            /// </summary>
+            ra_view
+            view(position_t position, std::size_t size)
+            {
+                return ra_view{do_borrow(position, size), do_guard()};
+            }
+
+        protected:
+            virtual std::span<std::byte const>
+            do_borrow(position_t position, std::size_t size) = 0;
+
+            virtual std::shared_ptr<void const>
+            do_guard() = 0;
+        };
+
+        /// <summary>
+        /// One read of a batch handed to async_ra_in::read_async.
+        /// </summary>
+        struct async_read
+        {
+            using position_t = m::io::position_t;
+
+            //
+            // Called once the read is over with the error, if it failed, and
+            // otherwise with the buffer trimmed to the bytes read.
+            //
+            using completion_t =
+                std::move_only_function<void(std::error_code, std::span<std::byte>)>;
+
+            position_t           m_position;
+            std::span<std::byte> m_buffer;
+            completion_t         m_completion;
+        };
+
+        class async_ra_in
+        {
+        public:
+            using position_t   = m::io::position_t;
+            using completion_t = async_read::completion_t;
+
+            /// <summary>
+            /// Starts reading `s.size()` bytes at `position` and returns without waiting for
+            /// them. `f` is later called on a threadpool thread with the error, if the read
+            /// failed, and otherwise with `s` trimmed to the number of bytes read; fewer bytes
+            /// than asked for means the end of the stream was reached. `s` must stay valid
+            /// until then.
+            ///
+            /// Errors in starting the read are indicated by exceptions, in which case `f` is
+            /// not called.
+            /// </summary>
+            template <typename F>
+            void
+            read_async(position_t position, std::span<std::byte> s, F&& f)
+            {
+                async_read r{position, s, completion_t(std::forward<F>(f))};
+                do_read_async(std::span(&r, 1));
+            }
+
+            /// <summary>
+            /// Starts all the reads of `batch`, handing them to the platform together where it
+            /// allows that. The completions are moved out of `batch` before this returns and
+            /// may run in any order.
+            /// </summary>
+            void
+            read_async(std::span<async_read> batch)
+            {
+                do_read_async(batch);
+            }
+
+            class read_awaiter
+            {
+            public:
+                read_awaiter(async_ra_in& stream, position_t position, std::span<std::byte> s):
+                    m_stream(stream), m_position(position), m_buffer(s)
+                {}
+
+                bool
+                await_ready() noexcept
+                {
+                    return m_buffer.empty();
+                }
+
+                void
+                await_suspend(std::coroutine_handle<> awaiting)
+                {
+                    m_stream.read_async(
+                        m_position,
+                        m_buffer,
+                        [this, awaiting](std::error_code ec, std::span<std::byte> s) {
+                            m_error  = ec;
+                            m_buffer = s;
+                            awaiting.resume();
+                        });
+                }
+
+                std::size_t
+                await_resume()
+                {
+                    if (m_error)
+                        throw std::system_error(m_error, "read_async");
+
+                    return m_buffer.size();
+                }
+
+            private:
+                async_ra_in&         m_stream;
+                position_t           m_position;
+                std::span<std::byte> m_buffer;
+                std::error_code      m_error;
+            };
+
+            /// <summary>
+            /// `co_await stream.read_async(position, s)` reads like the callback form and
+            /// resumes the awaiting coroutine on a threadpool thread with the number of bytes
+            /// read. Errors are thrown as std::system_error.
+            /// </summary>
+            [[nodiscard]]
+            read_awaiter
+            read_async(position_t position, std::span<std::byte> s)
+            {
+                return read_awaiter(*this, position, s);
+            }
+
+        protected:
+            virtual void
+            do_read_async(std::span<async_read> batch) = 0;
         };
 
         class seekable
@@ -0,0 +1,73 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include <m/byte_streams/byte_streams.h>
+#include <m/io/units.h>
+
+namespace m
+{
+    namespace byte_streams
+    {
+        //
+        // A sequential, seekable reader over a random access stream that
+        // keeps its own position. Any number of cursors can share one
+        // source, each reading through it at its own pace; the source is
+        // only ever read at explicit positions, so cursors take no locks
+        // and do not disturb one another.
+        //
+        // A cursor itself is not for sharing between threads: make one per
+        // reader, they are cheap.
+        //
+        class cursor : public seq_in, public seekable
+        {
+        public:
+            cursor(std::shared_ptr<ra_in> source, position_t position = {});
+            cursor(cursor const&) = default;
+            cursor(cursor&&)      = default;
+            virtual ~cursor()     = default;
+
+            cursor&
+            operator=(cursor const&) = default;
+
+            cursor&
+            operator=(cursor&&) = default;
+
+            std::shared_ptr<ra_in> const&
+            source() const noexcept
+            {
+                return m_source;
+            }
+
+        protected:
+            // byte_streams::seq_in
+            std::size_t
+            do_read(std::span<std::byte>& span) override;
+
+            // byte_streams::seekable
+            void
+            do_seek(position_t p) override;
+
+            void
+            do_seek(offset_t o) override;
+
+            position_t
+            do_tell() override;
+
+        private:
+            std::shared_ptr<ra_in> m_source;
+            position_t             m_position;
+        };
+
+        /// <summary>
+        /// Creates a cursor reading `source` from `position` onwards.
+        /// </summary>
+        std::shared_ptr<cursor>
+        make_cursor(std::shared_ptr<ra_in> source, io::position_t position = {});
+    } // namespace byte_streams
+} // namespace m
@@ -6,6 +6,8 @@
 #include <algorithm>
 #include <cstddef>
 #include <memory>
+#include <span>
+#include <vector>
 
 #include <m/byte_streams/byte_streams.h>
 
@@ -13,7 +15,15 @@ namespace m
 {
     namespace byte_streams
     {
-        class memory_based_byte_stream : public ra_in, public seq_in
+        //
+        // Lends its bytes out through ra_view_in; a view's guard keeps the
+        // underlying array alive on its own.
+        //
+        // The stream's own seq_in position is one for all threads and is
+        // updated under a lock. Threads that each read through the bytes
+        // should each take a cursor over the stream instead.
+        //
+        class memory_based_byte_stream : public ra_in, public seq_in, public ra_view_in
         {
             // Nothing more for the interface
         };
@@ -21,6 +31,30 @@ namespace m
         std::shared_ptr<memory_based_byte_stream>
         construct_memory_based_byte_stream(std::unique_ptr<std::byte[]>&& array, size_t count);
 
+        //
+        // Adopts `bytes` without copying them; the vector's buffer is moved
+        // into the stream. Suits the result of filesystem::load.
+        //
+        std::shared_ptr<memory_based_byte_stream>
+        make_memory_based_byte_stream(std::vector<std::byte>&& bytes);
+
+        //
+        // Shares ownership of the first `count` bytes of `array` without
+        // copying them. The array may also be an aliasing shared_ptr into
+        // something bigger, such as a file mapping.
+        //
+        std::shared_ptr<memory_based_byte_stream>
+        make_memory_based_byte_stream(std::shared_ptr<std::byte const[]> array, std::size_t count);
+
+        //
+        // Reads `bytes` in place without copying or owning them. The caller
+        // keeps them alive, and unchanged, for as long as the stream or any
+        // span borrowed from it is used; views lent out carry an empty
+        // guard.
+        //
+        std::shared_ptr<memory_based_byte_stream>
+        make_borrowing_memory_based_byte_stream(std::span<std::byte const> bytes);
+
         // Constructs a random access and sequential capable byte stream over
         // a span of bytes. Copies the span in.
         //
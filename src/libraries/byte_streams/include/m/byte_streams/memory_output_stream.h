@@ -0,0 +1,148 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <m/byte_streams/byte_streams.h>
+#include <m/io/units.h>
+
+namespace m
+{
+    namespace byte_streams
+    {
+        //
+        // What a memory_output_stream hands over on release: the bytes
+        // still in the chunks they were written into, with reads copying
+        // out across the chunk boundaries. Not an ra_view_in, as a span
+        // lent out could not run on from one chunk into the next.
+        //
+        // As with memory_based_byte_stream, the seq_in position is one for
+        // all threads; threads that each read through the bytes should each
+        // take a cursor.
+        //
+        class memory_chunks_byte_stream : public ra_in, public seq_in
+        {
+            // Nothing more for the interface
+        };
+
+        //
+        // An output stream that collects what is written in memory, in a
+        // list of large chunks of equal size: a rope. Growing it allocates
+        // another chunk and never moves what is already there, and a write
+        // at any position finds its chunk by division.
+        //
+        // Writes past the end leave zeros in the gap, as a file would.
+        //
+        // The contents go on as they are, without being copied: chunks()
+        // lends them out ready for one gathering write to a file
+        // (filesystem::buffered_output_file::gather_write), and release()
+        // turns them into an input stream.
+        //
+        // Like the other byte streams it is for one writer at a time, but
+        // unlike the file streams it takes no lock.
+        //
+        class memory_output_stream : public seq_out, public ra_out, public seekable
+        {
+        public:
+            using position_t = m::io::position_t;
+            using offset_t   = m::io::offset_t;
+
+            constexpr static inline std::size_t default_chunk_size = 1024 * 1024;
+
+            explicit memory_output_stream(std::size_t chunk_size = default_chunk_size);
+            memory_output_stream(memory_output_stream const&) = delete;
+            memory_output_stream(memory_output_stream&&)      = default;
+            virtual ~memory_output_stream()                   = default;
+
+            void
+            operator=(memory_output_stream const&) = delete;
+
+            memory_output_stream&
+            operator=(memory_output_stream&&) = default;
+
+            /// <summary>
+            /// The number of bytes written, up to the furthest position written to.
+            /// </summary>
+            std::uint64_t
+            size() const noexcept
+            {
+                return m_size;
+            }
+
+            /// <summary>
+            /// The bytes written so far, a span for each chunk in order. The spans stay
+            /// valid until the next write or release.
+            /// </summary>
+            std::vector<std::span<std::byte const>>
+            chunks() const;
+
+            /// <summary>
+            /// Hands the chunks over as an input stream, without copying them, and leaves
+            /// this one empty.
+            /// </summary>
+            std::shared_ptr<memory_chunks_byte_stream>
+            release();
+
+            /// <summary>
+            /// Makes the first chunk at least `size` bytes, so that that much is written
+            /// into one contiguous block. Only before anything is written.
+            /// </summary>
+            void
+            reserve(std::size_t size);
+
+        protected:
+            // byte_streams::seq_out
+            void
+            do_write(std::span<std::byte const> s) override;
+
+            // byte_streams::ra_out
+            void
+            do_write(position_t position, std::span<std::byte const> s) override;
+
+            // byte_streams::seekable
+            void
+            do_seek(position_t p) override;
+
+            void
+            do_seek(offset_t o) override;
+
+            position_t
+            do_tell() override;
+
+        private:
+            void
+            write_at(std::uint64_t position, std::span<std::byte const> s);
+
+            //
+            // Copies `count` bytes from `from` to `position` onwards, or
+            // zeros them when `from` is null, crossing chunks as it goes.
+            // The chunks must already be there.
+            //
+            void
+            copy_to(std::uint64_t position, std::byte const* from, std::uint64_t count);
+
+            // The chunk holding `position`, and the offset into it
+            std::pair<std::size_t, std::size_t>
+            locate(std::uint64_t position) const noexcept;
+
+            std::size_t
+            chunk_size(std::size_t index) const noexcept
+            {
+                return index == 0 ? m_first_chunk_size : m_chunk_size;
+            }
+
+            std::size_t                               m_chunk_size;
+            std::size_t                               m_first_chunk_size;
+            std::vector<std::unique_ptr<std::byte[]>> m_chunks;
+            std::uint64_t                             m_size{};
+            std::uint64_t                             m_position{};
+        };
+    } // namespace byte_streams
+} // namespace m
@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include <m/byte_streams/buffered_reader.h>
+
+namespace
+{
+    constexpr std::size_t
+    round_up_to_chunk(std::size_t n) noexcept
+    {
+        return (n + 63) & ~std::size_t{63};
+    }
+} // namespace
+
+m::byte_streams::buffered_reader::buffered_reader(std::shared_ptr<seq_in> source,
+                                                  std::size_t             capacity):
+    m_source(std::move(source)), m_capacity(round_up_to_chunk((std::max)(capacity, std::size_t{1})))
+{
+    if (!m_source)
+        throw std::invalid_argument("buffered_reader needs a source");
+
+    m_buffer = std::make_unique_for_overwrite<chunk[]>(m_capacity / sizeof(chunk));
+}
+
+std::span<std::byte const>
+m::byte_streams::buffered_reader::peek(std::size_t n)
+{
+    if (m_end - m_begin < n)
+        fill(n);
+
+    auto const bytes = buffered();
+    return bytes.first((std::min)(n, bytes.size()));
+}
+
+void
+m::byte_streams::buffered_reader::consume(std::size_t n)
+{
+    if (n > m_end - m_begin)
+        throw std::out_of_range("consume past the buffered bytes");
+
+    m_begin += n;
+}
+
+std::span<std::byte const>
+m::byte_streams::buffered_reader::read_until(std::byte delimiter)
+{
+    std::size_t scanned = 0;
+
+    for (;;)
+    {
+        auto const bytes = buffered();
+        auto const rest  = bytes.subspan(scanned);
+
+        if (auto const p = std::memchr(rest.data(), std::to_integer<int>(delimiter), rest.size()))
+        {
+            auto const found = static_cast<std::byte const*>(p);
+            auto const n     = static_cast<std::size_t>(found - bytes.data()) + 1;
+            m_begin += n;
+            return bytes.first(n);
+        }
+
+        if (m_source_done)
+        {
+            m_begin = m_end;
+            return bytes;
+        }
+
+        scanned = bytes.size();
+        fill(bytes.size() + 1);
+    }
+}
+
+std::size_t
+m::byte_streams::buffered_reader::do_read(std::span<std::byte>& span)
+{
+    auto const from_buffer = [&](std::span<std::byte> to) {
+        auto const bytes = buffered();
+        auto const count = (std::min)(bytes.size(), to.size());
+        std::memcpy(to.data(), bytes.data(), count);
+        m_begin += count;
+        return count;
+    };
+
+    auto copied = from_buffer(span);
+    auto rest   = span.subspan(copied);
+
+    if (!rest.empty() && !m_source_done)
+    {
+        //
+        // Reads at least as big as the buffer gain nothing from going
+        // through it and go straight to the source.
+        //
+        if (rest.size() >= m_capacity)
+        {
+            auto const wanted = rest.size();
+            auto const got    = m_source->read(rest);
+
+            if (got < wanted)
+                m_source_done = true;
+
+            copied += got;
+        }
+        else
+        {
+            fill(rest.size());
+            copied += from_buffer(rest);
+        }
+    }
+
+    span = span.first(copied);
+    return copied;
+}
+
+void
+m::byte_streams::buffered_reader::fill(std::size_t n)
+{
+    auto const buffered_count = m_end - m_begin;
+
+    if (n > m_capacity)
+    {
+        auto const capacity = round_up_to_chunk((std::max)(n, m_capacity * 2));
+        auto       buffer   = std::make_unique_for_overwrite<chunk[]>(capacity / sizeof(chunk));
+
+        std::memcpy(buffer[0].m_bytes, buffer_data() + m_begin, buffered_count);
+
+        m_buffer   = std::move(buffer);
+        m_capacity = capacity;
+    }
+    else if (m_begin != 0)
+    {
+        std::memmove(buffer_data(), buffer_data() + m_begin, buffered_count);
+    }
+
+    m_begin = 0;
+    m_end   = buffered_count;
+
+    while (m_end < n && !m_source_done)
+    {
+        //
+        // Always ask for all the room there is, so that a parser peeking
+        // a few bytes at a time still reads the source in big chunks.
+        //
+        auto       tail   = std::span<std::byte>(buffer_data() + m_end, m_capacity - m_end);
+        auto const wanted = tail.size();
+        auto const got    = m_source->read(tail);
+
+        if (got < wanted)
+            m_source_done = true;
+
+        m_end += got;
+    }
+}
+
+std::shared_ptr<m::byte_streams::buffered_reader>
+m::byte_streams::make_buffered_reader(std::shared_ptr<seq_in> source, std::size_t capacity)
+{
+    return std::make_shared<buffered_reader>(std::move(source), capacity);
+}
@@ -3,6 +3,9 @@
 
 #include <cstddef>
 #include <memory>
+#include <span>
+#include <utility>
+#include <vector>
 
 #include <m/byte_streams/byte_streams.h>
 
@@ -13,5 +16,36 @@
 std::shared_ptr<m::byte_streams::memory_based_byte_stream>
 m::byte_streams::construct_memory_based_byte_stream(std::unique_ptr<std::byte[]>&& array, size_t count)
 {
-    return std::make_shared<m::byte_streams_impl::memory_ro_ra_seq>(std::move(array), count);
+    auto owner = std::shared_ptr<std::byte const[]>(std::move(array));
+    auto span  = std::span<std::byte const>(owner.get(), count);
+
+    return std::make_shared<m::byte_streams_impl::memory_ro_ra_seq>(std::move(owner), span);
+}
+
+std::shared_ptr<m::byte_streams::memory_based_byte_stream>
+m::byte_streams::make_memory_based_byte_stream(std::vector<std::byte>&& bytes)
+{
+    //
+    // Moving the vector into the control block takes its buffer over
+    // without touching the bytes.
+    //
+    auto owner = std::make_shared<std::vector<std::byte> const>(std::move(bytes));
+    auto span  = std::span<std::byte const>(*owner);
+
+    return std::make_shared<m::byte_streams_impl::memory_ro_ra_seq>(std::move(owner), span);
+}
+
+std::shared_ptr<m::byte_streams::memory_based_byte_stream>
+m::byte_streams::make_memory_based_byte_stream(std::shared_ptr<std::byte const[]> array,
+                                               std::size_t                        count)
+{
+    auto span = std::span<std::byte const>(array.get(), count);
+
+    return std::make_shared<m::byte_streams_impl::memory_ro_ra_seq>(std::move(array), span);
+}
+
+std::shared_ptr<m::byte_streams::memory_based_byte_stream>
+m::byte_streams::make_borrowing_memory_based_byte_stream(std::span<std::byte const> bytes)
+{
+    return std::make_shared<m::byte_streams_impl::memory_ro_ra_seq>(nullptr, bytes);
 }
@@ -0,0 +1,55 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include <m/byte_streams/cursor.h>
+
+m::byte_streams::cursor::cursor(std::shared_ptr<ra_in> source, position_t position):
+    m_source(std::move(source)), m_position(position)
+{
+    if (!m_source)
+        throw std::invalid_argument("cursor needs a source");
+}
+
+std::size_t
+m::byte_streams::cursor::do_read(std::span<std::byte>& span)
+{
+    auto const size = m_source->read(m_position, span);
+    m_position      = m_position + size;
+
+    return size;
+}
+
+void
+m::byte_streams::cursor::do_seek(position_t p)
+{
+    m_position = p;
+}
+
+void
+m::byte_streams::cursor::do_seek(offset_t o)
+{
+    auto const current = std::to_underlying(m_position);
+    auto const offset  = std::to_underlying(o);
+
+    if (offset < 0 && static_cast<std::uint64_t>(-(offset + 1)) >= current)
+        throw std::runtime_error("seek before the start of the stream");
+
+    m_position = position_t{current + static_cast<std::uint64_t>(offset)};
+}
+
+m::byte_streams::cursor::position_t
+m::byte_streams::cursor::do_tell()
+{
+    return m_position;
+}
+
+std::shared_ptr<m::byte_streams::cursor>
+m::byte_streams::make_cursor(std::shared_ptr<ra_in> source, io::position_t position)
+{
+    return std::make_shared<cursor>(std::move(source), position);
+}
@@ -0,0 +1,166 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include <m/byte_streams/memory_output_stream.h>
+
+#include "memory_stream.h"
+
+m::byte_streams::memory_output_stream::memory_output_stream(std::size_t chunk_size):
+    m_chunk_size((std::max)(chunk_size, std::size_t{1})), m_first_chunk_size(m_chunk_size)
+{}
+
+std::vector<std::span<std::byte const>>
+m::byte_streams::memory_output_stream::chunks() const
+{
+    std::vector<std::span<std::byte const>> v;
+    v.reserve(m_chunks.size());
+
+    auto left = m_size;
+
+    for (std::size_t i = 0; i < m_chunks.size() && left != 0; i++)
+    {
+        auto const n = static_cast<std::size_t>((std::min)(std::uint64_t{chunk_size(i)}, left));
+
+        v.emplace_back(m_chunks[i].get(), n);
+        left -= n;
+    }
+
+    return v;
+}
+
+std::shared_ptr<m::byte_streams::memory_chunks_byte_stream>
+m::byte_streams::memory_output_stream::release()
+{
+    auto stream = std::make_shared<m::byte_streams_impl::memory_ro_ra_seq_chunks>(
+        std::move(m_chunks), m_first_chunk_size, m_chunk_size, m_size);
+
+    m_chunks.clear();
+    m_size             = 0;
+    m_position         = 0;
+    m_first_chunk_size = m_chunk_size;
+
+    return stream;
+}
+
+void
+m::byte_streams::memory_output_stream::reserve(std::size_t size)
+{
+    if (!m_chunks.empty())
+        throw std::logic_error("memory_output_stream::reserve after writing");
+
+    m_first_chunk_size = (std::max)(size, m_chunk_size);
+}
+
+// byte_streams::seq_out
+void
+m::byte_streams::memory_output_stream::do_write(std::span<std::byte const> s)
+{
+    write_at(m_position, s);
+    m_position += s.size();
+}
+
+// byte_streams::ra_out
+void
+m::byte_streams::memory_output_stream::do_write(position_t position, std::span<std::byte const> s)
+{
+    write_at(std::to_underlying(position), s);
+}
+
+void
+m::byte_streams::memory_output_stream::do_seek(position_t p)
+{
+    m_position = std::to_underlying(p);
+}
+
+void
+m::byte_streams::memory_output_stream::do_seek(offset_t o)
+{
+    auto const offset = std::to_underlying(o);
+
+    if (offset < 0 && static_cast<std::uint64_t>(-(offset + 1)) >= m_position)
+        throw std::runtime_error("seek before the start of the stream");
+
+    m_position += static_cast<std::uint64_t>(offset);
+}
+
+m::byte_streams::memory_output_stream::position_t
+m::byte_streams::memory_output_stream::do_tell()
+{
+    return position_t{m_position};
+}
+
+void
+m::byte_streams::memory_output_stream::write_at(std::uint64_t              position,
+                                                std::span<std::byte const> s)
+{
+    if (s.empty())
+        return;
+
+    auto const end = position + s.size();
+
+    if (end < position)
+        throw std::overflow_error("memory_output_stream write past the end of addressable memory");
+
+    // Chunks are allocated without being cleared; any gap is zeroed below
+    auto const last = locate(end - 1).first;
+
+    while (m_chunks.size() <= last)
+    {
+        auto const size = chunk_size(m_chunks.size());
+        m_chunks.push_back(std::make_unique_for_overwrite<std::byte[]>(size));
+    }
+
+    if (position > m_size)
+        copy_to(m_size, nullptr, position - m_size);
+
+    copy_to(position, s.data(), s.size());
+
+    m_size = (std::max)(m_size, end);
+}
+
+void
+m::byte_streams::memory_output_stream::copy_to(std::uint64_t    position,
+                                               std::byte const* from,
+                                               std::uint64_t    count)
+{
+    auto [index, offset] = locate(position);
+
+    while (count != 0)
+    {
+        auto const room = std::uint64_t{chunk_size(index) - offset};
+        auto const n    = static_cast<std::size_t>((std::min)(count, room));
+        auto const to   = m_chunks[index].get() + offset;
+
+        if (from)
+        {
+            std::memcpy(to, from, n);
+            from += n;
+        }
+        else
+        {
+            std::memset(to, 0, n);
+        }
+
+        count -= n;
+        index++;
+        offset = 0;
+    }
+}
+
+std::pair<std::size_t, std::size_t>
+m::byte_streams::memory_output_stream::locate(std::uint64_t position) const noexcept
+{
+    if (position < m_first_chunk_size)
+        return {0, static_cast<std::size_t>(position)};
+
+    auto const rest = position - m_first_chunk_size;
+
+    return {static_cast<std::size_t>(1 + rest / m_chunk_size),
+            static_cast<std::size_t>(rest % m_chunk_size)};
+}
@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <utility>
@@ -10,13 +11,10 @@
 
 #include "memory_stream.h"
 
-m::byte_streams_impl::memory_ro_ra_seq::memory_ro_ra_seq(std::unique_ptr<std::byte[]>&& array,
-                                                         size_t                         count):
-    m_array(std::move(array)), m_current_position{}
-{
-    m_span = std::span<std::byte>(m_array.get(), count);
-    //
-}
+m::byte_streams_impl::memory_ro_ra_seq::memory_ro_ra_seq(std::shared_ptr<void const> owner,
+                                                         std::span<std::byte const>  span):
+    m_owner(std::move(owner)), m_current_position{}, m_span(span)
+{}
 
 std::size_t
 m::byte_streams_impl::memory_ro_ra_seq::do_read(std::span<std::byte>& span)
@@ -45,6 +43,23 @@ m::byte_streams_impl::memory_ro_ra_seq::do_read(std::span<std::byte>& span)
     return size;
 }
 
+std::span<std::byte const>
+m::byte_streams_impl::memory_ro_ra_seq::do_borrow(io::position_t p, std::size_t size)
+{
+    if (p >= m_span.size())
+        return {};
+
+    auto const start = m::to<std::size_t>(std::to_underlying(p));
+
+    return m_span.subspan(start, (std::min)(size, m_span.size() - start));
+}
+
+std::shared_ptr<void const>
+m::byte_streams_impl::memory_ro_ra_seq::do_guard()
+{
+    return m_owner;
+}
+
 std::size_t
 m::byte_streams_impl::memory_ro_ra_seq::do_read(io::position_t p, std::span<std::byte>& span)
 {
@@ -74,3 +89,77 @@ m::byte_streams_impl::memory_ro_ra_seq::do_read(io::position_t p, std::span<std:
 
     return size;
 }
+
+m::byte_streams_impl::memory_ro_ra_seq_chunks::memory_ro_ra_seq_chunks(
+    std::vector<std::unique_ptr<std::byte[]>>&& chunks,
+    std::size_t                                 first_chunk_size,
+    std::size_t                                 chunk_size,
+    std::uint64_t                               size):
+    m_chunks(std::move(chunks)),
+    m_first_chunk_size(first_chunk_size),
+    m_chunk_size(chunk_size),
+    m_size(size)
+{}
+
+std::size_t
+m::byte_streams_impl::memory_ro_ra_seq_chunks::do_read(std::span<std::byte>& span)
+{
+    auto const l = std::unique_lock(m_mutex);
+
+    auto const size = read_at(m_current_position, span);
+    m_current_position += size;
+
+    return size;
+}
+
+std::size_t
+m::byte_streams_impl::memory_ro_ra_seq_chunks::do_read(io::position_t p, std::span<std::byte>& span)
+{
+    // The chunks never change, so random access needs no lock either
+    return read_at(std::to_underlying(p), span);
+}
+
+std::size_t
+m::byte_streams_impl::memory_ro_ra_seq_chunks::read_at(std::uint64_t         position,
+                                                       std::span<std::byte>& span) const
+{
+    if (position >= m_size)
+    {
+        span = span.first(0);
+        return 0;
+    }
+
+    auto const size =
+        static_cast<std::size_t>((std::min)(std::uint64_t{span.size()}, m_size - position));
+
+    auto [index, offset] = locate(position);
+    auto to              = span.data();
+    auto left            = size;
+
+    while (left != 0)
+    {
+        auto const room = (index == 0 ? m_first_chunk_size : m_chunk_size) - offset;
+        auto const n    = (std::min)(left, room);
+
+        to = std::copy_n(m_chunks[index].get() + offset, n, to);
+
+        left -= n;
+        index++;
+        offset = 0;
+    }
+
+    span = span.first(size);
+    return size;
+}
+
+std::pair<std::size_t, std::size_t>
+m::byte_streams_impl::memory_ro_ra_seq_chunks::locate(std::uint64_t position) const noexcept
+{
+    if (position < m_first_chunk_size)
+        return {0, static_cast<std::size_t>(position)};
+
+    auto const rest = position - m_first_chunk_size;
+
+    return {static_cast<std::size_t>(1 + rest / m_chunk_size),
+            static_cast<std::size_t>(rest % m_chunk_size)};
+}
@@ -3,10 +3,17 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
 
 #include <m/byte_streams/byte_streams.h>
 #include <m/byte_streams/memory_based_byte_streams.h>
+#include <m/byte_streams/memory_output_stream.h>
 #include <m/io/units.h>
 
 namespace m
@@ -21,11 +28,52 @@ namespace m
         class memory_ro_ra_seq : public m::byte_streams::memory_based_byte_stream
         {
         public:
-            // memory_ro_ra_seq(std::span<std::byte const> const&);
-            memory_ro_ra_seq(std::unique_ptr<std::byte[]>&&, size_t count);
+            //
+            // `span` stays valid for as long as `owner` is held. An empty
+            // owner means the caller keeps the bytes alive themselves.
+            //
+            memory_ro_ra_seq(std::shared_ptr<void const> owner, std::span<std::byte const> span);
             memory_ro_ra_seq(memory_ro_ra_seq const&) = delete;
             virtual ~memory_ro_ra_seq()               = default;
 
+        protected:
+            // byte_streams::seq_in
+            std::size_t
+            do_read(std::span<std::byte>& span) override;
+
+            // byte_streams::ra_in
+            std::size_t
+            do_read(io::position_t p, std::span<std::byte>& span) override;
+
+            // byte_streams::ra_view_in
+            std::span<std::byte const>
+            do_borrow(io::position_t p, std::size_t size) override;
+
+            std::shared_ptr<void const>
+            do_guard() override;
+
+        private:
+            std::mutex                  m_mutex;
+            std::shared_ptr<void const> m_owner; // for lifetime management only
+            io::position_t              m_current_position;
+            std::span<std::byte const>  m_span; // always use for access
+        };
+
+        //
+        // The same over the chunks a memory_output_stream wrote into, which
+        // it takes over as they are. Every chunk but the first is
+        // `chunk_size` bytes; the first is `first_chunk_size`.
+        //
+        class memory_ro_ra_seq_chunks : public m::byte_streams::memory_chunks_byte_stream
+        {
+        public:
+            memory_ro_ra_seq_chunks(std::vector<std::unique_ptr<std::byte[]>>&& chunks,
+                                    std::size_t                                 first_chunk_size,
+                                    std::size_t                                 chunk_size,
+                                    std::uint64_t                               size);
+            memory_ro_ra_seq_chunks(memory_ro_ra_seq_chunks const&) = delete;
+            virtual ~memory_ro_ra_seq_chunks()                      = default;
+
         protected:
             // byte_streams::seq_in
             std::size_t
@@ -36,10 +84,19 @@ namespace m
             do_read(io::position_t p, std::span<std::byte>& span) override;
 
         private:
-            std::mutex                   m_mutex;
-            std::unique_ptr<std::byte[]> m_array; // for lifetime management only
-            io::position_t               m_current_position;
-            std::span<std::byte const>   m_span; // always use for access
+            std::size_t
+            read_at(std::uint64_t position, std::span<std::byte>& span) const;
+
+            // The chunk holding `position`, and the offset into it
+            std::pair<std::size_t, std::size_t>
+            locate(std::uint64_t position) const noexcept;
+
+            std::mutex                                m_mutex;
+            std::vector<std::unique_ptr<std::byte[]>> m_chunks;
+            std::size_t                               m_first_chunk_size;
+            std::size_t                               m_chunk_size;
+            std::uint64_t                             m_size;
+            std::uint64_t                             m_current_position{};
         };
     } // namespace byte_streams_impl
 } // namespace m
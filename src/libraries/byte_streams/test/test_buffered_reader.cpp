@@ -0,0 +1,177 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <m/byte_streams/buffered_reader.h>
+#include <m/byte_streams/byte_streams.h>
+#include <m/byte_streams/memory_based_byte_streams.h>
+
+#include "test_bytes.h"
+
+namespace
+{
+    // The smallest buffer there is, so that a few bytes cross a refill
+    constexpr std::size_t capacity = 64;
+
+    std::vector<std::byte>
+    bytes_of(std::string_view s)
+    {
+        auto const b = std::as_bytes(std::span(s));
+        return {b.begin(), b.end()};
+    }
+
+    bool
+    equal(std::span<std::byte const> bytes, std::string_view s)
+    {
+        return std::ranges::equal(bytes, std::as_bytes(std::span(s)));
+    }
+
+    //
+    // A sequential source over `bytes` that counts how often it is read.
+    //
+    class counting_source : public m::byte_streams::seq_in
+    {
+    public:
+        explicit counting_source(std::vector<std::byte> bytes):
+            m_bytes(std::move(bytes)),
+            m_stream(m::byte_streams::make_borrowing_memory_based_byte_stream(m_bytes))
+        {}
+
+        std::size_t m_reads{};
+
+    protected:
+        std::size_t
+        do_read(std::span<std::byte>& span) override
+        {
+            m_reads++;
+            return m_stream->seq_in::read(span);
+        }
+
+    private:
+        std::vector<std::byte>                                     m_bytes;
+        std::shared_ptr<m::byte_streams::memory_based_byte_stream> m_stream;
+    };
+} // namespace
+
+TEST(buffered_reader, needs_a_source)
+{
+    EXPECT_THROW(m::byte_streams::make_buffered_reader(nullptr), std::invalid_argument);
+}
+
+TEST(buffered_reader, peek_past_the_buffer)
+{
+    auto const expected = pattern(1000);
+    auto const source   = std::make_shared<counting_source>(expected);
+    auto const reader   = m::byte_streams::make_buffered_reader(source, capacity);
+
+    // A small peek still fills the whole buffer
+    auto const first = reader->peek(10);
+    EXPECT_TRUE(std::ranges::equal(first, std::span(expected).first(10)));
+    EXPECT_EQ(reader->buffered().size(), capacity);
+    EXPECT_EQ(source->m_reads, 1u);
+
+    // More than the buffer holds grows it, keeping what was buffered
+    auto const more = reader->peek(200);
+    EXPECT_TRUE(std::ranges::equal(more, std::span(expected).first(200)));
+
+    reader->consume(200);
+
+    // Past the end of the stream returns what there is
+    auto const rest = reader->peek(5000);
+    EXPECT_TRUE(std::ranges::equal(rest, std::span(expected).subspan(200)));
+
+    reader->consume(rest.size());
+    EXPECT_TRUE(reader->at_end());
+}
+
+TEST(buffered_reader, consume_across_refills)
+{
+    auto const expected = pattern(1000);
+    auto const source   = std::make_shared<counting_source>(expected);
+    auto const reader   = m::byte_streams::make_buffered_reader(source, capacity);
+
+    std::size_t total{};
+
+    // 7 does not divide 64, so the peeks straddle every refill
+    for (auto bytes = reader->peek(7); !bytes.empty(); bytes = reader->peek(7))
+    {
+        ASSERT_TRUE(std::ranges::equal(bytes, std::span(expected).subspan(total, bytes.size())));
+
+        reader->consume(bytes.size());
+        total += bytes.size();
+    }
+
+    EXPECT_EQ(total, expected.size());
+    EXPECT_GE(source->m_reads, expected.size() / capacity);
+
+    // Only what is buffered can be consumed
+    EXPECT_NO_THROW(reader->consume(0));
+    EXPECT_THROW(reader->consume(1), std::out_of_range);
+}
+
+TEST(buffered_reader, read_until_across_refills)
+{
+    //
+    // The first delimiter is the last byte of the first fill, the second
+    // one lies beyond a second fill and the last run has none at all.
+    //
+    auto const first  = std::string(capacity - 1, 'a') + '\n';
+    auto const second = std::string(150, 'b') + '\n';
+    auto const third  = std::string(10, 'c') + '\n';
+    auto const last   = std::string("no delimiter");
+
+    auto const source = std::make_shared<counting_source>(bytes_of(first + second + third + last));
+    auto const reader = m::byte_streams::make_buffered_reader(source, capacity);
+
+    EXPECT_TRUE(equal(reader->read_until(std::byte{'\n'}), first));
+    EXPECT_TRUE(equal(reader->read_until(std::byte{'\n'}), second));
+    EXPECT_TRUE(equal(reader->read_until(std::byte{'\n'}), third));
+    EXPECT_TRUE(equal(reader->read_until(std::byte{'\n'}), last));
+    EXPECT_TRUE(reader->read_until(std::byte{'\n'}).empty());
+}
+
+TEST(buffered_reader, end_of_stream)
+{
+    auto const empty = m::byte_streams::make_buffered_reader(
+        std::make_shared<counting_source>(std::vector<std::byte>{}), capacity);
+
+    EXPECT_TRUE(empty->at_end());
+    EXPECT_TRUE(empty->peek(1).empty());
+    EXPECT_TRUE(empty->read_until(std::byte{0}).empty());
+
+    auto const expected = pattern(300);
+    auto const source   = std::make_shared<counting_source>(expected);
+    auto const reader   = m::byte_streams::make_buffered_reader(source, capacity);
+
+    // Reads mix with peeks: one from the buffer, one straight from the source
+    std::vector<std::byte> buffer(200);
+
+    ASSERT_EQ(reader->peek(10).size(), 10u);
+    ASSERT_EQ(reader->read(std::span(buffer).first(20)), 20u);
+    EXPECT_TRUE(std::ranges::equal(std::span(buffer).first(20), std::span(expected).first(20)));
+
+    std::span<std::byte> s(buffer);
+    EXPECT_EQ(reader->read(s), 200u);
+    EXPECT_TRUE(std::ranges::equal(s, std::span(expected).subspan(20, 200)));
+
+    // A read that runs into the end is trimmed, and the next one is empty
+    s = std::span(buffer);
+    EXPECT_EQ(reader->read(s), 80u);
+    EXPECT_EQ(s.size(), 80u);
+    EXPECT_TRUE(std::ranges::equal(s, std::span(expected).subspan(220)));
+
+    EXPECT_EQ(reader->read(std::span(buffer)), 0u);
+    EXPECT_TRUE(reader->at_end());
+    EXPECT_TRUE(reader->read_until(std::byte{0}).empty());
+}
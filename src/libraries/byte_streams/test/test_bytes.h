@@ -0,0 +1,23 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//
+// `size` bytes for the stream tests to write and read back. The pattern
+// does not repeat at any chunk or buffer size the tests use, so bytes
+// from the wrong position show up as a mismatch.
+//
+inline std::vector<std::byte>
+pattern(std::size_t size)
+{
+    std::vector<std::byte> v(size);
+
+    for (std::size_t i = 0; i < size; i++)
+        v[i] = static_cast<std::byte>(i * 7 + i / 251);
+
+    return v;
+}
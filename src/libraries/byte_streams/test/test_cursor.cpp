@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <m/byte_streams/byte_streams.h>
+#include <m/byte_streams/cursor.h>
+#include <m/byte_streams/memory_based_byte_streams.h>
+
+#include "test_bytes.h"
+
+namespace
+{
+    constexpr std::size_t source_size = 100'000;
+} // namespace
+
+TEST(cursor, needs_a_source)
+{
+    EXPECT_THROW(m::byte_streams::make_cursor(nullptr), std::invalid_argument);
+}
+
+TEST(cursor, concurrent_cursors_over_one_source)
+{
+    auto const expected = pattern(source_size);
+    auto const source   = m::byte_streams::make_borrowing_memory_based_byte_stream(expected);
+
+    std::atomic<std::size_t> mismatches{};
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&, t]() {
+            // Each starts somewhere else and reads in a different size
+            auto const start = t * 4099;
+            auto const c     = m::byte_streams::make_cursor(source, m::io::position_t{start});
+
+            std::vector<std::byte> buffer(97 + t * 31);
+            std::size_t            total{};
+
+            while (auto const n = c->read(std::span(buffer)))
+            {
+                if (!std::ranges::equal(std::span(buffer).first(n),
+                                        std::span(expected).subspan(start + total, n)))
+                    mismatches++;
+
+                total += n;
+            }
+
+            if (total != source_size - start)
+                mismatches++;
+        });
+    }
+
+    for (auto& t: threads)
+        t.join();
+
+    EXPECT_EQ(mismatches.load(), 0u);
+}
+
+TEST(cursor, seek_and_tell)
+{
+    auto const expected = pattern(source_size);
+    auto const source   = m::byte_streams::make_borrowing_memory_based_byte_stream(expected);
+    auto const c        = m::byte_streams::make_cursor(source);
+
+    std::vector<std::byte> buffer(10);
+
+    EXPECT_EQ(c->tell(), m::io::position_t{0});
+    ASSERT_EQ(c->read(std::span(buffer)), 10u);
+    EXPECT_EQ(c->tell(), m::io::position_t{10});
+
+    c->seek(m::io::position_t{5000});
+    ASSERT_EQ(c->read(std::span(buffer)), 10u);
+    EXPECT_TRUE(std::ranges::equal(buffer, std::span(expected).subspan(5000, 10)));
+
+    c->seek(m::io::offset_t{-20});
+    EXPECT_EQ(c->tell(), m::io::position_t{4990});
+    ASSERT_EQ(c->read(std::span(buffer)), 10u);
+    EXPECT_TRUE(std::ranges::equal(buffer, std::span(expected).subspan(4990, 10)));
+
+    c->seek(m::io::offset_t{1000});
+    EXPECT_EQ(c->tell(), m::io::position_t{6000});
+
+    // Back to the start is fine, one byte further is not and moves nothing
+    c->seek(m::io::offset_t{-6000});
+    EXPECT_EQ(c->tell(), m::io::position_t{0});
+    EXPECT_THROW(c->seek(m::io::offset_t{-1}), std::runtime_error);
+    EXPECT_EQ(c->tell(), m::io::position_t{0});
+
+    // Copies carry on from the same place on their own
+    c->seek(m::io::position_t{100});
+    auto copy = *c;
+    ASSERT_EQ(copy.read(std::span(buffer)), 10u);
+    EXPECT_EQ(copy.tell(), m::io::position_t{110});
+    EXPECT_EQ(c->tell(), m::io::position_t{100});
+}
+
+TEST(cursor, reads_at_the_end)
+{
+    auto const expected = pattern(source_size);
+    auto const source   = m::byte_streams::make_borrowing_memory_based_byte_stream(expected);
+    auto const c = m::byte_streams::make_cursor(source, m::io::position_t{source_size - 4});
+
+    std::vector<std::byte> buffer(10);
+    std::span<std::byte>   s(buffer);
+
+    // A short read trims the span and leaves the cursor at the end
+    EXPECT_EQ(c->read(s), 4u);
+    EXPECT_EQ(s.size(), 4u);
+    EXPECT_TRUE(std::ranges::equal(s, std::span(expected).last(4)));
+    EXPECT_EQ(c->tell(), m::io::position_t{source_size});
+
+    EXPECT_EQ(c->read(std::span(buffer)), 0u);
+    EXPECT_EQ(c->tell(), m::io::position_t{source_size});
+
+    // Past the end reads nothing and does not move
+    c->seek(m::io::position_t{source_size + 100});
+    EXPECT_EQ(c->read(std::span(buffer)), 0u);
+    EXPECT_EQ(c->tell(), m::io::position_t{source_size + 100});
+}
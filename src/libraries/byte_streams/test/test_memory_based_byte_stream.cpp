@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <m/byte_streams/byte_streams.h>
+#include <m/byte_streams/memory_based_byte_streams.h>
+
+#include "test_bytes.h"
+
+namespace
+{
+    // Reads all of `stream` through seq_in
+    std::vector<std::byte>
+    read_all(m::byte_streams::memory_based_byte_stream& stream)
+    {
+        std::vector<std::byte> v;
+        std::vector<std::byte> buffer(100);
+
+        while (auto const n = stream.seq_in::read(std::span(buffer)))
+            v.insert(v.end(), buffer.begin(), buffer.begin() + n);
+
+        return v;
+    }
+} // namespace
+
+TEST(memory_based_byte_stream, copies_raw_bytes)
+{
+    auto const expected = pattern(1000);
+    auto const stream   = m::byte_streams::make_memory_based_byte_stream(expected.data(), 1000);
+
+    auto const borrowed = stream->borrow(m::io::position_t{0}, 1000);
+
+    EXPECT_NE(borrowed.data(), expected.data());
+    EXPECT_TRUE(std::ranges::equal(borrowed, expected));
+}
+
+TEST(memory_based_byte_stream, adopts_a_vector)
+{
+    auto const expected = pattern(1000);
+    auto       bytes    = expected;
+    auto const data     = bytes.data();
+
+    auto stream = m::byte_streams::make_memory_based_byte_stream(std::move(bytes));
+
+    EXPECT_EQ(stream->borrow(m::io::position_t{0}, 1000).data(), data);
+    EXPECT_EQ(stream->borrow(m::io::position_t{990}, 100).size(), 10u);
+    EXPECT_TRUE(stream->borrow(m::io::position_t{1000}, 1).empty());
+    EXPECT_TRUE(std::ranges::equal(read_all(*stream), expected));
+
+    // The vector's buffer lives on in the view once the stream is gone
+    auto const view = stream->view(m::io::position_t{100}, 200);
+    stream.reset();
+
+    EXPECT_EQ(view.m_bytes.data(), data + 100);
+    EXPECT_TRUE(std::ranges::equal(view.m_bytes, std::span(expected).subspan(100, 200)));
+}
+
+TEST(memory_based_byte_stream, shares_an_array)
+{
+    auto const expected = pattern(1000);
+    auto const array    = std::make_shared_for_overwrite<std::byte[]>(1000);
+    std::ranges::copy(expected, array.get());
+
+    // Only the first 600 bytes belong to the stream
+    auto stream = m::byte_streams::make_memory_based_byte_stream(array, 600);
+
+    EXPECT_EQ(array.use_count(), 2);
+    EXPECT_EQ(stream->borrow(m::io::position_t{0}, 1000).data(), array.get());
+    EXPECT_EQ(stream->borrow(m::io::position_t{0}, 1000).size(), 600u);
+    EXPECT_TRUE(std::ranges::equal(read_all(*stream), std::span(expected).first(600)));
+
+    auto view = stream->view(m::io::position_t{0}, 600);
+    stream.reset();
+
+    EXPECT_EQ(array.use_count(), 2);
+
+    view = {};
+
+    EXPECT_EQ(array.use_count(), 1);
+}
+
+TEST(memory_based_byte_stream, shares_part_of_an_array)
+{
+    auto const expected = pattern(1000);
+    auto const array    = std::make_shared_for_overwrite<std::byte[]>(1000);
+    std::ranges::copy(expected, array.get());
+
+    // An aliasing pointer, as into a file mapping
+    auto const part   = std::shared_ptr<std::byte const[]>(array, array.get() + 250);
+    auto const stream = m::byte_streams::make_memory_based_byte_stream(part, 500);
+
+    EXPECT_EQ(stream->borrow(m::io::position_t{0}, 500).data(), array.get() + 250);
+
+    std::vector<std::byte> buffer(500);
+    ASSERT_EQ(stream->ra_in::read(m::io::position_t{0}, std::span(buffer)), 500u);
+    EXPECT_TRUE(std::ranges::equal(buffer, std::span(expected).subspan(250, 500)));
+}
+
+TEST(memory_based_byte_stream, borrows_a_span)
+{
+    auto const expected = pattern(1000);
+    auto const stream   = m::byte_streams::make_borrowing_memory_based_byte_stream(expected);
+
+    EXPECT_EQ(stream->borrow(m::io::position_t{10}, 10).data(), expected.data() + 10);
+
+    // Nothing is owned, so there is nothing to guard
+    auto const view = stream->view(m::io::position_t{0}, 1000);
+
+    EXPECT_EQ(view.m_bytes.data(), expected.data());
+    EXPECT_EQ(view.m_guard, nullptr);
+    EXPECT_TRUE(std::ranges::equal(read_all(*stream), expected));
+}
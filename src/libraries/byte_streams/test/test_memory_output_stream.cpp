@@ -0,0 +1,213 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <m/byte_streams/byte_streams.h>
+#include <m/byte_streams/memory_output_stream.h>
+
+#include "test_bytes.h"
+
+namespace
+{
+    std::vector<std::byte>
+    gathered(m::byte_streams::memory_output_stream const& stream)
+    {
+        std::vector<std::byte> v;
+
+        for (auto const& chunk: stream.chunks())
+            v.insert(v.end(), chunk.begin(), chunk.end());
+
+        return v;
+    }
+
+    std::vector<std::byte>
+    read_all(m::byte_streams::memory_chunks_byte_stream& stream, std::size_t size)
+    {
+        std::vector<std::byte> v(size + 1);
+        v.resize(stream.ra_in::read(m::io::position_t{0}, std::span(v)));
+        return v;
+    }
+} // namespace
+
+TEST(memory_output_stream, sequential_writes_fill_chunks)
+{
+    auto const expected = pattern(1000);
+
+    m::byte_streams::memory_output_stream stream(64);
+
+    for (std::size_t i = 0; i < expected.size(); i += 30)
+    {
+        auto const n = (std::min)(std::size_t{30}, expected.size() - i);
+        stream.seq_out::write(std::span(expected).subspan(i, n));
+    }
+
+    EXPECT_EQ(stream.size(), expected.size());
+    EXPECT_EQ(stream.tell(), m::io::position_t{expected.size()});
+
+    auto const chunks = stream.chunks();
+
+    ASSERT_EQ(chunks.size(), 16u);
+    EXPECT_EQ(chunks.front().size(), 64u);
+    EXPECT_EQ(chunks.back().size(), 1000u - 15 * 64);
+    EXPECT_EQ(gathered(stream), expected);
+}
+
+TEST(memory_output_stream, positioned_writes_span_chunks)
+{
+    auto       expected = std::vector<std::byte>(300);
+    auto const bytes    = pattern(150);
+
+    m::byte_streams::memory_output_stream stream(64);
+
+    stream.ra_out::write(m::io::position_t{0}, std::span<std::byte const>(expected));
+
+    // From the middle of the first chunk to the middle of the fourth
+    stream.ra_out::write(m::io::position_t{40}, std::span<std::byte const>(bytes));
+    std::ranges::copy(bytes, expected.begin() + 40);
+
+    // And back over the tail of that, which must not grow the stream
+    stream.ra_out::write(m::io::position_t{150}, std::span<std::byte const>(bytes).first(100));
+    std::ranges::copy(std::span(bytes).first(100), expected.begin() + 150);
+
+    EXPECT_EQ(stream.size(), 300u);
+    EXPECT_EQ(gathered(stream), expected);
+
+    // Positioned writes leave the sequential position alone
+    EXPECT_EQ(stream.tell(), m::io::position_t{0});
+}
+
+TEST(memory_output_stream, gaps_are_zeroed)
+{
+    auto const bytes = pattern(10);
+
+    m::byte_streams::memory_output_stream stream(64);
+
+    stream.seq_out::write(std::span<std::byte const>(bytes));
+
+    // Past the end, across two whole chunks
+    stream.ra_out::write(m::io::position_t{200}, std::span<std::byte const>(bytes));
+
+    // And by seeking past the end
+    stream.seek(m::io::position_t{300});
+    stream.seq_out::write(std::span<std::byte const>(bytes));
+
+    auto expected = std::vector<std::byte>(310);
+    std::ranges::copy(bytes, expected.begin());
+    std::ranges::copy(bytes, expected.begin() + 200);
+    std::ranges::copy(bytes, expected.begin() + 300);
+
+    EXPECT_EQ(stream.size(), 310u);
+    EXPECT_EQ(gathered(stream), expected);
+}
+
+TEST(memory_output_stream, seek_bounds)
+{
+    auto const bytes = pattern(100);
+
+    m::byte_streams::memory_output_stream stream(64);
+
+    stream.seq_out::write(std::span<std::byte const>(bytes));
+
+    stream.seek(m::io::offset_t{-30});
+    EXPECT_EQ(stream.tell(), m::io::position_t{70});
+
+    stream.seek(m::io::offset_t{50});
+    EXPECT_EQ(stream.tell(), m::io::position_t{120});
+
+    // Back to the start is fine, one byte further is not and moves nothing
+    stream.seek(m::io::offset_t{-120});
+    EXPECT_EQ(stream.tell(), m::io::position_t{0});
+    EXPECT_THROW(stream.seek(m::io::offset_t{-1}), std::runtime_error);
+    EXPECT_EQ(stream.tell(), m::io::position_t{0});
+
+    // Seeking alone does not change the size
+    EXPECT_EQ(stream.size(), 100u);
+}
+
+TEST(memory_output_stream, release_hands_over_the_chunks)
+{
+    auto const expected = pattern(1000);
+
+    m::byte_streams::memory_output_stream stream(64);
+
+    stream.seq_out::write(std::span<std::byte const>(expected));
+
+    auto const input = stream.release();
+
+    EXPECT_EQ(read_all(*input, 1000), expected);
+
+    // From the end of one chunk into the next, and running off the end
+    std::vector<std::byte> buffer(100);
+    std::span<std::byte>   s(buffer);
+
+    EXPECT_EQ(input->ra_in::read(m::io::position_t{60}, s), 100u);
+    EXPECT_TRUE(std::ranges::equal(s, std::span(expected).subspan(60, 100)));
+
+    s = std::span(buffer);
+    EXPECT_EQ(input->ra_in::read(m::io::position_t{950}, s), 50u);
+    EXPECT_TRUE(std::ranges::equal(s, std::span(expected).subspan(950)));
+
+    EXPECT_EQ(input->ra_in::read(m::io::position_t{1000}, std::span(buffer)), 0u);
+
+    // Sequential reads in a size that does not divide the chunks
+    std::vector<std::byte> v;
+
+    while (auto const n = input->seq_in::read(std::span(buffer).first(7)))
+        v.insert(v.end(), buffer.begin(), buffer.begin() + n);
+
+    EXPECT_EQ(v, expected);
+
+    // The stream is left empty and usable
+    EXPECT_EQ(stream.size(), 0u);
+    EXPECT_TRUE(stream.chunks().empty());
+    EXPECT_EQ(stream.tell(), m::io::position_t{0});
+
+    stream.seq_out::write(std::span<std::byte const>(expected).first(5));
+    EXPECT_EQ(gathered(stream), std::vector(expected.begin(), expected.begin() + 5));
+
+    // Nothing written gives an empty stream
+    EXPECT_EQ(read_all(*m::byte_streams::memory_output_stream().release(), 0).size(), 0u);
+}
+
+TEST(memory_output_stream, reserve_sizes_the_first_chunk)
+{
+    auto const expected = pattern(1000);
+
+    m::byte_streams::memory_output_stream stream(64);
+
+    stream.reserve(600);
+    stream.seq_out::write(std::span<std::byte const>(expected));
+
+    // 600 bytes, then 64 at a time, with positions found across the two sizes
+    auto const chunks = stream.chunks();
+
+    ASSERT_EQ(chunks.size(), 8u);
+    EXPECT_EQ(chunks[0].size(), 600u);
+    EXPECT_EQ(chunks[1].size(), 64u);
+    EXPECT_EQ(chunks.back().size(), 400u - 6 * 64);
+
+    auto const bytes = pattern(20);
+    stream.ra_out::write(m::io::position_t{590}, std::span<std::byte const>(bytes));
+
+    auto changed = expected;
+    std::ranges::copy(bytes, changed.begin() + 590);
+
+    EXPECT_EQ(gathered(stream), changed);
+
+    // Only before writing, and release resets it
+    EXPECT_THROW(stream.reserve(10), std::logic_error);
+
+    auto const input = stream.release();
+    EXPECT_EQ(read_all(*input, 1000), changed);
+
+    stream.seq_out::write(std::span<std::byte const>(expected).first(100));
+    EXPECT_EQ(stream.chunks().front().size(), 64u);
+}
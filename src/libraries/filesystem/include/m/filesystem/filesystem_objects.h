@@ -13,6 +13,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <span>
 
 #include <m/byte_streams/byte_streams.h>
 
@@ -34,9 +35,16 @@ namespace m
             do_path() = 0;
         };
 
+        //
+        // On Linux the asynchronous reads go through io_uring, or through
+        // pread on the threadpool's blocking workers where io_uring is not
+        // available; elsewhere they are ordinary reads on the blocking
+        // workers. Either way the completions run on threadpool threads.
+        //
         class seekable_input_file :
             public m::filesystem::file,
             public m::byte_streams::ra_in,
+            public m::byte_streams::async_ra_in,
             public m::byte_streams::seq_in,
             public m::byte_streams::seekable
         {
@@ -56,10 +64,151 @@ namespace m
             virtual ~seekable_output_file() {}
         };
 
+        struct output_file_options
+        {
+            //
+            // Bytes gathered from small writes before they go to the file
+            // together. Writes at least this big skip the buffer.
+            //
+            std::size_t m_buffer_size = 256 * 1024;
+
+            //
+            // Bytes of disk to reserve up front when the final size is
+            // known, so that the file is laid out in one piece. The file's
+            // size is still what is written. Zero reserves nothing.
+            //
+            std::uint64_t m_preallocate{};
+        };
+
+        //
+        // An output file that combines writes in a buffer and hands them to
+        // the operating system a buffer at a time: positioned, gathering
+        // writes (pwritev on Linux) rather than through the C runtime.
+        // Writes that carry on from the buffered run, sequential or
+        // positioned, are appended to it; any other write sends the run on
+        // first. A write that does not fit goes out together with the run
+        // in one call.
+        //
+        // flush() passes everything buffered on to the operating system;
+        // it does not wait for it to reach the disk. Destruction flushes
+        // too but cannot report a failure, so call flush() first when that
+        // matters.
+        //
+        class buffered_output_file :
+            public m::filesystem::file,
+            public m::byte_streams::ra_out,
+            public m::byte_streams::seq_out,
+            public m::byte_streams::seekable
+        {
+        public:
+            buffered_output_file() {}
+            virtual ~buffered_output_file() {}
+
+            void
+            flush()
+            {
+                do_flush();
+            }
+
+            //
+            // Writes `buffers` one after another at the sequential position,
+            // as write would each of them, but in one gathering write when
+            // together they are too big to buffer: the chunks of a
+            // byte_streams::memory_output_stream, say.
+            //
+            void
+            gather_write(std::span<std::span<std::byte const> const> buffers)
+            {
+                do_gather_write(buffers);
+            }
+
+        protected:
+            virtual void
+            do_flush() = 0;
+
+            virtual void
+            do_gather_write(std::span<std::span<std::byte const> const> buffers) = 0;
+        };
+
+        //
+        // How a mapped file is expected to be read, passed on to the
+        // kernel as a hint (madvise on Linux, the file's open flags and
+        // PrefetchVirtualMemory on Windows).
+        //
+        enum class access_pattern
+        {
+            normal,
+            sequential,
+            random,
+            will_need, // Start reading the whole file in now
+        };
+
+        //
+        // What reading a mapped file does when the bytes cannot be paged
+        // in: on Linux when another process has truncated the file, on
+        // Windows when the device fails, e.g. a network share going away.
+        //
+        enum class truncation_policy
+        {
+            // The process takes the fault (SIGBUS or an in-page error).
+            // For files nothing else writes; reads are plain copies.
+            trust,
+
+            // The read throws std::system_error (io_error) instead.
+            guard,
+        };
+
+        struct mapped_file_options
+        {
+            access_pattern    m_access_pattern{access_pattern::normal};
+            truncation_policy m_truncation_policy{truncation_policy::guard};
+        };
+
+        //
+        // A read-only file mapped into memory in its entirety. Reads copy
+        // straight from the mapping; random access takes no lock, only the
+        // sequential cursor does. The size is fixed when the file is
+        // opened.
+        //
+        // Views (ra_view_in) point into the mapping itself, and a view's
+        // guard keeps the file mapped. They are not covered by the
+        // truncation_policy: touching a view of pages the file no longer
+        // backs faults.
+        //
+        class mapped_input_file :
+            public m::filesystem::file,
+            public m::byte_streams::ra_in,
+            public m::byte_streams::seq_in,
+            public m::byte_streams::seekable,
+            public m::byte_streams::ra_view_in
+        {
+        public:
+            mapped_input_file() {}
+            virtual ~mapped_input_file() {}
+
+            std::uint64_t
+            size()
+            {
+                return do_size();
+            }
+
+        protected:
+            virtual std::uint64_t
+            do_size() = 0;
+        };
+
         std::shared_ptr<seekable_input_file>
         open_seekable_input_file(std::filesystem::path const& path);
 
+        std::shared_ptr<mapped_input_file>
+        open_mapped_input_file(std::filesystem::path const& path,
+                               mapped_file_options const&   options = {});
+
         std::shared_ptr<seekable_output_file>
         open_seekable_output_file(std::filesystem::path const& path);
+
+        std::shared_ptr<buffered_output_file>
+        open_buffered_output_file(std::filesystem::path const& path,
+                                  output_file_options const&   options = {});
     } // namespace filesystem
 } // namespace m
\ No newline at end of file
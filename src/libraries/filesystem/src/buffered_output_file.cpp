@@ -0,0 +1,193 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include <m/filesystem/filesystem.h>
+
+#include "buffered_output_file.h"
+
+m::filesystem_impl::buffered_output_file::buffered_output_file(
+    std::filesystem::path const& path, m::filesystem::output_file_options const& options):
+    m_path(path),
+    m_handle(path),
+    m_buffer_size((std::max)(options.m_buffer_size, std::size_t{1})),
+    m_buffer(std::make_unique_for_overwrite<std::byte[]>(m_buffer_size))
+{
+    m_handle.preallocate(options.m_preallocate);
+}
+
+m::filesystem_impl::buffered_output_file::~buffered_output_file()
+{
+    try
+    {
+        flush_buffer();
+    }
+    catch (...)
+    {
+        // Nowhere to report it; flush() first to find out
+    }
+}
+
+std::filesystem::path
+m::filesystem_impl::buffered_output_file::do_path()
+{
+    return m_path;
+}
+
+// byte_streams::seq_out
+void
+m::filesystem_impl::buffered_output_file::do_write(std::span<std::byte const> s)
+{
+    auto const l = std::unique_lock(m_mutex);
+
+    write_at(m_position, s);
+    m_position += s.size();
+}
+
+// byte_streams::ra_out
+void
+m::filesystem_impl::buffered_output_file::do_write(io::position_t             p,
+                                                   std::span<std::byte const> s)
+{
+    auto const l = std::unique_lock(m_mutex);
+    write_at(std::to_underlying(p), s);
+}
+
+void
+m::filesystem_impl::buffered_output_file::do_seek(io::position_t p)
+{
+    auto const l = std::unique_lock(m_mutex);
+    m_position   = std::to_underlying(p);
+}
+
+void
+m::filesystem_impl::buffered_output_file::do_seek(io::offset_t o)
+{
+    auto const l = std::unique_lock(m_mutex);
+
+    auto const offset = std::to_underlying(o);
+
+    if (offset < 0 && static_cast<std::uint64_t>(-(offset + 1)) >= m_position)
+        throw std::runtime_error("seek before the start of the file");
+
+    m_position += static_cast<std::uint64_t>(offset);
+}
+
+m::io::position_t
+m::filesystem_impl::buffered_output_file::do_tell()
+{
+    auto const l = std::unique_lock(m_mutex);
+    return io::position_t{m_position};
+}
+
+void
+m::filesystem_impl::buffered_output_file::do_flush()
+{
+    auto const l = std::unique_lock(m_mutex);
+    flush_buffer();
+}
+
+void
+m::filesystem_impl::buffered_output_file::do_gather_write(
+    std::span<std::span<std::byte const> const> buffers)
+{
+    auto const l = std::unique_lock(m_mutex);
+
+    std::uint64_t total = 0;
+
+    for (auto const& buffer: buffers)
+        total += buffer.size();
+
+    if (total < m_buffer_size)
+    {
+        for (auto const& buffer: buffers)
+        {
+            write_at(m_position, buffer);
+            m_position += buffer.size();
+        }
+
+        return;
+    }
+
+    flush_buffer();
+
+    m_handle.write(m_position, buffers);
+    m_position += total;
+}
+
+void
+m::filesystem_impl::buffered_output_file::write_at(std::uint64_t              position,
+                                                   std::span<std::byte const> s)
+{
+    auto const buffer_end = m_buffer_position + m_buffered;
+
+    //
+    // Anything landing inside or right after the buffered run, and still
+    // within the buffer, is copied into it. That covers sequential writes
+    // and also patching a header or length field not yet written out.
+    //
+    if (m_buffered != 0 && position >= m_buffer_position && position <= buffer_end &&
+        s.size() <= m_buffer_size - (position - m_buffer_position))
+    {
+        auto const offset = static_cast<std::size_t>(position - m_buffer_position);
+
+        std::memcpy(m_buffer.get() + offset, s.data(), s.size());
+        m_buffered = (std::max)(m_buffered, offset + s.size());
+        return;
+    }
+
+    //
+    // A write carrying on from the run that does not fit after it goes
+    // out together with it, in one gathering write and without copying.
+    //
+    if (m_buffered != 0 && position == buffer_end)
+    {
+        auto const buffers = std::array<std::span<std::byte const>, 2>{
+            std::span<std::byte const>(m_buffer.get(), m_buffered), s};
+
+        m_handle.write(m_buffer_position, buffers);
+        m_buffered = 0;
+        return;
+    }
+
+    //
+    // Anywhere else the run goes out first, so that a later write to the
+    // same bytes is the one that sticks.
+    //
+    flush_buffer();
+
+    if (s.size() >= m_buffer_size)
+    {
+        m_handle.write(position, std::span(&s, 1));
+        return;
+    }
+
+    std::memcpy(m_buffer.get(), s.data(), s.size());
+    m_buffer_position = position;
+    m_buffered        = s.size();
+}
+
+void
+m::filesystem_impl::buffered_output_file::flush_buffer()
+{
+    if (m_buffered == 0)
+        return;
+
+    auto const run = std::span<std::byte const>(m_buffer.get(), m_buffered);
+
+    //
+    // The run is only dropped once it is written, so that a failed write
+    // leaves it for the next flush to try again from the same position.
+    //
+    m_handle.write(m_buffer_position, std::span(&run, 1));
+    m_buffered = 0;
+}
@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+
+#include <m/filesystem/filesystem.h>
+
+#ifdef WIN32
+#include "platforms/windows/output_file_handle.h"
+#else
+#include "platforms/linux/output_file_handle.h"
+#endif
+
+namespace m
+{
+    namespace filesystem_impl
+    {
+        class buffered_output_file : public m::filesystem::buffered_output_file
+        {
+        public:
+            buffered_output_file(std::filesystem::path const&               path,
+                                 m::filesystem::output_file_options const& options);
+            buffered_output_file(buffered_output_file const&) = delete;
+            buffered_output_file(buffered_output_file&&)      = delete;
+            ~buffered_output_file();
+
+            void
+            operator=(buffered_output_file const&) = delete;
+
+            void
+            operator=(buffered_output_file&&) = delete;
+
+        protected:
+            std::filesystem::path
+            do_path() override;
+
+            // byte_streams::seq_out
+            void
+            do_write(std::span<std::byte const> s) override;
+
+            // byte_streams::ra_out
+            void
+            do_write(io::position_t p, std::span<std::byte const> s) override;
+
+            void
+            do_seek(io::position_t p) override;
+
+            void
+            do_seek(io::offset_t o) override;
+
+            io::position_t
+            do_tell() override;
+
+            void
+            do_flush() override;
+
+            void
+            do_gather_write(std::span<std::span<std::byte const> const> buffers) override;
+
+            // Buffers or writes `s` at `position`. Called with m_mutex held.
+            void
+            write_at(std::uint64_t position, std::span<std::byte const> s);
+
+            // Writes out the buffered run. Called with m_mutex held.
+            void
+            flush_buffer();
+
+            std::filesystem::path                 m_path;
+            platform_specific::output_file_handle m_handle;
+
+            std::mutex                   m_mutex;
+            std::size_t                  m_buffer_size;
+            std::unique_ptr<std::byte[]> m_buffer;
+            std::uint64_t                m_buffer_position{}; // Where the buffered run goes
+            std::size_t                  m_buffered{};        // Bytes in the buffered run
+            std::uint64_t                m_position{};        // The sequential cursor
+        };
+    } // namespace filesystem_impl
+} // namespace m
@@ -3,10 +3,33 @@
 
 #include <m/filesystem/filesystem.h>
 
+#include "buffered_output_file.h"
+#include "mapped_input_file.h"
 #include "seekable_input_file.h"
+#include "seekable_output_file.h"
 
 std::shared_ptr<m::filesystem::seekable_input_file>
 m::filesystem::open_seekable_input_file(std::filesystem::path const& path)
 {
     return std::make_shared<m::filesystem_impl::seekable_input_file>(path);
 }
+
+std::shared_ptr<m::filesystem::mapped_input_file>
+m::filesystem::open_mapped_input_file(std::filesystem::path const& path,
+                                      mapped_file_options const&   options)
+{
+    return std::make_shared<m::filesystem_impl::mapped_input_file>(path, options);
+}
+
+std::shared_ptr<m::filesystem::seekable_output_file>
+m::filesystem::open_seekable_output_file(std::filesystem::path const& path)
+{
+    return std::make_shared<m::filesystem_impl::seekable_output_file>(path);
+}
+
+std::shared_ptr<m::filesystem::buffered_output_file>
+m::filesystem::open_buffered_output_file(std::filesystem::path const& path,
+                                         output_file_options const&   options)
+{
+    return std::make_shared<m::filesystem_impl::buffered_output_file>(path, options);
+}
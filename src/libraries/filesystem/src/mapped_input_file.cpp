@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include <m/cast/to.h>
+#include <m/filesystem/filesystem.h>
+
+#include "mapped_input_file.h"
+
+m::filesystem_impl::mapped_input_file::mapped_input_file(
+    std::filesystem::path const& path, m::filesystem::mapped_file_options const& options):
+    m_path(path), m_mapping(std::make_shared<platform_specific::file_mapping>(path, options))
+{}
+
+std::filesystem::path
+m::filesystem_impl::mapped_input_file::do_path()
+{
+    return m_path;
+}
+
+std::uint64_t
+m::filesystem_impl::mapped_input_file::do_size()
+{
+    return m_mapping->size();
+}
+
+// byte_streams::seq_in
+std::size_t
+m::filesystem_impl::mapped_input_file::do_read(std::span<std::byte>& span)
+{
+    auto const l = std::unique_lock(m_mutex);
+
+    auto const size = read_at(m_position, span);
+    m_position      = m_position + size;
+
+    return size;
+}
+
+// byte_streams::ra_in
+std::size_t
+m::filesystem_impl::mapped_input_file::do_read(io::position_t p, std::span<std::byte>& span)
+{
+    // The mapping never changes, so random access needs no lock
+    return read_at(p, span);
+}
+
+std::size_t
+m::filesystem_impl::mapped_input_file::read_at(io::position_t p, std::span<std::byte>& span)
+{
+    auto const size     = m_mapping->size();
+    auto const position = std::to_underlying(p);
+
+    if (position >= size)
+    {
+        span = span.first(0);
+        return 0;
+    }
+
+    auto const offset = static_cast<std::size_t>(position);
+    auto const count  = (std::min)(span.size(), size - offset);
+
+    span = span.first(count);
+    m_mapping->copy(offset, span);
+
+    return count;
+}
+
+void
+m::filesystem_impl::mapped_input_file::do_seek(io::position_t p)
+{
+    auto const l = std::unique_lock(m_mutex);
+    m_position   = p;
+}
+
+void
+m::filesystem_impl::mapped_input_file::do_seek(io::offset_t o)
+{
+    auto const l = std::unique_lock(m_mutex);
+
+    auto const current = std::to_underlying(m_position);
+    auto const offset  = std::to_underlying(o);
+
+    if (offset < 0 && static_cast<std::uint64_t>(-(offset + 1)) >= current)
+        throw std::runtime_error("seek before the start of the file");
+
+    m_position = io::position_t{current + static_cast<std::uint64_t>(offset)};
+}
+
+std::span<std::byte const>
+m::filesystem_impl::mapped_input_file::do_borrow(io::position_t p, std::size_t size)
+{
+    auto const bytes    = m_mapping->bytes();
+    auto const position = std::to_underlying(p);
+
+    if (position >= bytes.size())
+        return {};
+
+    auto const offset = static_cast<std::size_t>(position);
+
+    return bytes.subspan(offset, (std::min)(size, bytes.size() - offset));
+}
+
+std::shared_ptr<void const>
+m::filesystem_impl::mapped_input_file::do_guard()
+{
+    return m_mapping;
+}
+
+m::io::position_t
+m::filesystem_impl::mapped_input_file::do_tell()
+{
+    auto const l = std::unique_lock(m_mutex);
+    return m_position;
+}
@@ -0,0 +1,78 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+#include <m/filesystem/filesystem.h>
+
+#ifdef WIN32
+#include "platforms/windows/file_mapping.h"
+#else
+#include "platforms/linux/file_mapping.h"
+#endif
+
+namespace m
+{
+    namespace filesystem_impl
+    {
+        class mapped_input_file : public m::filesystem::mapped_input_file
+        {
+        public:
+            mapped_input_file(std::filesystem::path const&              path,
+                              m::filesystem::mapped_file_options const& options);
+            mapped_input_file(mapped_input_file const&) = delete;
+            mapped_input_file(mapped_input_file&&)      = delete;
+
+            void
+            operator=(mapped_input_file const&) = delete;
+
+            void
+            operator=(mapped_input_file&&) = delete;
+
+        protected:
+            std::filesystem::path
+            do_path() override;
+
+            std::uint64_t
+            do_size() override;
+
+            // byte_streams::seq_in
+            std::size_t
+            do_read(std::span<std::byte>& span) override;
+
+            // byte_streams::ra_in
+            std::size_t
+            do_read(io::position_t p, std::span<std::byte>& span) override;
+
+            void
+            do_seek(io::position_t p) override;
+
+            void
+            do_seek(io::offset_t o) override;
+
+            io::position_t
+            do_tell() override;
+
+            // byte_streams::ra_view_in
+            std::span<std::byte const>
+            do_borrow(io::position_t p, std::size_t size) override;
+
+            std::shared_ptr<void const>
+            do_guard() override;
+
+            // Copies what there is of `span` at `p` and trims it to that
+            std::size_t
+            read_at(io::position_t p, std::span<std::byte>& span);
+
+            std::filesystem::path                            m_path;
+            std::shared_ptr<platform_specific::file_mapping> m_mapping;
+            std::mutex                                       m_mutex; // For the sequential cursor
+            io::position_t                                   m_position{};
+        };
+    } // namespace filesystem_impl
+} // namespace m
@@ -0,0 +1,359 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <utility>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "async_reader.h"
+
+namespace
+{
+    constexpr unsigned ring_entries = 256;
+
+    void*
+    map_ring(int fd, std::size_t size, off_t offset)
+    {
+        auto const p =
+            ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+
+        if (p == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "mmap");
+
+        return p;
+    }
+
+    template <typename T>
+    T*
+    ring_field(void* ring, std::uint32_t offset) noexcept
+    {
+        return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+    }
+} // namespace
+
+namespace m::filesystem_impl::platform_specific
+{
+    async_reader::async_reader(bool use_io_uring): m_pool(m::threadpool)
+    {
+        if (!use_io_uring)
+            return;
+
+        ::io_uring_params params{};
+
+        m_ring_fd = static_cast<int>(::syscall(__NR_io_uring_setup, ring_entries, &params));
+
+        if (m_ring_fd == -1)
+            return;
+
+        try
+        {
+            m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(::io_uring_cqe);
+
+            bool const single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+            if (single_mmap)
+                m_sq_ring_size = m_cq_ring_size = (std::max)(m_sq_ring_size, m_cq_ring_size);
+
+            m_sq_ring = map_ring(m_ring_fd, m_sq_ring_size, IORING_OFF_SQ_RING);
+            m_cq_ring =
+                single_mmap ? m_sq_ring : map_ring(m_ring_fd, m_cq_ring_size, IORING_OFF_CQ_RING);
+
+            m_sqes_size = params.sq_entries * sizeof(::io_uring_sqe);
+            m_sqes      = static_cast<::io_uring_sqe*>(
+                map_ring(m_ring_fd, m_sqes_size, IORING_OFF_SQES));
+
+            m_sq_head    = ring_field<unsigned>(m_sq_ring, params.sq_off.head);
+            m_sq_tail    = ring_field<unsigned>(m_sq_ring, params.sq_off.tail);
+            m_sq_mask    = *ring_field<unsigned>(m_sq_ring, params.sq_off.ring_mask);
+            m_sq_entries = params.sq_entries;
+            m_sq_array   = ring_field<unsigned>(m_sq_ring, params.sq_off.array);
+            m_cq_head    = ring_field<unsigned>(m_cq_ring, params.cq_off.head);
+            m_cq_tail    = ring_field<unsigned>(m_cq_ring, params.cq_off.tail);
+            m_cq_mask    = *ring_field<unsigned>(m_cq_ring, params.cq_off.ring_mask);
+            m_cqes       = ring_field<::io_uring_cqe>(m_cq_ring, params.cq_off.cqes);
+
+            m_in_flight_limit = params.cq_entries;
+
+            m_wait = m_pool->wait_for_fd(
+                m_ring_fd, m::fd_events::readable, [this](m::fd_events) { on_ring_ready(); });
+        }
+        catch (...)
+        {
+            // Fall back to pread
+            close_ring();
+        }
+    }
+
+    async_reader::~async_reader()
+    {
+        {
+            auto l     = std::unique_lock(m_mutex);
+            m_stopping = true;
+        }
+
+        // Waits for on_ring_ready() to return if it is running
+        m_wait.reset();
+
+        close_ring();
+    }
+
+    async_reader&
+    async_reader::get()
+    {
+        static async_reader s_reader;
+        return s_reader;
+    }
+
+    void
+    async_reader::read(int                                    fd,
+                       std::shared_ptr<void> const&           owner,
+                       std::span<m::byte_streams::async_read> batch)
+    {
+        //
+        // Everything that may throw comes before the completions are taken
+        // from the batch, so that a failure leaves the caller with all of
+        // them. Queueing the operations from here on never allocates.
+        //
+        operation_queue operations;
+
+        for (auto const& r: batch)
+        {
+            auto op        = std::make_unique<operation>();
+            op->m_fd       = fd;
+            op->m_owner    = owner;
+            op->m_position = r.m_position;
+            op->m_buffer   = r.m_buffer;
+            operations.push_back(std::move(op));
+        }
+
+        auto op = operations.front();
+
+        for (auto& r: batch)
+        {
+            op->m_completion = std::move(r.m_completion);
+            op               = op->m_next;
+        }
+
+        if (uses_io_uring())
+        {
+            auto l = std::unique_lock(m_mutex);
+
+            m_backlog.splice_back(operations);
+
+            if (!flush())
+                operations.splice_back(m_backlog);
+        }
+
+        while (!operations.empty())
+            read_with_pread(operations.pop_front());
+    }
+
+    void
+    async_reader::read_with_pread(operation_ptr op)
+    {
+        m_pool->submit_blocking([op = std::move(op)]() {
+            auto ec = std::error_code();
+
+            while (op->m_done < op->m_buffer.size())
+            {
+                auto const n = ::pread(op->m_fd,
+                                       op->m_buffer.data() + op->m_done,
+                                       op->m_buffer.size() - op->m_done,
+                                       static_cast<off_t>(std::to_underlying(op->m_position) +
+                                                          op->m_done));
+
+                if (n == -1)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    ec = std::error_code(errno, std::generic_category());
+                    break;
+                }
+
+                if (n == 0)
+                    break;
+
+                op->m_done += static_cast<std::size_t>(n);
+            }
+
+            op->m_completion(ec, op->m_buffer.first(ec ? 0 : op->m_done));
+        });
+    }
+
+    bool
+    async_reader::flush() noexcept
+    {
+        auto tail = *m_sq_tail;
+        auto head = std::atomic_ref(*m_sq_head).load(std::memory_order_acquire);
+
+        while (!m_backlog.empty() && m_in_flight < m_in_flight_limit &&
+               tail - head < m_sq_entries)
+        {
+            auto const op = m_backlog.pop_front().release();
+
+            op->m_iov.iov_base = op->m_buffer.data() + op->m_done;
+            op->m_iov.iov_len  = op->m_buffer.size() - op->m_done;
+
+            auto const index = tail & m_sq_mask;
+            auto&      sqe   = m_sqes[index];
+
+            sqe           = {};
+            sqe.opcode    = IORING_OP_READV;
+            sqe.fd        = op->m_fd;
+            sqe.off       = std::to_underlying(op->m_position) + op->m_done;
+            sqe.addr      = reinterpret_cast<std::uint64_t>(&op->m_iov);
+            sqe.len       = 1;
+            sqe.user_data = reinterpret_cast<std::uint64_t>(op);
+
+            m_sq_array[index] = index;
+
+            tail++;
+            m_in_flight++;
+        }
+
+        std::atomic_ref(*m_sq_tail).store(tail, std::memory_order_release);
+
+        //
+        // Entries a previous io_uring_enter left behind, for want of kernel
+        // memory, are submitted along with the new ones.
+        //
+        while (true)
+        {
+            head = std::atomic_ref(*m_sq_head).load(std::memory_order_acquire);
+
+            if (head == tail)
+                return true;
+
+            if (::syscall(__NR_io_uring_enter, m_ring_fd, tail - head, 0, 0, nullptr, 0) == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                //
+                // Short of memory or of completion queue space, the kernel
+                // asks to be retried once completions have been reaped.
+                // on_ring_ready() does that, provided something the kernel
+                // did take is still to complete.
+                //
+                if ((errno == EAGAIN || errno == EBUSY) && m_in_flight > tail - head)
+                    return true;
+
+                break;
+            }
+        }
+
+        //
+        // Without SQPOLL the kernel only reads the submission queue in
+        // io_uring_enter, so what it has not consumed can be taken back.
+        //
+        while (tail != head)
+        {
+            tail--;
+            m_backlog.push_front(
+                operation_ptr(reinterpret_cast<operation*>(m_sqes[tail & m_sq_mask].user_data)));
+            m_in_flight--;
+        }
+
+        std::atomic_ref(*m_sq_tail).store(tail, std::memory_order_release);
+
+        return false;
+    }
+
+    void
+    async_reader::on_ring_ready()
+    {
+        operation_queue finished;
+        operation_queue fallback;
+
+        {
+            auto l = std::unique_lock(m_mutex);
+
+            auto       head = *m_cq_head;
+            auto const tail = std::atomic_ref(*m_cq_tail).load(std::memory_order_acquire);
+
+            for (; head != tail; head++)
+            {
+                auto const& cqe = m_cqes[head & m_cq_mask];
+                auto        op  = operation_ptr(reinterpret_cast<operation*>(cqe.user_data));
+
+                m_in_flight--;
+
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+                {
+                    m_backlog.push_back(std::move(op));
+                    continue;
+                }
+
+                if (cqe.res < 0)
+                {
+                    op->m_error = std::error_code(-cqe.res, std::generic_category());
+                    finished.push_back(std::move(op));
+                    continue;
+                }
+
+                op->m_done += static_cast<std::size_t>(cqe.res);
+
+                // A short read that is not at the end of the file goes on
+                if (cqe.res > 0 && op->m_done < op->m_buffer.size())
+                    m_backlog.push_back(std::move(op));
+                else
+                    finished.push_back(std::move(op));
+            }
+
+            std::atomic_ref(*m_cq_head).store(head, std::memory_order_release);
+
+            if (!flush())
+                fallback.splice_back(m_backlog);
+
+            if (!m_stopping)
+                m_wait->rearm();
+        }
+
+        while (!finished.empty())
+            complete(finished.pop_front());
+
+        while (!fallback.empty())
+            read_with_pread(fallback.pop_front());
+    }
+
+    void
+    async_reader::complete(operation_ptr op)
+    {
+        m_pool->submit([op = std::move(op)]() {
+            auto const ec = op->m_error;
+            op->m_completion(ec, op->m_buffer.first(ec ? 0 : op->m_done));
+        });
+    }
+
+    void
+    async_reader::close_ring() noexcept
+    {
+        if (m_sqes)
+            ::munmap(m_sqes, m_sqes_size);
+
+        if (m_cq_ring && m_cq_ring != m_sq_ring)
+            ::munmap(m_cq_ring, m_cq_ring_size);
+
+        if (m_sq_ring)
+            ::munmap(m_sq_ring, m_sq_ring_size);
+
+        m_sqes    = nullptr;
+        m_cq_ring = nullptr;
+        m_sq_ring = nullptr;
+
+        if (m_ring_fd != -1)
+            ::close(std::exchange(m_ring_fd, -1));
+    }
+} // namespace m::filesystem_impl::platform_specific
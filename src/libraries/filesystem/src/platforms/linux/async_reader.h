@@ -0,0 +1,232 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <system_error>
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <m/byte_streams/byte_streams.h>
+#include <m/threadpool/threadpool.h>
+
+namespace m::filesystem_impl::platform_specific
+{
+    //
+    // Carries out the asynchronous reads of every seekable_input_file in
+    // the process.
+    //
+    // Reads go through one io_uring. A batch is written to the submission
+    // queue and handed to the kernel with a single io_uring_enter. No more
+    // reads are in flight than the completion queue has room for; the rest
+    // wait in a backlog that is drained as completions are reaped. The
+    // ring's descriptor is watched with threadpool::wait_for_fd, so the
+    // completions are reaped on a threadpool worker, and each is then
+    // submitted to the threadpool to run on its own. A short read is
+    // continued from where it stopped so that a completion sees fewer bytes
+    // than it asked for only at the end of the file.
+    //
+    // Where io_uring is not available, be it an old kernel or a seccomp
+    // profile refusing it, each read is a pread on the threadpool's
+    // blocking workers instead.
+    //
+    class async_reader
+    {
+    public:
+        explicit async_reader(bool use_io_uring = true);
+        async_reader(async_reader const&) = delete;
+        async_reader(async_reader&&)      = delete;
+        ~async_reader();
+
+        void
+        operator=(async_reader const&) = delete;
+
+        void
+        operator=(async_reader&&) = delete;
+
+        static async_reader&
+        get();
+
+        //
+        // Starts the reads of `batch` from `fd`, holding on to `owner`
+        // until each has completed.
+        //
+        void
+        read(int                                    fd,
+             std::shared_ptr<void> const&           owner,
+             std::span<m::byte_streams::async_read> batch);
+
+        bool
+        uses_io_uring() const noexcept
+        {
+            return m_ring_fd != -1;
+        }
+
+    protected:
+        struct operation
+        {
+            int                                       m_fd{};
+            std::shared_ptr<void>                     m_owner;
+            m::io::position_t                         m_position{};
+            std::span<std::byte>                      m_buffer;
+            m::byte_streams::async_read::completion_t m_completion;
+            std::size_t                               m_done{};
+            std::error_code                           m_error;
+            ::iovec                                   m_iov{};
+            operation*                                m_next{};
+        };
+
+        using operation_ptr = std::unique_ptr<operation>;
+
+        //
+        // A FIFO of operations linked through m_next. Queueing never
+        // allocates, so an operation can always be put back where it came
+        // from and its completion is never lost to a bad_alloc.
+        //
+        class operation_queue
+        {
+        public:
+            operation_queue() = default;
+            operation_queue(operation_queue const&) = delete;
+
+            ~operation_queue()
+            {
+                while (!empty())
+                    pop_front();
+            }
+
+            void
+            operator=(operation_queue const&) = delete;
+
+            bool
+            empty() const noexcept
+            {
+                return m_head == nullptr;
+            }
+
+            operation*
+            front() const noexcept
+            {
+                return m_head;
+            }
+
+            void
+            push_back(operation_ptr op) noexcept
+            {
+                auto const p = op.release();
+                p->m_next    = nullptr;
+
+                if (m_tail)
+                    m_tail->m_next = p;
+                else
+                    m_head = p;
+
+                m_tail = p;
+            }
+
+            void
+            push_front(operation_ptr op) noexcept
+            {
+                auto const p = op.release();
+                p->m_next    = m_head;
+                m_head       = p;
+
+                if (!m_tail)
+                    m_tail = p;
+            }
+
+            operation_ptr
+            pop_front() noexcept
+            {
+                auto const p = m_head;
+                m_head       = p->m_next;
+
+                if (!m_head)
+                    m_tail = nullptr;
+
+                p->m_next = nullptr;
+                return operation_ptr(p);
+            }
+
+            // Moves all of `other` to the back of this queue
+            void
+            splice_back(operation_queue& other) noexcept
+            {
+                if (other.empty())
+                    return;
+
+                if (m_tail)
+                    m_tail->m_next = other.m_head;
+                else
+                    m_head = other.m_head;
+
+                m_tail       = other.m_tail;
+                other.m_head = nullptr;
+                other.m_tail = nullptr;
+            }
+
+        private:
+            operation* m_head{};
+            operation* m_tail{};
+        };
+
+        void
+        read_with_pread(operation_ptr op);
+
+        //
+        // Moves what the backlog may into the submission queue and submits
+        // it. Called with m_mutex held.
+        //
+        // Should the kernel refuse the submission, with no completion left
+        // to come that would retry it, what it did not take is put back at
+        // the front of the backlog and false is returned. The caller then
+        // reads the backlog with pread instead.
+        //
+        bool
+        flush() noexcept;
+
+        void
+        on_ring_ready();
+
+        void
+        complete(operation_ptr op);
+
+        void
+        close_ring() noexcept;
+
+        std::shared_ptr<m::threadpool_class> m_pool;
+        std::shared_ptr<m::fd_wait>          m_wait;
+
+        std::mutex      m_mutex;
+        operation_queue m_backlog;
+        std::size_t     m_in_flight{};
+        std::size_t     m_in_flight_limit{};
+        bool            m_stopping{false};
+
+        int m_ring_fd{-1};
+
+        // The rings as mapped from the kernel
+        void*           m_sq_ring{};
+        std::size_t     m_sq_ring_size{};
+        void*           m_cq_ring{};
+        std::size_t     m_cq_ring_size{};
+        ::io_uring_sqe* m_sqes{};
+        std::size_t     m_sqes_size{};
+
+        unsigned*       m_sq_head{};
+        unsigned*       m_sq_tail{};
+        unsigned        m_sq_mask{};
+        unsigned        m_sq_entries{};
+        unsigned*       m_sq_array{};
+        unsigned*       m_cq_head{};
+        unsigned*       m_cq_tail{};
+        unsigned        m_cq_mask{};
+        ::io_uring_cqe* m_cqes{};
+    };
+} // namespace m::filesystem_impl::platform_specific
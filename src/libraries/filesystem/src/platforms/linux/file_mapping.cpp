@@ -0,0 +1,172 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <atomic>
+#include <cerrno>
+#include <csetjmp>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <m/cast/to.h>
+
+#include "file_mapping.h"
+
+namespace
+{
+    // Set while a guarded copy runs on this thread
+    thread_local sigjmp_buf* t_recovery;
+
+    struct sigaction s_previous_sigbus;
+    std::once_flag   s_sigbus_installed;
+
+    void
+    on_sigbus(int signal, siginfo_t* info, void* context)
+    {
+        if (auto const recovery = t_recovery)
+        {
+            t_recovery = nullptr;
+            siglongjmp(*recovery, 1);
+        }
+
+        if (s_previous_sigbus.sa_flags & SA_SIGINFO)
+        {
+            s_previous_sigbus.sa_sigaction(signal, info, context);
+            return;
+        }
+
+        if (s_previous_sigbus.sa_handler != SIG_DFL && s_previous_sigbus.sa_handler != SIG_IGN)
+        {
+            s_previous_sigbus.sa_handler(signal);
+            return;
+        }
+
+        //
+        // Not a fault of ours and nobody else handles it. Put the default
+        // back and return; the faulting instruction runs again and the
+        // process dies the way it would have without us.
+        //
+        ::sigaction(SIGBUS, &s_previous_sigbus, nullptr);
+    }
+
+    void
+    install_sigbus_handler()
+    {
+        std::call_once(s_sigbus_installed, []() {
+            struct sigaction action
+            {};
+
+            action.sa_sigaction = &on_sigbus;
+            action.sa_flags     = SA_SIGINFO | SA_NODEFER; // The handler jumps out
+
+            sigemptyset(&action.sa_mask);
+
+            if (::sigaction(SIGBUS, &action, &s_previous_sigbus) == -1)
+                throw std::system_error(errno, std::generic_category(), "sigaction");
+        });
+    }
+
+    int
+    advice(m::filesystem::access_pattern pattern) noexcept
+    {
+        switch (pattern)
+        {
+            case m::filesystem::access_pattern::sequential:
+                return MADV_SEQUENTIAL;
+
+            case m::filesystem::access_pattern::random:
+                return MADV_RANDOM;
+
+            case m::filesystem::access_pattern::will_need:
+                return MADV_WILLNEED;
+
+            default:
+                return MADV_NORMAL;
+        }
+    }
+} // namespace
+
+namespace m::filesystem_impl::platform_specific
+{
+    file_mapping::file_mapping(std::filesystem::path const&              path,
+                               m::filesystem::mapped_file_options const& options):
+        m_guarded(options.m_truncation_policy == m::filesystem::truncation_policy::guard)
+    {
+        if (m_guarded)
+            install_sigbus_handler();
+
+        auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd == -1)
+            throw std::system_error(errno, std::generic_category(), "open");
+
+        struct stat st
+        {};
+
+        if (::fstat(fd, &st) == -1)
+        {
+            auto const error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "fstat");
+        }
+
+        m_size = m::to<std::size_t>(st.st_size);
+
+        if (m_size != 0)
+        {
+            auto const p = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+
+            if (p == MAP_FAILED)
+            {
+                auto const error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "mmap");
+            }
+
+            m_base = static_cast<std::byte const*>(p);
+
+            // Only a hint, so failure is of no consequence
+            ::madvise(p, m_size, advice(options.m_access_pattern));
+        }
+
+        ::close(fd);
+    }
+
+    file_mapping::~file_mapping()
+    {
+        if (m_base)
+            ::munmap(const_cast<std::byte*>(m_base), m_size);
+    }
+
+    void
+    file_mapping::copy(std::size_t offset, std::span<std::byte> to) const
+    {
+        if (!m_guarded)
+        {
+            std::memcpy(to.data(), m_base + offset, to.size());
+            return;
+        }
+
+        sigjmp_buf recovery;
+
+        // SA_NODEFER leaves SIGBUS unblocked after the jump, so the signal
+        // mask need not be saved and restored
+        if (sigsetjmp(recovery, 0) != 0)
+            throw std::system_error(std::make_error_code(std::errc::io_error),
+                                    "mapped file is no longer backed by the file");
+
+        t_recovery = &recovery;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+
+        std::memcpy(to.data(), m_base + offset, to.size());
+
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        t_recovery = nullptr;
+    }
+} // namespace m::filesystem_impl::platform_specific
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+#include <m/filesystem/filesystem.h>
+
+namespace m::filesystem_impl::platform_specific
+{
+    //
+    // A whole file mapped read-only with mmap. The descriptor is closed
+    // once the mapping exists; an empty file is not mapped at all.
+    //
+    // With truncation_policy::guard, copy() catches the SIGBUS raised by
+    // touching a page the file no longer backs. A process-wide handler
+    // jumps back out of the copy when a thread-local recovery point is
+    // set, and passes any other SIGBUS on to the handler that was there
+    // before it.
+    //
+    class file_mapping
+    {
+    public:
+        file_mapping(std::filesystem::path const& path, m::filesystem::mapped_file_options const&);
+        file_mapping(file_mapping const&) = delete;
+        file_mapping(file_mapping&&)      = delete;
+        ~file_mapping();
+
+        void
+        operator=(file_mapping const&) = delete;
+
+        void
+        operator=(file_mapping&&) = delete;
+
+        std::size_t
+        size() const noexcept
+        {
+            return m_size;
+        }
+
+        std::span<std::byte const>
+        bytes() const noexcept
+        {
+            return {m_base, m_size};
+        }
+
+        //
+        // Copies to.size() bytes at `offset`, which the caller has checked
+        // are within the mapping.
+        //
+        void
+        copy(std::size_t offset, std::span<std::byte> to) const;
+
+    protected:
+        std::byte const* m_base{};
+        std::size_t      m_size{};
+        bool             m_guarded{};
+    };
+} // namespace m::filesystem_impl::platform_specific
@@ -0,0 +1,93 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "output_file_handle.h"
+
+namespace m::filesystem_impl::platform_specific
+{
+    output_file_handle::output_file_handle(std::filesystem::path const& path)
+    {
+        m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+        if (m_fd == -1)
+            throw std::system_error(errno, std::generic_category(), "open");
+    }
+
+    output_file_handle::~output_file_handle()
+    {
+        if (m_fd != -1)
+            ::close(m_fd);
+    }
+
+    void
+    output_file_handle::preallocate(std::uint64_t size) noexcept
+    {
+        if (size != 0)
+            ::fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size));
+    }
+
+    void
+    output_file_handle::write(std::uint64_t                               position,
+                              std::span<std::span<std::byte const> const> buffers)
+    {
+        //
+        // Most writes are a buffer or two: the pending run and the write
+        // that did not fit after it. Gathered chunk lists go over in slices
+        // of a fixed array, each slice one system call.
+        //
+        constexpr std::size_t max_iovecs = 64;
+
+        while (!buffers.empty())
+        {
+            std::array<iovec, max_iovecs> iov{};
+
+            auto const count = (std::min)(buffers.size(), max_iovecs);
+
+            for (std::size_t i = 0; i < count; i++)
+                iov[i] = {const_cast<std::byte*>(buffers[i].data()), buffers[i].size()};
+
+            std::size_t first = 0;
+
+            while (first < count)
+            {
+                auto const written = ::pwritev(m_fd,
+                                               iov.data() + first,
+                                               static_cast<int>(count - first),
+                                               static_cast<off_t>(position));
+
+                if (written == -1)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    throw std::system_error(errno, std::generic_category(), "pwritev");
+                }
+
+                position += static_cast<std::uint64_t>(written);
+
+                // Step past what went out, which may end part way into a buffer
+                auto left = static_cast<std::size_t>(written);
+
+                while (first < count && left >= iov[first].iov_len)
+                    left -= iov[first++].iov_len;
+
+                if (first < count)
+                {
+                    iov[first].iov_base = static_cast<std::byte*>(iov[first].iov_base) + left;
+                    iov[first].iov_len -= left;
+                }
+            }
+
+            buffers = buffers.subspan(count);
+        }
+    }
+} // namespace m::filesystem_impl::platform_specific
@@ -0,0 +1,50 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace m::filesystem_impl::platform_specific
+{
+    //
+    // A file descriptor opened for writing, created or truncated. Every
+    // write says where it goes (pwritev), so the descriptor's own offset
+    // is never used.
+    //
+    class output_file_handle
+    {
+    public:
+        explicit output_file_handle(std::filesystem::path const& path);
+        output_file_handle(output_file_handle const&) = delete;
+        output_file_handle(output_file_handle&&)      = delete;
+        ~output_file_handle();
+
+        void
+        operator=(output_file_handle const&) = delete;
+
+        void
+        operator=(output_file_handle&&) = delete;
+
+        //
+        // Reserves `size` bytes of disk from the start of the file without
+        // changing its size (fallocate with FALLOC_FL_KEEP_SIZE). Only a
+        // hint; file systems that cannot do it are left alone.
+        //
+        void
+        preallocate(std::uint64_t size) noexcept;
+
+        //
+        // Writes all of `buffers`, one after another, starting at
+        // `position`, in as few system calls as the kernel allows.
+        //
+        void
+        write(std::uint64_t position, std::span<std::span<std::byte const> const> buffers);
+
+    protected:
+        int m_fd{-1};
+    };
+} // namespace m::filesystem_impl::platform_specific
@@ -0,0 +1,138 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <cstring>
+#include <system_error>
+
+#include <Windows.h>
+
+#include <m/cast/to.h>
+#include <m/errors/errors.h>
+
+#include "file_mapping.h"
+
+namespace
+{
+    //
+    // Structured exception handling cannot share a function with objects
+    // that have destructors, hence the plain function.
+    //
+    bool
+    copy_in_page(void* to, void const* from, std::size_t count) noexcept
+    {
+        __try
+        {
+            std::memcpy(to, from, count);
+            return true;
+        }
+        __except (::GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER
+                                                                    : EXCEPTION_CONTINUE_SEARCH)
+        {
+            return false;
+        }
+    }
+
+    DWORD
+    flags_for(m::filesystem::access_pattern pattern) noexcept
+    {
+        switch (pattern)
+        {
+            case m::filesystem::access_pattern::sequential:
+                return FILE_FLAG_SEQUENTIAL_SCAN;
+
+            case m::filesystem::access_pattern::random:
+                return FILE_FLAG_RANDOM_ACCESS;
+
+            default:
+                return FILE_ATTRIBUTE_NORMAL;
+        }
+    }
+
+    [[noreturn]] void
+    throw_last_error(char const* what)
+    {
+        throw std::system_error(m::make_win32_error_code(::GetLastError()), what);
+    }
+} // namespace
+
+namespace m::filesystem_impl::platform_specific
+{
+    file_mapping::file_mapping(std::filesystem::path const&              path,
+                               m::filesystem::mapped_file_options const& options):
+        m_guarded(options.m_truncation_policy == m::filesystem::truncation_policy::guard)
+    {
+        auto const file = ::CreateFileW(path.c_str(),
+                                        GENERIC_READ,
+                                        FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                        nullptr,
+                                        OPEN_EXISTING,
+                                        flags_for(options.m_access_pattern),
+                                        nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+            throw_last_error("CreateFileW");
+
+        LARGE_INTEGER size{};
+
+        if (!::GetFileSizeEx(file, &size))
+        {
+            auto const error = ::GetLastError();
+            ::CloseHandle(file);
+            throw std::system_error(m::make_win32_error_code(error), "GetFileSizeEx");
+        }
+
+        m_size = m::to<std::size_t>(size.QuadPart);
+
+        if (m_size == 0)
+        {
+            ::CloseHandle(file);
+            return;
+        }
+
+        auto const mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        auto const error   = ::GetLastError();
+
+        ::CloseHandle(file);
+
+        if (!mapping)
+            throw std::system_error(m::make_win32_error_code(error), "CreateFileMappingW");
+
+        auto const view      = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        auto const map_error = ::GetLastError();
+
+        ::CloseHandle(mapping);
+
+        if (!view)
+            throw std::system_error(m::make_win32_error_code(map_error), "MapViewOfFile");
+
+        m_base = static_cast<std::byte const*>(view);
+
+        if (options.m_access_pattern == m::filesystem::access_pattern::will_need)
+        {
+            WIN32_MEMORY_RANGE_ENTRY range{view, m_size};
+
+            // Only a hint, so failure is of no consequence
+            ::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0);
+        }
+    }
+
+    file_mapping::~file_mapping()
+    {
+        if (m_base)
+            ::UnmapViewOfFile(m_base);
+    }
+
+    void
+    file_mapping::copy(std::size_t offset, std::span<std::byte> to) const
+    {
+        if (!m_guarded)
+        {
+            std::memcpy(to.data(), m_base + offset, to.size());
+            return;
+        }
+
+        if (!copy_in_page(to.data(), m_base + offset, to.size()))
+            throw std::system_error(std::make_error_code(std::errc::io_error),
+                                    "mapped file could not be paged in");
+    }
+} // namespace m::filesystem_impl::platform_specific
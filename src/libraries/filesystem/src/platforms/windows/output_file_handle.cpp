@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <system_error>
+
+#include <Windows.h>
+
+#include <m/errors/errors.h>
+
+#include "output_file_handle.h"
+
+namespace
+{
+    [[noreturn]] void
+    throw_last_error(char const* what)
+    {
+        throw std::system_error(m::make_win32_error_code(::GetLastError()), what);
+    }
+} // namespace
+
+namespace m::filesystem_impl::platform_specific
+{
+    output_file_handle::output_file_handle(std::filesystem::path const& path)
+    {
+        auto const file = ::CreateFileW(path.c_str(),
+                                        GENERIC_WRITE,
+                                        FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                        nullptr,
+                                        CREATE_ALWAYS,
+                                        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                                        nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+            throw_last_error("CreateFileW");
+
+        m_handle = file;
+    }
+
+    output_file_handle::~output_file_handle()
+    {
+        if (m_handle)
+            ::CloseHandle(m_handle);
+    }
+
+    void
+    output_file_handle::preallocate(std::uint64_t size) noexcept
+    {
+        if (size == 0)
+            return;
+
+        FILE_ALLOCATION_INFO info{};
+        info.AllocationSize.QuadPart = static_cast<LONGLONG>(size);
+
+        ::SetFileInformationByHandle(m_handle, FileAllocationInfo, &info, sizeof(info));
+    }
+
+    void
+    output_file_handle::write(std::uint64_t                               position,
+                              std::span<std::span<std::byte const> const> buffers)
+    {
+        for (auto buffer: buffers)
+        {
+            while (!buffer.empty())
+            {
+                // WriteFile takes a DWORD count; keep well clear of it
+                constexpr std::size_t max_write = 1ull << 30;
+
+                auto const count = static_cast<DWORD>((std::min)(buffer.size(), max_write));
+                OVERLAPPED overlapped{};
+                DWORD      written{};
+
+                overlapped.Offset     = static_cast<DWORD>(position);
+                overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+                if (!::WriteFile(m_handle, buffer.data(), count, &written, &overlapped))
+                    throw_last_error("WriteFile");
+
+                position += written;
+                buffer    = buffer.subspan(written);
+            }
+        }
+    }
+} // namespace m::filesystem_impl::platform_specific
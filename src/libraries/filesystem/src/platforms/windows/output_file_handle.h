@@ -0,0 +1,50 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace m::filesystem_impl::platform_specific
+{
+    //
+    // A file handle opened for writing, created or truncated. Every write
+    // says where it goes (an OVERLAPPED offset), so the handle's own file
+    // pointer is never used.
+    //
+    class output_file_handle
+    {
+    public:
+        explicit output_file_handle(std::filesystem::path const& path);
+        output_file_handle(output_file_handle const&) = delete;
+        output_file_handle(output_file_handle&&)      = delete;
+        ~output_file_handle();
+
+        void
+        operator=(output_file_handle const&) = delete;
+
+        void
+        operator=(output_file_handle&&) = delete;
+
+        //
+        // Reserves `size` bytes of disk without changing the file's size
+        // (FILE_ALLOCATION_INFO). Only a hint; failure is ignored.
+        //
+        void
+        preallocate(std::uint64_t size) noexcept;
+
+        //
+        // Writes all of `buffers`, one after another, starting at
+        // `position`. Windows has no gathering write for ordinary buffered
+        // handles, so this is a WriteFile for each buffer.
+        //
+        void
+        write(std::uint64_t position, std::span<std::span<std::byte const> const> buffers);
+
+    protected:
+        void* m_handle{};
+    };
+} // namespace m::filesystem_impl::platform_specific
@@ -1,16 +1,107 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include <algorithm>
+#include <cerrno>
 #include <cstdio>
 #include <filesystem>
 #include <memory>
 #include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
 
 #include <m/cast/to.h>
 #include <m/filesystem/filesystem.h>
+#include <m/threadpool/threadpool.h>
 
 #include "seekable_input_file.h"
 
+#ifndef WIN32
+#include <climits>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "platforms/linux/async_reader.h"
+#endif
+
+#ifndef WIN32
+namespace
+{
+    //
+    // Reads a run of requests for adjacent ranges, in position order, with
+    // preadv, and trims each buffer to what it got.
+    //
+    void
+    read_run(int fd, std::span<m::byte_streams::read_request* const> run)
+    {
+        std::vector<iovec> iov;
+        iov.reserve(run.size());
+
+        std::size_t total{};
+
+        for (auto const r: run)
+        {
+            iov.push_back({r->m_buffer.data(), r->m_buffer.size()});
+            total += r->m_buffer.size();
+        }
+
+        auto const  start = std::to_underlying(run.front()->m_position);
+        std::size_t done{};
+        std::size_t first{}; // The first iovec not yet filled
+
+        while (done < total)
+        {
+            auto const n = ::preadv(fd,
+                                    iov.data() + first,
+                                    m::to<int>(iov.size() - first),
+                                    m::to<off_t>(start + done));
+
+            if (n == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                throw std::system_error(errno, std::generic_category(), "preadv");
+            }
+
+            if (n == 0)
+                break;
+
+            done += static_cast<std::size_t>(n);
+
+            // A short read; carry on from where it stopped
+            for (auto left = static_cast<std::size_t>(n); left != 0;)
+            {
+                auto& v = iov[first];
+
+                if (left < v.iov_len)
+                {
+                    v.iov_base = static_cast<std::byte*>(v.iov_base) + left;
+                    v.iov_len -= left;
+                    break;
+                }
+
+                left -= v.iov_len;
+                first++;
+            }
+        }
+
+        std::size_t offset{};
+
+        for (auto const r: run)
+        {
+            auto const size = r->m_buffer.size();
+            auto const got  = done > offset ? (std::min)(size, done - offset) : 0;
+
+            r->m_buffer = r->m_buffer.first(got);
+            offset += size;
+        }
+    }
+} // namespace
+#endif
+
 m::filesystem_impl::seekable_input_file::seekable_input_file(std::filesystem::path const& path):
     m_fp(nullptr), m_path(path)
 {
@@ -23,6 +114,10 @@ m::filesystem_impl::seekable_input_file::seekable_input_file(std::filesystem::pa
 #endif
     if (!m_fp)
         throw std::runtime_error("unable to open input file");
+
+#ifndef WIN32
+    m_fd = ::fileno(m_fp);
+#endif
 }
 
 m::filesystem_impl::seekable_input_file::seekable_input_file(seekable_input_file&& other) noexcept:
@@ -31,6 +126,7 @@ m::filesystem_impl::seekable_input_file::seekable_input_file(seekable_input_file
     using std::swap;
 
     swap(m_fp, other.m_fp);
+    swap(m_fd, other.m_fd);
     swap(m_path, other.m_path);
 }
 
@@ -59,9 +155,125 @@ m::filesystem_impl::seekable_input_file::do_read(std::span<std::byte>& span)
 std::size_t
 m::filesystem_impl::seekable_input_file::do_read(io::position_t p, std::span<std::byte>& span)
 {
+#ifdef WIN32
     auto const l = std::unique_lock(m_mutex);
     seek_to(p);
     return read(span);
+#else
+    //
+    // pread takes the offset as an argument and leaves the descriptor's
+    // file position, and with it the sequential cursor in m_fp, alone, so
+    // random access needs no lock and any number of threads may read the
+    // file at once.
+    //
+    std::size_t done{};
+
+    while (done < span.size())
+    {
+        auto const n = ::pread(m_fd,
+                               span.data() + done,
+                               span.size() - done,
+                               m::to<off_t>(std::to_underlying(p) + done));
+
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            throw std::system_error(errno, std::generic_category(), "pread");
+        }
+
+        if (n == 0)
+            break;
+
+        done += static_cast<std::size_t>(n);
+    }
+
+    span = span.first(done);
+    return done;
+#endif
+}
+
+void
+m::filesystem_impl::seekable_input_file::do_read_many(
+    std::span<byte_streams::read_request> requests)
+{
+    std::vector<byte_streams::read_request*> sorted;
+    sorted.reserve(requests.size());
+
+    for (auto& r: requests)
+        sorted.push_back(&r);
+
+    std::ranges::stable_sort(sorted, {}, &byte_streams::read_request::m_position);
+
+#ifdef WIN32
+    //
+    // No scatter read on a stdio stream, but the lock is taken once and
+    // the seeks run forwards.
+    //
+    auto const l = std::unique_lock(m_mutex);
+
+    for (auto const r: sorted)
+    {
+        seek_to(r->m_position);
+        read(r->m_buffer);
+    }
+#else
+    //
+    // Requests that pick up where the one before left off are merged into
+    // a single preadv; the decoders that batch their loads mostly ask for
+    // neighbouring fields, so a header becomes one system call.
+    //
+    for (std::size_t i = 0; i < sorted.size();)
+    {
+        auto j   = i + 1;
+        auto end = std::to_underlying(sorted[i]->m_position) + sorted[i]->m_buffer.size();
+
+        while (j < sorted.size() && j - i < IOV_MAX &&
+               std::to_underlying(sorted[j]->m_position) == end)
+        {
+            end += sorted[j]->m_buffer.size();
+            j++;
+        }
+
+        read_run(m_fd, std::span(sorted).subspan(i, j - i));
+        i = j;
+    }
+#endif
+}
+
+// byte_streams::async_ra_in
+void
+m::filesystem_impl::seekable_input_file::do_read_async(std::span<byte_streams::async_read> batch)
+{
+#ifdef WIN32
+    for (auto& r: batch)
+    {
+        m::threadpool->submit_blocking([self       = shared_from_this(),
+                                        position   = r.m_position,
+                                        buffer     = r.m_buffer,
+                                        completion = std::move(r.m_completion)]() mutable {
+            auto ec = std::error_code();
+
+            try
+            {
+                self->ra_in::read(position, buffer);
+            }
+            catch (std::system_error const& e)
+            {
+                ec = e.code();
+            }
+            catch (...)
+            {
+                ec = std::make_error_code(std::errc::io_error);
+            }
+
+            completion(ec, ec ? buffer.first(0) : buffer);
+        });
+    }
+#else
+    platform_specific::async_reader::get().read(m_fd, shared_from_this(), batch);
+#endif
 }
 
 std::size_t
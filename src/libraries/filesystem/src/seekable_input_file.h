@@ -14,7 +14,13 @@ namespace m
 {
     namespace filesystem_impl
     {
-        class seekable_input_file : public m::filesystem::seekable_input_file
+        //
+        // Always owned by a std::shared_ptr; asynchronous reads hold a
+        // reference so that the file stays open until they complete.
+        //
+        class seekable_input_file :
+            public m::filesystem::seekable_input_file,
+            public std::enable_shared_from_this<seekable_input_file>
         {
         public:
             seekable_input_file(std::filesystem::path const& path);
@@ -40,6 +46,13 @@ namespace m
             size_t
             do_read(io::position_t p, std::span<std::byte>& span) override;
 
+            void
+            do_read_many(std::span<byte_streams::read_request> requests) override;
+
+            // byte_streams::async_ra_in
+            void
+            do_read_async(std::span<byte_streams::async_read> batch) override;
+
             void
             do_seek(io::position_t p) override;
 
@@ -58,8 +71,11 @@ namespace m
             void
             seek_to(io::position_t p);
 
+            // Held by the sequential reads only, and by random access on
+            // Windows
             std::mutex            m_mutex;
             std::FILE*            m_fp;
+            int                   m_fd{-1}; // m_fp's descriptor, for pread
             std::filesystem::path m_path;
         };
     } // namespace filesystem_impl
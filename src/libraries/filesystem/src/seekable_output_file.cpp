@@ -69,7 +69,7 @@ m::filesystem_impl::seekable_output_file::do_write(io::position_t             p,
 void
 m::filesystem_impl::seekable_output_file::write(std::span<std::byte const> span)
 {
-    auto       l     = std::unique_lock(m_mutex);
+    // Called with m_mutex held
     auto const count = std::fwrite(span.data(), sizeof(std::byte), span.size(), m_fp);
     if (count < span.size())
         throw std::runtime_error("Failed writing to file");
@@ -78,6 +78,7 @@ m::filesystem_impl::seekable_output_file::write(std::span<std::byte const> span)
 void
 m::filesystem_impl::seekable_output_file::do_seek(io::position_t p)
 {
+    auto const l = std::unique_lock(m_mutex);
     seek_to(p);
 }
 
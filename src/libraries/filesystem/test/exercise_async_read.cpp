@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <latch>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#include <m/filesystem/filesystem.h>
+#include <m/threadpool/task.h>
+
+#include "test_files.h"
+
+namespace
+{
+    constexpr std::size_t file_size = 256 * 1024;
+    constexpr auto        file_name = "temporary_async_read_file";
+} // namespace
+
+TEST(async_read, batch)
+{
+    auto const     expected = test_file_contents(file_size);
+    temporary_file t(file_name, expected);
+    auto const     file     = m::filesystem::open_seekable_input_file(t.m_path);
+
+    constexpr std::size_t count = 300;
+    constexpr std::size_t size  = 4096;
+
+    std::vector<std::vector<std::byte>>      buffers(count, std::vector<std::byte>(size));
+    std::vector<m::byte_streams::async_read> batch;
+    std::atomic<std::size_t>                 mismatches{};
+    std::latch                               done(count);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        auto const position = i * 863;
+
+        batch.push_back({m::io::position_t{position},
+                         buffers[i],
+                         [&, position](std::error_code ec, std::span<std::byte> s) {
+                             auto const want  = (std::min)(size, file_size - position);
+                             auto const match = std::span(expected).subspan(position, want);
+
+                             if (ec || s.size() != want || !std::ranges::equal(s, match))
+                                 mismatches++;
+
+                             done.count_down();
+                         }});
+    }
+
+    file->read_async(batch);
+    done.wait();
+
+    EXPECT_EQ(mismatches.load(), 0u);
+}
+
+TEST(async_read, end_of_file)
+{
+    temporary_file t(file_name, test_file_contents(file_size));
+    auto const     file = m::filesystem::open_seekable_input_file(t.m_path);
+
+    std::vector<std::byte> buffer(100);
+    std::size_t            read{};
+    std::error_code        error;
+    std::latch             done(1);
+
+    file->read_async(m::io::position_t{file_size - 10},
+                     buffer,
+                     [&](std::error_code ec, std::span<std::byte> s) {
+                         error = ec;
+                         read  = s.size();
+                         done.count_down();
+                     });
+    done.wait();
+
+    EXPECT_FALSE(error);
+    EXPECT_EQ(read, 10u);
+}
+
+TEST(async_read, coroutine)
+{
+    auto const     expected = test_file_contents(file_size);
+    temporary_file t(file_name, expected);
+    auto const     file     = m::filesystem::open_seekable_input_file(t.m_path);
+
+    auto sum = [&]() -> m::task<std::size_t> {
+        std::vector<std::byte> buffer(1000);
+        std::size_t            total{};
+
+        for (std::size_t position = 0; position < file_size; position += buffer.size())
+        {
+            auto const n = co_await file->read_async(m::io::position_t{position}, buffer);
+
+            if (std::ranges::equal(std::span(buffer).first(n),
+                                   std::span(expected).subspan(position, n)))
+                total += n;
+        }
+
+        co_return total;
+    };
+
+    EXPECT_EQ(m::sync_wait(sum()), file_size);
+}
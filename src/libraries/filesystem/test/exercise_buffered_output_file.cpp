@@ -0,0 +1,176 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#include <m/byte_streams/memory_output_stream.h>
+#include <m/filesystem/filesystem.h>
+
+namespace
+{
+    struct temporary_path
+    {
+        temporary_path(): m_path(m::filesystem::make_path("temporary_buffered_output_file")) {}
+
+        ~temporary_path() { std::filesystem::remove(m_path); }
+
+        std::filesystem::path m_path;
+    };
+
+    std::vector<std::byte>
+    contents_of(std::filesystem::path const& path)
+    {
+        auto const file = m::filesystem::open_mapped_input_file(path);
+
+        std::vector<std::byte> v(file->size());
+        EXPECT_EQ(file->ra_in::read(m::io::position_t{0}, std::span(v)), v.size());
+
+        return v;
+    }
+} // namespace
+
+TEST(buffered_output_file, small_sequential_writes)
+{
+    temporary_path         t;
+    std::vector<std::byte> expected;
+
+    {
+        auto const file = m::filesystem::open_buffered_output_file(
+            t.m_path, {.m_buffer_size = 1000, .m_preallocate = 64 * 1024});
+
+        for (std::uint32_t i = 0; i < 10000; i++)
+        {
+            auto const bytes = std::as_bytes(std::span(&i, 1)).first(1 + i % 4);
+            file->seq_out::write(bytes);
+            expected.insert(expected.end(), bytes.begin(), bytes.end());
+        }
+
+        EXPECT_EQ(file->tell(), m::io::position_t{expected.size()});
+        file->flush();
+    }
+
+    // Preallocation does not show in the size
+    EXPECT_EQ(std::filesystem::file_size(t.m_path), expected.size());
+    EXPECT_EQ(contents_of(t.m_path), expected);
+}
+
+TEST(buffered_output_file, positioned_writes)
+{
+    temporary_path         t;
+    std::vector<std::byte> expected(5000);
+
+    {
+        auto const file =
+            m::filesystem::open_buffered_output_file(t.m_path, {.m_buffer_size = 256});
+
+        auto const write = [&](std::size_t position, std::size_t size, int value) {
+            std::vector<std::byte> bytes(size, static_cast<std::byte>(value));
+            file->ra_out::write(m::io::position_t{position}, std::span<std::byte const>(bytes));
+            std::ranges::copy(bytes, expected.begin() + position);
+        };
+
+        write(0, 4, 1);        // A header to patch later
+        write(4, 100, 2);      // Carries on in the buffer
+        write(104, 300, 3);    // Does not fit, goes out with the buffer
+        write(4000, 1000, 4);  // Bigger than the buffer, straight out
+        write(2000, 10, 5);    // Starts a new run
+        write(2005, 10, 6);    // Overlaps it
+        write(0, 4, 7);        // Patch the header, already written out
+        write(1000, 100, 8);   // Elsewhere
+        write(1010, 10, 9);    // Inside the buffered run
+    }
+
+    // Destruction flushed whatever was left
+    EXPECT_EQ(contents_of(t.m_path), expected);
+}
+
+TEST(buffered_output_file, gather_write_memory_output_stream)
+{
+    temporary_path                        t;
+    m::byte_streams::memory_output_stream rope(1000);
+    std::vector<std::byte>                expected;
+
+    for (std::uint32_t i = 0; i < 3000; i++)
+    {
+        rope.seq_out::write(std::as_bytes(std::span(&i, 1)));
+        expected.insert(expected.end(),
+                        std::as_bytes(std::span(&i, 1)).begin(),
+                        std::as_bytes(std::span(&i, 1)).end());
+    }
+
+    auto const chunks = rope.chunks();
+    EXPECT_EQ(chunks.size(), 12u);
+
+    {
+        auto const file =
+            m::filesystem::open_buffered_output_file(t.m_path, {.m_buffer_size = 4096});
+
+        auto const header = std::array{std::byte{'h'}, std::byte{'d'}, std::byte{'r'}};
+        file->seq_out::write(std::span<std::byte const>(header));
+        expected.insert(expected.begin(), header.begin(), header.end());
+
+        file->gather_write(chunks);
+        EXPECT_EQ(file->tell(), m::io::position_t{expected.size()});
+    }
+
+    EXPECT_EQ(contents_of(t.m_path), expected);
+}
+
+TEST(buffered_output_file, seek_and_write)
+{
+    temporary_path t;
+
+    {
+        auto const file = m::filesystem::open_buffered_output_file(t.m_path);
+
+        std::byte const                  bytes[3]{std::byte{'a'}, std::byte{'b'}, std::byte{'c'}};
+        std::span<std::byte const> const a(bytes);
+
+        file->seq_out::write(a);
+        file->seek(m::io::position_t{10});
+        file->seq_out::write(a);
+        file->seek(m::io::offset_t{-8});
+        file->seq_out::write(a.first(1));
+
+        EXPECT_EQ(file->tell(), m::io::position_t{6});
+        EXPECT_THROW(file->seek(m::io::offset_t{-7}), std::runtime_error);
+
+        file->flush();
+    }
+
+    auto const v = contents_of(t.m_path);
+
+    ASSERT_EQ(v.size(), 13u);
+    EXPECT_EQ(v[0], std::byte{'a'});
+    EXPECT_EQ(v[3], std::byte{});
+    EXPECT_EQ(v[5], std::byte{'a'});
+    EXPECT_EQ(v[12], std::byte{'c'});
+}
+
+TEST(buffered_output_file, failed_flush_keeps_the_run)
+{
+    // Every write to /dev/full fails with ENOSPC
+    auto const full = std::filesystem::path("/dev/full");
+
+    if (!std::filesystem::exists(full))
+        GTEST_SKIP() << "needs /dev/full";
+
+    auto const file = m::filesystem::open_buffered_output_file(full);
+
+    std::byte const bytes[3]{std::byte{'a'}, std::byte{'b'}, std::byte{'c'}};
+
+    file->seq_out::write(std::span<std::byte const>(bytes));
+
+    // Nothing was written, so the second flush has the same run to write
+    EXPECT_THROW(file->flush(), std::system_error);
+    EXPECT_THROW(file->flush(), std::system_error);
+}
@@ -0,0 +1,124 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#include <m/filesystem/filesystem.h>
+
+#include "test_files.h"
+
+namespace
+{
+    constexpr std::size_t file_size = 64 * 1024;
+    constexpr auto        file_name = "temporary_mapped_input_file";
+} // namespace
+
+TEST(mapped_input_file, random_access)
+{
+    auto const     expected = test_file_contents(file_size);
+    temporary_file t(file_name, expected);
+
+    auto const file = m::filesystem::open_mapped_input_file(
+        t.m_path, {.m_access_pattern = m::filesystem::access_pattern::random});
+
+    EXPECT_EQ(file->size(), file_size);
+
+    std::vector<std::byte> buffer(1000);
+
+    for (std::size_t position = 0; position < file_size; position += 4099)
+    {
+        auto const n    = file->ra_in::read(m::io::position_t{position}, std::span(buffer));
+        auto const want = (std::min)(buffer.size(), file_size - position);
+
+        ASSERT_EQ(n, want);
+        EXPECT_TRUE(std::ranges::equal(std::span(buffer).first(n),
+                                       std::span(expected).subspan(position, n)));
+    }
+
+    EXPECT_EQ(file->ra_in::read(m::io::position_t{file_size + 1}, std::span(buffer)), 0u);
+}
+
+TEST(mapped_input_file, sequential_and_seek)
+{
+    auto const     expected = test_file_contents(file_size);
+    temporary_file t(file_name, expected);
+
+    auto const file = m::filesystem::open_mapped_input_file(
+        t.m_path, {.m_access_pattern = m::filesystem::access_pattern::sequential});
+
+    std::vector<std::byte> all(file_size + 100);
+    auto const             n = file->seq_in::read(std::span(all));
+
+    EXPECT_EQ(n, file_size);
+    EXPECT_TRUE(std::ranges::equal(std::span(all).first(n), expected));
+    EXPECT_EQ(file->tell(), m::io::position_t{file_size});
+
+    file->seek(m::io::position_t{100});
+    file->seek(m::io::offset_t{-50});
+    EXPECT_EQ(file->tell(), m::io::position_t{50});
+
+    std::byte b{};
+    file->seq_in::read(b);
+    EXPECT_EQ(b, expected[50]);
+
+    EXPECT_THROW(file->seek(m::io::offset_t{-100}), std::runtime_error);
+}
+
+TEST(mapped_input_file, empty_file)
+{
+    temporary_file t(file_name, {});
+
+    auto const file = m::filesystem::open_mapped_input_file(t.m_path);
+
+    std::vector<std::byte> buffer(10);
+
+    EXPECT_EQ(file->size(), 0u);
+    EXPECT_EQ(file->ra_in::read(m::io::position_t{0}, std::span(buffer)), 0u);
+}
+
+TEST(mapped_input_file, views_outlive_the_file)
+{
+    auto const     expected = test_file_contents(file_size);
+    temporary_file t(file_name, expected);
+
+    auto file = m::filesystem::open_mapped_input_file(t.m_path);
+
+    auto const borrowed = file->borrow(m::io::position_t{1000}, 500);
+    EXPECT_TRUE(std::ranges::equal(borrowed, std::span(expected).subspan(1000, 500)));
+
+    EXPECT_EQ(file->borrow(m::io::position_t{file_size - 10}, 500).size(), 10u);
+    EXPECT_TRUE(file->borrow(m::io::position_t{file_size}, 500).empty());
+
+    auto const view = file->view(m::io::position_t{0}, file_size);
+
+    file.reset();
+
+    EXPECT_TRUE(std::ranges::equal(view.m_bytes, expected));
+}
+
+#ifndef WIN32
+TEST(mapped_input_file, truncation_is_guarded)
+{
+    temporary_file t(file_name, test_file_contents(file_size));
+
+    auto const file = m::filesystem::open_mapped_input_file(t.m_path);
+
+    std::filesystem::resize_file(t.m_path, 0);
+
+    std::vector<std::byte> buffer(100);
+
+    EXPECT_THROW((void)file->ra_in::read(m::io::position_t{32 * 1024}, std::span(buffer)),
+                 std::system_error);
+
+    // And the thread is none the worse for it
+    EXPECT_THROW((void)file->ra_in::read(m::io::position_t{0}, std::span(buffer)),
+                 std::system_error);
+}
+#endif
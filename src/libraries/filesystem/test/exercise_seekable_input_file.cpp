@@ -0,0 +1,117 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <m/filesystem/filesystem.h>
+
+#include "test_files.h"
+
+namespace
+{
+    constexpr std::size_t file_size = 64 * 1024;
+} // namespace
+
+TEST(seekable_input_file, concurrent_random_access)
+{
+    auto const     expected = test_file_contents(file_size);
+    temporary_file t("temporary_seekable_input_file", expected);
+
+    {
+        auto const file = m::filesystem::open_seekable_input_file(t.m_path);
+
+        std::atomic<std::size_t> mismatches{};
+        std::vector<std::thread> threads;
+
+        for (std::size_t t = 0; t < 8; t++)
+        {
+            threads.emplace_back([&, t]() {
+                std::vector<std::byte> buffer(509);
+
+                for (std::size_t i = 0; i < 500; i++)
+                {
+                    auto const position = (t * 7919 + i * 1543) % file_size;
+                    auto const want     = (std::min)(buffer.size(), file_size - position);
+                    auto const n =
+                        file->ra_in::read(m::io::position_t{position}, std::span(buffer));
+
+                    if (n != want || !std::ranges::equal(std::span(buffer).first(n),
+                                                         std::span(expected).subspan(position, n)))
+                        mismatches++;
+                }
+            });
+        }
+
+        //
+        // Random access must not move the sequential cursor
+        //
+        std::vector<std::byte> sequential(file_size);
+        std::size_t            total{};
+
+        while (total < file_size)
+        {
+            auto const n = file->seq_in::read(std::span(sequential).subspan(total, 1000));
+            if (n == 0)
+                break;
+
+            total += n;
+        }
+
+        for (auto& t: threads)
+            t.join();
+
+        EXPECT_EQ(mismatches.load(), 0u);
+        EXPECT_EQ(total, file_size);
+        EXPECT_TRUE(std::ranges::equal(sequential, expected));
+    }
+}
+
+TEST(seekable_input_file, read_many)
+{
+    auto const     expected = test_file_contents(file_size);
+    temporary_file t("temporary_seekable_input_file_read_many", expected);
+
+    {
+        auto const file = m::filesystem::open_seekable_input_file(t.m_path);
+
+        std::vector<std::byte> a(100), b(200), c(300), d(50), e(50), f(10);
+
+        //
+        // Out of order, partly adjacent (c follows b, b follows a), one
+        // that runs off the end and one entirely past it
+        //
+        std::vector<m::byte_streams::read_request> requests{
+            {m::io::position_t{5000}, std::span(c)},
+            {m::io::position_t{4700}, std::span(a)},
+            {m::io::position_t{file_size - 20}, std::span(d)},
+            {m::io::position_t{4800}, std::span(b)},
+            {m::io::position_t{100}, std::span(e)},
+            {m::io::position_t{file_size + 10}, std::span(f)},
+        };
+
+        file->read_many(requests);
+
+        std::size_t const sizes[]{300, 100, 20, 200, 50, 0};
+
+        for (std::size_t i = 0; i < requests.size(); i++)
+        {
+            auto const& r        = requests[i];
+            auto const  position = std::to_underlying(r.m_position);
+
+            ASSERT_EQ(r.m_buffer.size(), sizes[i]);
+
+            if (sizes[i] != 0)
+            {
+                EXPECT_TRUE(std::ranges::equal(
+                    r.m_buffer, std::span(expected).subspan(position, r.m_buffer.size())));
+            }
+        }
+    }
+}
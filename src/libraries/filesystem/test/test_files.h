@@ -0,0 +1,50 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <m/filesystem/filesystem.h>
+
+//
+// `size` bytes for the file reading tests to read back. The pattern does
+// not repeat at any buffer or block size the tests use, so a read from
+// the wrong offset shows up as a mismatch.
+//
+inline std::vector<std::byte>
+test_file_contents(std::size_t size)
+{
+    std::vector<std::byte> v(size);
+
+    for (std::size_t i = 0; i < v.size(); i++)
+        v[i] = static_cast<std::byte>(i * 13 + i / 241);
+
+    return v;
+}
+
+//
+// A file named `name` in the current directory holding `bytes`, removed
+// again when the object goes away.
+//
+struct temporary_file
+{
+    temporary_file(std::string_view name, std::span<std::byte const> bytes):
+        m_path(m::filesystem::make_path(name))
+    {
+        m::filesystem::store(m_path, bytes);
+    }
+
+    temporary_file(temporary_file const&) = delete;
+
+    ~temporary_file() { std::filesystem::remove(m_path); }
+
+    void
+    operator=(temporary_file const&) = delete;
+
+    std::filesystem::path m_path;
+};
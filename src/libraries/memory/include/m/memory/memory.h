@@ -5,14 +5,18 @@
 
 #include <array>
 #include <climits>
+#include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <exception>
 #include <functional>
 #include <limits>
 #include <map>
 #include <mutex>
+#include <span>
 #include <type_traits>
+#include <vector>
 
 #include <m/byte_streams/byte_streams.h>
 #include <m/math/math.h>
@@ -41,12 +45,39 @@ namespace m
     // WORDs, and character strings so this is not intended for general
     // purpose serialization / deserialization support as of yet.
     //
+
+    //
+    // A source whose static type lends its bytes out (byte_streams::
+    // ra_view_in) is copied from in place rather than through its read
+    // path. Returns whether all of `v` was there to load.
+    //
+    template <typename T, typename SourceT>
+    bool
+    load_object(T& v, SourceT& s, io::position_t p)
+    {
+        using source_type = std::remove_cvref_t<decltype(*s)>;
+
+        if constexpr (std::derived_from<source_type, byte_streams::ra_view_in>)
+        {
+            auto const bytes = s->borrow(p, sizeof(T));
+            if (bytes.size() != sizeof(T))
+                return false;
+
+            std::memcpy(&v, bytes.data(), sizeof(T));
+            return true;
+        }
+        else
+        {
+            return s->read(p, std::as_writable_bytes(std::span(&v, 1))) == sizeof(T);
+        }
+    }
+
     template <typename T, typename SourceT>
     T
     load_from(SourceT s, io::position_t p)
     {
         T v{};
-        if (s->read(p, std::as_writable_bytes(std::span(&v, 1))) != sizeof(T))
+        if (!load_object(v, s, p))
             throw std::runtime_error("end of file");
         return v;
     }
@@ -55,7 +86,7 @@ namespace m
     void
     load_into(T& v, SourceT s, io::position_t p)
     {
-        if (s->read(p, std::as_writable_bytes(std::span(&v, 1))) != sizeof(T))
+        if (!load_object(v, s, p))
             throw std::runtime_error("end of file");
     }
 
@@ -63,7 +94,7 @@ namespace m
     void
     load_into(T& v, SourceT s, io::position_t origin, std::size_t /* limit */)
     {
-        if (s->read(origin, std::as_writable_bytes(std::span(&v, 1))) != sizeof(T))
+        if (!load_object(v, s, origin))
             throw std::runtime_error("end of file");
     }
 
@@ -101,6 +132,49 @@ namespace m
     template <typename S>
     load_from_position_context(S, m::io::position_t) -> load_from_position_context<S>;
 
+    //
+    // Like load_from_position_context, except that load_into only notes
+    // where each object goes and load() then fetches them all with one
+    // ra_in::read_many, which a file-backed source turns into a handful of
+    // system calls instead of one per field. The objects must not be
+    // looked at until load() returns.
+    //
+    template <typename SourceT>
+    class gather_load_context
+    {
+    public:
+        using offset_t   = io::offset_t;
+        using position_t = io::position_t;
+
+        gather_load_context(SourceT s, position_t origin): m_s(s), m_origin(origin) {}
+
+        template <typename T>
+        void
+        load_into(T& v, offset_t offset)
+        {
+            m_requests.push_back({m_origin + offset, std::as_writable_bytes(std::span(&v, 1))});
+            m_sizes.push_back(sizeof(T));
+        }
+
+        void
+        load()
+        {
+            m_s->read_many(m_requests);
+
+            for (std::size_t i = 0; i < m_requests.size(); i++)
+            {
+                if (m_requests[i].m_buffer.size() != m_sizes[i])
+                    throw std::runtime_error("end of file");
+            }
+        }
+
+    private:
+        SourceT                                 m_s;
+        position_t                              m_origin;
+        std::vector<byte_streams::read_request> m_requests;
+        std::vector<std::size_t>                m_sizes;
+    };
+
     template <typename SourceT, typename TargetT>
     using data_member_loader_t = void (*)(TargetT&, load_from_position_context<SourceT> const&);
 
@@ -130,7 +130,7 @@ namespace m
             {
                 image_file_header ifh{};
 
-                m::load_from_position_context lfpc(s, origin);
+                m::gather_load_context lfpc(s, origin);
 
                 lfpc.load_into(ifh.m_machine, k_offset_machine);
                 lfpc.load_into(ifh.m_number_of_sections,
@@ -144,6 +144,8 @@ namespace m
                                image_file_header::k_offset_size_of_optional_header);
                 lfpc.load_into(ifh.m_characteristics, image_file_header::k_offset_characteristics);
 
+                lfpc.load();
+
                 return ifh;
             }
         };
@@ -136,11 +136,13 @@ namespace m
 
             template <typename SourceT>
             static image_optional_header64
-            load_from(SourceT s, typename SourceT::element_type::position_t origin, size_t limit)
+            load_from(SourceT                                    s,
+                      typename SourceT::element_type::position_t origin,
+                      size_t /* limit */)
             {
                 image_optional_header64 ioh{};
 
-                m::load_from_position_context lfpc(s, origin, limit);
+                m::gather_load_context lfpc(s, origin);
 
                 lfpc.load_into(ioh.m_magic, k_offset_magic);
                 lfpc.load_into(ioh.m_major_linker_version, k_offset_major_linker_version);
@@ -175,6 +177,8 @@ namespace m
                 lfpc.load_into(ioh.m_loader_flags, k_offset_loader_flags);
                 lfpc.load_into(ioh.m_number_of_rva_and_sizes, k_offset_number_of_rva_and_sizes);
 
+                lfpc.load();
+
                 return ioh;
             }
         };
@@ -288,11 +292,13 @@ namespace m
 
             template <typename SourceT>
             static image_optional_header32
-            load_from(SourceT s, typename SourceT::element_type::position_t origin, size_t limit)
+            load_from(SourceT                                    s,
+                      typename SourceT::element_type::position_t origin,
+                      size_t /* limit */)
             {
                 image_optional_header32 ioh{};
 
-                m::load_from_position_context lfpc(s, origin, limit);
+                m::gather_load_context lfpc(s, origin);
 
                 lfpc.load_into(ioh.m_magic, k_offset_magic);
                 lfpc.load_into(ioh.m_major_linker_version, k_offset_major_linker_version);
@@ -328,6 +334,8 @@ namespace m
                 lfpc.load_into(ioh.m_loader_flags, k_offset_loader_flags);
                 lfpc.load_into(ioh.m_number_of_rva_and_sizes, k_offset_number_of_rva_and_sizes);
 
+                lfpc.load();
+
                 return ioh;
             }
         };
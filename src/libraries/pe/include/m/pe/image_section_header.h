@@ -202,7 +202,7 @@ namespace m
             {
                 image_section_header ish{};
 
-                m::load_from_position_context lfpc(s, origin);
+                m::gather_load_context lfpc(s, origin);
 
                 lfpc.load_into(ish.m_name, k_offset_name + offset);
 
@@ -228,6 +228,8 @@ namespace m
 
                 lfpc.load_into(ish.m_characteristics, k_offset_characteristics + offset);
 
+                lfpc.load();
+
                 return ish;
             }
         };
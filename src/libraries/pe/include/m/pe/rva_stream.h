@@ -6,9 +6,13 @@
 #include <algorithm>
 #include <cstdint>
 #include <format>
+#include <limits>
+#include <memory>
 #include <span>
+#include <type_traits>
 #include <vector>
 
+#include <m/byte_streams/byte_streams.h>
 #include <m/cast/to.h>
 #include <m/utility/make_span.h>
 
@@ -39,16 +43,20 @@ namespace m
             };
 
             rva_ra_in(SourceT source, std::span<section_header_data const> const& section_headers):
-                m_source(source), m_section_headers(section_headers.begin(), section_headers.end())
+                m_source(source),
+                m_view(find_view(source)),
+                m_section_headers(section_headers.begin(), section_headers.end())
             {}
 
             rva_ra_in(SourceT source, std::span<section_header_data> const& section_headers):
-                m_source(source), m_section_headers(section_headers.begin(), section_headers.end())
+                m_source(source),
+                m_view(find_view(source)),
+                m_section_headers(section_headers.begin(), section_headers.end())
             {}
 
             template <typename Callable, typename... Args>
             rva_ra_in(SourceT source, std::size_t n, Callable f, Args... args):
-                m_source(source), m_section_headers(n)
+                m_source(source), m_view(find_view(source)), m_section_headers(n)
             {
                 for (std::size_t i = 0; i < n; i++)
                 {
@@ -169,6 +177,34 @@ namespace m
                 //
                 std::wstring result;
 
+                if (m_view)
+                {
+                    //
+                    // The source lends its bytes out, so look for the
+                    // terminator in place instead of copying the string
+                    // in 64 byte pieces.
+                    //
+                    auto const position = rva_to_position(rva);
+
+                    if (position == 0)
+                        throw std::runtime_error("bad pe - unmapped rva");
+
+                    auto const bytes =
+                        m_view->borrow(position, (std::numeric_limits<std::size_t>::max)());
+                    auto const end = std::ranges::find(bytes, std::byte{});
+
+                    if (end == bytes.end())
+                        throw std::runtime_error("end of file reached while loading string");
+
+                    result.reserve(static_cast<std::size_t>(end - bytes.begin()));
+
+                    std::for_each(bytes.begin(), end, [&](std::byte b) {
+                        result.push_back(static_cast<wchar_t>(b));
+                    });
+
+                    return result;
+                }
+
                 for (;;)
                 {
                     std::array<std::byte, 64> buffer;
@@ -198,7 +234,23 @@ namespace m
             }
 
         private:
+            //
+            // The source's ra_view_in side, if it has one, found once here
+            // rather than on every load.
+            //
+            static m::byte_streams::ra_view_in*
+            find_view(SourceT const& source) noexcept
+            {
+                using source_type = std::remove_cvref_t<decltype(*source)>;
+
+                if constexpr (std::is_polymorphic_v<source_type>)
+                    return dynamic_cast<m::byte_streams::ra_view_in*>(std::to_address(source));
+                else
+                    return nullptr;
+            }
+
             SourceT                          m_source;
+            m::byte_streams::ra_view_in*     m_view;
             std::vector<section_header_data> m_section_headers;
         };
 
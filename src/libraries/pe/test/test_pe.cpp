@@ -67,6 +67,92 @@ TEST(OpeningHelloWorld, BasicOpenTest)
     std::wcout << std::format(L"Here's a dump of Hello World: {}\n", *(pe.get()));
 }
 
+namespace
+{
+    // Hides the memory stream's ra_view_in so the decoder copies every read
+    class copying_ra_in : public m::byte_streams::ra_in
+    {
+    public:
+        explicit copying_ra_in(std::shared_ptr<m::byte_streams::ra_in> inner): m_inner(inner) {}
+
+    protected:
+        std::size_t
+        do_read(position_t position, std::span<std::byte>& s) override
+        {
+            return m_inner->read(position, s);
+        }
+
+        std::shared_ptr<m::byte_streams::ra_in> m_inner;
+    };
+} // namespace
+
+TEST(OpeningHelloWorld, ViewsAndCopiesDecodeAlike)
+{
+    static std::array<unsigned char const, 42496> hello_world_array
+#include "helloworld.h"
+        ;
+
+    auto stream = m::byte_streams::make_memory_based_byte_stream(hello_world_array.data(),
+                                                                 hello_world_array.size());
+
+    auto viewed = std::make_shared<m::pe::decoder>(stream);
+    auto copied = std::make_shared<m::pe::decoder>(std::make_shared<copying_ra_in>(stream));
+
+    ASSERT_FALSE(viewed->m_image_import_descriptors.empty());
+    ASSERT_EQ(viewed->m_image_import_descriptors.size(),
+              copied->m_image_import_descriptors.size());
+
+    for (std::size_t i = 0; i < viewed->m_image_import_descriptors.size(); i++)
+    {
+        if (viewed->m_image_import_descriptors[i].m_name != m::pe::rva_t{0})
+            EXPECT_FALSE(viewed->m_image_import_descriptors[i].m_name_string.empty());
+
+        EXPECT_EQ(viewed->m_image_import_descriptors[i].m_name_string,
+                  copied->m_image_import_descriptors[i].m_name_string);
+    }
+}
+
+//
+// A file stream gathers each header's fields with one read_many; what it
+// decodes must match the memory stream, which reads field by field.
+//
+TEST(OpeningHelloWorld, FromAFile)
+{
+    static std::array<unsigned char const, 42496> hello_world_array
+#include "helloworld.h"
+        ;
+
+    auto const path = m::filesystem::make_path("temporary_hello_world");
+    m::filesystem::store(path, std::as_bytes(std::span(hello_world_array)));
+
+    {
+        auto const stream = m::byte_streams::make_memory_based_byte_stream(
+            hello_world_array.data(), hello_world_array.size());
+
+        auto memory = std::make_shared<m::pe::decoder>(stream);
+        auto file = std::make_shared<m::pe::decoder>(m::filesystem::open_seekable_input_file(path));
+
+        EXPECT_EQ(file->m_image_file_header.m_time_date_stamp,
+                  memory->m_image_file_header.m_time_date_stamp);
+        EXPECT_EQ(file->m_size_of_image, memory->m_size_of_image);
+        EXPECT_EQ(file->m_size_of_headers, memory->m_size_of_headers);
+        ASSERT_EQ(file->m_section_headers.size(), memory->m_section_headers.size());
+
+        for (std::size_t i = 0; i < file->m_section_headers.size(); i++)
+        {
+            EXPECT_EQ(file->m_section_headers[i].m_virtual_address,
+                      memory->m_section_headers[i].m_virtual_address);
+            EXPECT_EQ(file->m_section_headers[i].m_pointer_to_raw_data,
+                      memory->m_section_headers[i].m_pointer_to_raw_data);
+        }
+
+        ASSERT_EQ(file->m_image_import_descriptors.size(),
+                  memory->m_image_import_descriptors.size());
+    }
+
+    std::filesystem::remove(path);
+}
+
 TEST(TestFormatters, TestImageMagicFormatter)
 {
     m::pe::image_magic_t magic = m::pe::image_magic_t::pe32;
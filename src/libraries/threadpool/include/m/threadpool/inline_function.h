@@ -0,0 +1,161 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace m::threadpool_impl
+{
+    template <typename Signature, std::size_t Capacity>
+    class inline_function;
+
+    //
+    // A move-only callable wrapper like std::move_only_function except that
+    // callables of up to `Capacity` bytes are always stored inside the
+    // wrapper itself. Larger ones, or ones that may throw when moved, go on
+    // the heap.
+    //
+    // Timers keep their callbacks in one of these so that creating a timer
+    // for the usual small lambda does not allocate.
+    //
+    template <typename R, typename... Args, std::size_t Capacity>
+    class inline_function<R(Args...), Capacity>
+    {
+    public:
+        inline_function() noexcept = default;
+
+        template <typename F>
+            requires(!std::same_as<std::remove_cvref_t<F>, inline_function> &&
+                     std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+        inline_function(F&& f)
+        {
+            using T = std::decay_t<F>;
+
+            if constexpr (stored_inline<T>)
+                ::new (static_cast<void*>(m_storage)) T(std::forward<F>(f));
+            else
+                ::new (static_cast<void*>(m_storage)) T*(new T(std::forward<F>(f)));
+
+            m_operations = &operations_for<T>;
+        }
+
+        inline_function(inline_function&& other) noexcept
+        {
+            take(other);
+        }
+
+        inline_function(inline_function const&) = delete;
+
+        ~inline_function()
+        {
+            reset();
+        }
+
+        inline_function&
+        operator=(inline_function&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                take(other);
+            }
+
+            return *this;
+        }
+
+        void
+        operator=(inline_function const&) = delete;
+
+        explicit
+        operator bool() const noexcept
+        {
+            return m_operations != nullptr;
+        }
+
+        R
+        operator()(Args... args)
+        {
+            return m_operations->m_invoke(m_storage, std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        static constexpr bool stored_inline = sizeof(T) <= Capacity &&
+                                              alignof(T) <= alignof(std::max_align_t) &&
+                                              std::is_nothrow_move_constructible_v<T>;
+
+    private:
+        struct operations
+        {
+            R (*m_invoke)(void* storage, Args&&... args);
+
+            // Move constructs into `to` and destroys what is at `from`
+            void (*m_relocate)(void* from, void* to) noexcept;
+
+            void (*m_destroy)(void* storage) noexcept;
+        };
+
+        template <typename T>
+        static T&
+        target(void* storage) noexcept
+        {
+            if constexpr (stored_inline<T>)
+                return *std::launder(static_cast<T*>(storage));
+            else
+                return **std::launder(static_cast<T**>(storage));
+        }
+
+        template <typename T>
+        static constexpr operations operations_for{
+            [](void* storage, Args&&... args) -> R {
+                return static_cast<R>(std::invoke(target<T>(storage), std::forward<Args>(args)...));
+            },
+            [](void* from, void* to) noexcept {
+                if constexpr (stored_inline<T>)
+                {
+                    auto& source = target<T>(from);
+                    ::new (to) T(std::move(source));
+                    source.~T();
+                }
+                else
+                {
+                    ::new (to) T*(*std::launder(static_cast<T**>(from)));
+                }
+            },
+            [](void* storage) noexcept {
+                if constexpr (stored_inline<T>)
+                    target<T>(storage).~T();
+                else
+                    delete *std::launder(static_cast<T**>(storage));
+            },
+        };
+
+        void
+        take(inline_function& other) noexcept
+        {
+            if (other.m_operations)
+            {
+                other.m_operations->m_relocate(other.m_storage, m_storage);
+                m_operations = std::exchange(other.m_operations, nullptr);
+            }
+        }
+
+        void
+        reset() noexcept
+        {
+            if (m_operations)
+                std::exchange(m_operations, nullptr)->m_destroy(m_storage);
+        }
+
+        static constexpr std::size_t storage_size =
+            Capacity < sizeof(void*) ? sizeof(void*) : Capacity;
+
+        alignas(std::max_align_t) std::byte m_storage[storage_size];
+        operations const* m_operations{};
+    };
+} // namespace m::threadpool_impl
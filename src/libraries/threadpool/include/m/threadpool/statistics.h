@@ -0,0 +1,223 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace m
+{
+    /// <summary>
+    /// Distribution of durations, in buckets whose bounds are powers of
+    /// two microseconds: bucket 0 counts durations under 1us and bucket
+    /// `i` those in [2^(i-1), 2^i) microseconds. The last bucket also takes
+    /// everything longer.
+    /// </summary>
+    struct latency_histogram
+    {
+        using duration = std::chrono::microseconds;
+
+        static constexpr std::size_t bucket_count = 40;
+
+        std::array<std::uint64_t, bucket_count> m_buckets{};
+        std::uint64_t                           m_count{};
+        duration                                m_total{};
+        duration                                m_max{};
+
+        duration
+        mean() const noexcept
+        {
+            return m_count == 0 ? duration::zero()
+                                : m_total / static_cast<duration::rep>(m_count);
+        }
+
+        /// <summary>
+        /// An upper bound for the `p`th quantile (0 to 1), e.g. 0.99 for
+        /// the 99th percentile: the upper end of the bucket it falls in.
+        /// </summary>
+        duration
+        percentile(double p) const noexcept;
+    };
+
+    /// <summary>
+    /// What happened to one class of work: how long items waited in the
+    /// queue before a worker started them, how long they ran, and how many
+    /// are waiting or running right now.
+    /// </summary>
+    struct work_statistics
+    {
+        latency_histogram m_queue_wait;
+        latency_histogram m_run_time;
+        std::size_t       m_queued{};
+        std::size_t       m_running{};
+        std::uint64_t     m_completed{};
+    };
+
+    /// <summary>
+    /// A snapshot of a threadpool's instrumentation, from
+    /// `threadpool_class::statistics()`. Everything is counted from the
+    /// creation of the pool.
+    /// </summary>
+    struct threadpool_statistics
+    {
+        // CPU work, indexed by work_priority
+        std::array<work_statistics, 3> m_by_priority;
+
+        // Work submitted with submit_blocking()
+        work_statistics m_blocking;
+
+        // Only filled in when the pool was created with
+        // threadpool_options::m_statistics_by_description
+        std::map<std::wstring, work_statistics, std::less<>> m_by_description;
+
+        // How long after its deadline each timer callback actually started
+        latency_histogram m_timer_lateness;
+
+        std::size_t               m_workers{};
+        std::chrono::microseconds m_uptime{};
+        std::chrono::microseconds m_busy_time{};
+        std::uint64_t             m_steals{};
+
+        // How the CPU worker threads came and went, on platforms where the
+        // pool manages them itself. m_worker_target is the number of
+        // workers not in a blocking_region that the pool aims for.
+        std::size_t   m_worker_threads{};
+        std::size_t   m_worker_target{};
+        std::size_t   m_blocked_workers{};
+        std::uint64_t m_threads_started{};
+        std::uint64_t m_threads_retired{};
+        std::uint64_t m_compensating_threads{};
+        std::uint64_t m_target_raised{};
+        std::uint64_t m_target_lowered{};
+
+        /// <summary>
+        /// The fraction of the CPU workers' time spent running work.
+        /// </summary>
+        double
+        busy_fraction() const noexcept
+        {
+            auto const available = static_cast<double>(m_uptime.count()) * m_workers;
+            return available == 0 ? 0.0 : static_cast<double>(m_busy_time.count()) / available;
+        }
+    };
+
+    namespace threadpool_impl
+    {
+        //
+        // Collects the numbers behind threadpool_statistics. Recording is a
+        // handful of relaxed atomic increments, apart from per description
+        // statistics which take a lock and are off by default.
+        //
+        // Work is recorded under a category: one per work_priority, then
+        // blocking_category.
+        //
+        class statistics_recorder
+        {
+        public:
+            using clock = std::chrono::steady_clock;
+
+            static constexpr std::size_t blocking_category = 3;
+            static constexpr std::size_t category_count    = 4;
+
+            explicit statistics_recorder(bool by_description = false);
+
+            statistics_recorder(statistics_recorder const&) = delete;
+
+            void
+            operator=(statistics_recorder const&) = delete;
+
+            void
+            queued(std::size_t category) noexcept;
+
+            // Takes back a queued() for work that could not be submitted
+            void
+            abandoned(std::size_t category) noexcept;
+
+            void
+            started(std::size_t category, clock::duration queue_wait) noexcept;
+
+            void
+            finished(std::size_t       category,
+                     clock::duration   queue_wait,
+                     clock::duration   run_time,
+                     std::wstring_view description) noexcept;
+
+            void
+            stolen(std::uint64_t count = 1) noexcept;
+
+            void
+            timer_fired(clock::duration lateness) noexcept;
+
+            void
+            workers_changed(std::size_t threads, std::size_t target, std::size_t blocked) noexcept;
+
+            // `compensating` if only started for other workers being blocked
+            void
+            thread_started(bool compensating) noexcept;
+
+            void
+            thread_retired() noexcept;
+
+            void
+            target_changed(std::size_t from, std::size_t to) noexcept;
+
+            threadpool_statistics
+            snapshot(std::size_t workers) const;
+
+        private:
+            using counter = std::atomic<std::uint64_t>;
+
+            class histogram
+            {
+            public:
+                void
+                record(clock::duration d) noexcept;
+
+                latency_histogram
+                load() const noexcept;
+
+            private:
+                std::array<counter, latency_histogram::bucket_count> m_buckets{};
+                counter                                              m_count{};
+                counter                                              m_total{}; // us
+                counter                                              m_max{};   // us
+            };
+
+            struct category
+            {
+                histogram                m_queue_wait;
+                histogram                m_run_time;
+                std::atomic<std::size_t> m_queued{};
+                std::atomic<std::size_t> m_running{};
+                counter                  m_completed{};
+            };
+
+            std::array<category, category_count> m_categories;
+            histogram                            m_timer_lateness;
+            counter                              m_steals{};
+            counter                              m_busy_time{}; // us
+            std::atomic<std::size_t>             m_worker_threads{};
+            std::atomic<std::size_t>             m_worker_target{};
+            std::atomic<std::size_t>             m_blocked_workers{};
+            counter                              m_threads_started{};
+            counter                              m_threads_retired{};
+            counter                              m_compensating_threads{};
+            counter                              m_target_raised{};
+            counter                              m_target_lowered{};
+            clock::time_point                    m_created;
+            bool                                 m_by_description;
+
+            mutable std::mutex                                   m_description_mutex;
+            std::map<std::wstring, work_statistics, std::less<>> m_descriptions;
+        };
+    } // namespace threadpool_impl
+} // namespace m
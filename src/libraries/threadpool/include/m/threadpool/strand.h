@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include <m/threadpool/threadpool.h>
+
+namespace m
+{
+    /// <summary>
+    /// A serial queue on a threadpool. Work posted to a strand runs on the
+    /// pool in the order it was posted and never concurrently with other
+    /// work posted to the same strand, so e.g. the handlers for one
+    /// connection need no lock of their own.
+    ///
+    /// A strand only occupies a pool thread while it has work. Posting is
+    /// lock free: one atomic exchange, plus a submission to the pool when
+    /// the strand was idle. A busy strand hands itself back to the pool
+    /// every so often so that it cannot monopolize a worker.
+    ///
+    /// Create strands with `threadpool_class::make_strand`.
+    /// </summary>
+    class strand : public std::enable_shared_from_this<strand>
+    {
+    public:
+        strand(threadpool_class& pool, work_priority priority) noexcept;
+
+        strand(strand const&) = delete;
+
+        void
+        operator=(strand const&) = delete;
+
+        /// <summary>
+        /// Queues `f` to run after everything posted before it. An exception escaping `f`
+        /// is dropped, and the strand goes on with the next item.
+        /// </summary>
+        template <typename F>
+        void
+        post(F&& f)
+        {
+            enqueue(std::make_unique<node>(std::move_only_function<void()>(std::forward<F>(f))));
+        }
+
+        /// <summary>
+        /// Whether the calling thread is running work posted to this strand.
+        /// </summary>
+        bool
+        running_in_this_thread() const noexcept;
+
+    private:
+        struct node
+        {
+            explicit node(std::move_only_function<void()>&& work): m_work(std::move(work)) {}
+
+            std::move_only_function<void()> m_work;
+            std::atomic<node*>              m_next{};
+        };
+
+        void
+        enqueue(std::unique_ptr<node> n);
+
+        // Whether a pool thread will go on to run `head` and what follows
+        bool
+        try_schedule(node* head) noexcept;
+
+        void
+        drain(node* head);
+
+        threadpool_class* m_pool;
+        work_priority     m_priority;
+
+        //
+        // The most recently posted item, which the drainer unlinks last.
+        // Null exactly when the strand is idle; whoever makes it non-null
+        // becomes responsible for draining.
+        //
+        std::atomic<node*> m_tail{};
+    };
+} // namespace m
@@ -0,0 +1,355 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace m
+{
+    namespace threadpool_impl
+    {
+        //
+        // Coroutine frames are allocated from per-thread free lists of a
+        // few size classes so that the steady state of a pipeline of tasks
+        // does not go to the general purpose heap. Frames larger than the
+        // largest size class fall back to ::operator new.
+        //
+        void*
+        allocate_frame(std::size_t size);
+
+        void
+        deallocate_frame(void* p, std::size_t size) noexcept;
+
+        class task_promise_base
+        {
+        public:
+            static void*
+            operator new(std::size_t size)
+            {
+                return allocate_frame(size);
+            }
+
+            static void
+            operator delete(void* p, std::size_t size) noexcept
+            {
+                deallocate_frame(p, size);
+            }
+
+            std::suspend_always
+            initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            //
+            // Resumes whoever awaited the task by returning its handle
+            // (symmetric transfer) so that long chains of tasks completing
+            // synchronously do not grow the stack.
+            //
+            struct final_awaiter
+            {
+                bool
+                await_ready() noexcept
+                {
+                    return false;
+                }
+
+                template <typename Promise>
+                std::coroutine_handle<>
+                await_suspend(std::coroutine_handle<Promise> h) noexcept
+                {
+                    if (auto const continuation = h.promise().m_continuation)
+                        return continuation;
+
+                    return std::noop_coroutine();
+                }
+
+                void
+                await_resume() noexcept
+                {}
+            };
+
+            final_awaiter
+            final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void
+            unhandled_exception() noexcept
+            {
+                m_exception = std::current_exception();
+            }
+
+            std::coroutine_handle<> m_continuation;
+            std::exception_ptr      m_exception;
+        };
+
+        template <typename T>
+        class task_promise : public task_promise_base
+        {
+        public:
+            template <typename U>
+                requires std::is_convertible_v<U&&, T>
+            void
+            return_value(U&& value)
+            {
+                m_value.emplace(std::forward<U>(value));
+            }
+
+            T
+            result()
+            {
+                if (m_exception)
+                    std::rethrow_exception(m_exception);
+
+                return std::move(*m_value);
+            }
+
+            std::optional<T> m_value;
+        };
+
+        template <>
+        class task_promise<void> : public task_promise_base
+        {
+        public:
+            void
+            return_void() noexcept
+            {}
+
+            void
+            result()
+            {
+                if (m_exception)
+                    std::rethrow_exception(m_exception);
+            }
+        };
+    } // namespace threadpool_impl
+
+    /// <summary>
+    /// A lazily started coroutine producing a `T`.
+    ///
+    /// The body does not run until the task is awaited; the awaiting
+    /// coroutine is resumed directly when the body finishes. Use
+    /// `co_await m::threadpool->schedule()` inside the body to move it onto
+    /// the threadpool and `sync_wait` to run a task from ordinary code.
+    /// </summary>
+    template <typename T = void>
+    class [[nodiscard]] task
+    {
+    public:
+        class promise_type : public threadpool_impl::task_promise<T>
+        {
+        public:
+            task
+            get_return_object() noexcept
+            {
+                return task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+        };
+
+        task() = default;
+
+        task(task&& other) noexcept: m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+        task(task const&) = delete;
+
+        ~task()
+        {
+            if (m_handle)
+                m_handle.destroy();
+        }
+
+        task&
+        operator=(task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (m_handle)
+                    m_handle.destroy();
+
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+
+            return *this;
+        }
+
+        void
+        operator=(task const&) = delete;
+
+        struct awaiter
+        {
+            bool
+            await_ready() noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                m_handle.promise().m_continuation = awaiting;
+                return m_handle;
+            }
+
+            T
+            await_resume()
+            {
+                return m_handle.promise().result();
+            }
+
+            std::coroutine_handle<promise_type> m_handle;
+        };
+
+        awaiter
+        operator co_await() && noexcept
+        {
+            return awaiter{m_handle};
+        }
+
+    private:
+        explicit task(std::coroutine_handle<promise_type> handle) noexcept: m_handle(handle) {}
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    namespace threadpool_impl
+    {
+        //
+        // Eagerly started coroutine that sync_wait uses to await a task and
+        // signal the blocked thread. It destroys itself when done.
+        //
+        struct sync_wait_driver
+        {
+            struct promise_type
+            {
+                sync_wait_driver
+                get_return_object() noexcept
+                {
+                    return {};
+                }
+
+                std::suspend_never
+                initial_suspend() noexcept
+                {
+                    return {};
+                }
+
+                std::suspend_never
+                final_suspend() noexcept
+                {
+                    return {};
+                }
+
+                void
+                return_void() noexcept
+                {}
+
+                void
+                unhandled_exception() noexcept
+                {
+                    std::terminate();
+                }
+            };
+        };
+
+        //
+        // The blocked thread waits on a condition variable rather than an
+        // atomic because the driver still touches the state after waking
+        // it; notifying under the lock keeps sync_wait from returning, and
+        // destroying the state, until the driver has let go of it.
+        //
+        struct sync_wait_state
+        {
+            void
+            signal()
+            {
+                auto l = std::unique_lock(m_mutex);
+                m_done = true;
+                m_cv.notify_all();
+            }
+
+            void
+            wait()
+            {
+                auto l = std::unique_lock(m_mutex);
+                m_cv.wait(l, [this]() { return m_done; });
+
+                if (m_exception)
+                    std::rethrow_exception(m_exception);
+            }
+
+            std::mutex              m_mutex;
+            std::condition_variable m_cv;
+            bool                    m_done{false};
+            std::exception_ptr      m_exception;
+        };
+
+        template <typename T>
+        sync_wait_driver
+        drive(task<T>& t, std::optional<T>& result, sync_wait_state& state)
+        {
+            try
+            {
+                result.emplace(co_await std::move(t));
+            }
+            catch (...)
+            {
+                state.m_exception = std::current_exception();
+            }
+
+            state.signal();
+        }
+
+        inline sync_wait_driver
+        drive(task<void>& t, sync_wait_state& state)
+        {
+            try
+            {
+                co_await std::move(t);
+            }
+            catch (...)
+            {
+                state.m_exception = std::current_exception();
+            }
+
+            state.signal();
+        }
+    } // namespace threadpool_impl
+
+    /// <summary>
+    /// Runs `t` to completion, blocking the calling thread, and returns its
+    /// result. Must not be called from a threadpool thread that the task
+    /// itself needs in order to make progress.
+    /// </summary>
+    template <typename T>
+    T
+    sync_wait(task<T> t)
+    {
+        threadpool_impl::sync_wait_state state;
+
+        if constexpr (std::is_void_v<T>)
+        {
+            threadpool_impl::drive(t, state);
+            state.wait();
+        }
+        else
+        {
+            std::optional<T> result;
+
+            threadpool_impl::drive(t, result, state);
+            state.wait();
+
+            return std::move(*result);
+        }
+    }
+} // namespace m
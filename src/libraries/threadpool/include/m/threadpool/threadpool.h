@@ -3,12 +3,26 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <format>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include <m/threadpool/inline_function.h>
+#include <m/threadpool/statistics.h>
 #include <m/utility/pointers.h>
 
 namespace m
@@ -18,6 +32,115 @@ namespace m
         using duration = std::chrono::microseconds;
     }
 
+    //
+    // What a periodic timer does about ticks that went by while its callback
+    // was still running (or the process was not scheduled).
+    //
+    enum class missed_tick_policy
+    {
+        // Drop the missed ticks; the next callback happens at the next tick
+        // on the schedule that is still in the future.
+        skip,
+
+        // Run one callback for every missed tick, back to back, until the
+        // timer is on schedule again.
+        catch_up,
+    };
+
+    //
+    // Relative urgency of work submitted to the threadpool. Queued work of
+    // a higher priority is always started before any of a lower one.
+    //
+    enum class work_priority
+    {
+        high,
+        normal,
+        low,
+    };
+
+    //
+    // Where a threadpool's CPU workers run.
+    //
+    enum class worker_placement
+    {
+        // Wherever the operating system schedules them
+        unpinned,
+
+        // Each worker is pinned to one CPU
+        per_core,
+
+        // Each worker is pinned to the CPUs of one NUMA node, and work is
+        // queued per node
+        per_node,
+    };
+
+    //
+    // Readiness of a file descriptor, for threadpool_class::wait_for_fd.
+    // Values may be combined with |.
+    //
+    enum class fd_events : unsigned
+    {
+        none     = 0,
+        readable = 1,
+        writable = 2,
+
+        // Only ever reported: the descriptor is in an error state or the
+        // other end hung up. Reads or writes will say which.
+        error = 4,
+    };
+
+    constexpr fd_events
+    operator|(fd_events l, fd_events r) noexcept
+    {
+        return static_cast<fd_events>(static_cast<unsigned>(l) | static_cast<unsigned>(r));
+    }
+
+    constexpr fd_events
+    operator&(fd_events l, fd_events r) noexcept
+    {
+        return static_cast<fd_events>(static_cast<unsigned>(l) & static_cast<unsigned>(r));
+    }
+
+    struct threadpool_options
+    {
+        // Number of CPU workers; zero means one per usable CPU when the
+        // workers are pinned and the platform's default otherwise
+        std::size_t      m_worker_count{};
+        worker_placement m_placement{worker_placement::unpinned};
+
+        // The most CPU workers an unpinned pool may grow to, adding workers
+        // only while doing so raises throughput. Anything up to
+        // m_worker_count keeps the count fixed. Pinned pools never grow.
+        std::size_t m_max_worker_count{};
+
+        // How long a CPU worker beyond m_worker_count may sit idle before
+        // it exits
+        std::chrono::milliseconds m_idle_timeout{std::chrono::seconds(20)};
+
+        // Break threadpool_statistics down by task and timer description
+        bool m_statistics_by_description{false};
+    };
+
+    /// <summary>
+    /// Marks the calling thread as blocked (e.g. waiting for I/O or a lock
+    /// held for a long time) for the lifetime of the object. When this is
+    /// a threadpool worker, the pool may start another worker so that
+    /// queued work keeps running, and retires the extra worker again once
+    /// it is no longer needed. Regions may nest. Elsewhere this does
+    /// nothing.
+    /// </summary>
+    class blocking_region
+    {
+    public:
+        blocking_region() noexcept;
+        ~blocking_region();
+
+        blocking_region(blocking_region const&) = delete;
+
+        void
+        operator=(blocking_region const&) = delete;
+    };
+
     class timer
     {
     public:
@@ -53,7 +176,43 @@ namespace m
         void
         set(std::chrono::duration<Rep, Period> dur)
         {
-            do_set(std::chrono::duration_cast<duration>(dur));
+            do_set(std::chrono::duration_cast<duration>(dur), duration::zero());
+        }
+
+        /// <summary>
+        /// As `set`, but the timer may fire at any point up to `tolerance`
+        /// after `dur` has elapsed. Timers whose windows overlap are
+        /// expired together which saves wakeups when there are many of
+        /// them, e.g. retries and idle sweeps. A timer never fires early.
+        /// </summary>
+        template <typename Rep, typename Period, typename TolRep, typename TolPeriod>
+        void
+        set(std::chrono::duration<Rep, Period>       dur,
+            std::chrono::duration<TolRep, TolPeriod> tolerance)
+        {
+            do_set(std::chrono::duration_cast<duration>(dur),
+                   std::chrono::duration_cast<duration>(tolerance));
+        }
+
+        /// <summary>
+        /// Fires the timer `phase` from now and then every `period` after
+        /// that. Ticks are computed from that first deadline, not from when
+        /// the previous callback ran, so callback runtime and scheduling
+        /// jitter do not accumulate. Callbacks for one timer never overlap;
+        /// ticks missed while one runs are handled according to `policy`.
+        ///
+        /// Like `set`, only valid on a timer in the `done` state. A
+        /// periodic timer is not done again until after `try_cancel`.
+        /// </summary>
+        template <typename Rep, typename Period, typename PhaseRep, typename PhasePeriod>
+        void
+        set_periodic(std::chrono::duration<Rep, Period>           period,
+                     std::chrono::duration<PhaseRep, PhasePeriod> phase,
+                     missed_tick_policy                           policy = missed_tick_policy::skip)
+        {
+            do_set_periodic(std::chrono::duration_cast<duration>(period),
+                            std::chrono::duration_cast<duration>(phase),
+                            policy);
         }
 
     protected:
@@ -71,12 +230,113 @@ namespace m
         do_try_cancel() = 0;
 
         virtual void
-        do_set(duration dur) = 0;
+        do_set(duration dur, duration tolerance) = 0;
+
+        virtual void
+        do_set_periodic(duration period, duration phase, missed_tick_policy policy) = 0;
     };
 
+    /// <summary>
+    /// A wait for a file descriptor to become ready, from
+    /// `threadpool_class::wait_for_fd`. Destroying the object cancels the
+    /// wait and, if the callback is running, waits for it to return, so it
+    /// must not be destroyed from inside its own callback.
+    /// </summary>
+    class fd_wait
+    {
+    public:
+        /// <summary>
+        /// Stops waiting. Returns whether that kept the callback from
+        /// being called; if not, it has been called or is about to be.
+        /// </summary>
+        bool
+        cancel()
+        {
+            return do_cancel();
+        }
+
+        /// <summary>
+        /// Waits again for the same events. Waits are one-shot, so this is
+        /// how to go on waiting once the callback has been called, e.g.
+        /// from within the callback itself after draining the descriptor.
+        /// </summary>
+        void
+        rearm()
+        {
+            do_rearm();
+        }
+
+    protected:
+        virtual ~fd_wait() {}
+
+        virtual bool
+        do_cancel() = 0;
+
+        virtual void
+        do_rearm() = 0;
+    };
+
+    using fd_wait_function = std::move_only_function<void(fd_events)>;
+
     using timer_callable             = void();
     using timer_cancellable_callable = void(std::atomic<bool>&);
 
+    //
+    // A timer's callback is invoked once per expiry, many times for a
+    // periodic timer, so it is held as a plain callable rather than a
+    // std::packaged_task which would need a new shared state every time.
+    // Callables up to timer_inline_capacity bytes are stored in the timer
+    // itself.
+    //
+    inline constexpr std::size_t timer_inline_capacity = 64;
+
+    using timer_function =
+        threadpool_impl::inline_function<timer_callable, timer_inline_capacity>;
+    using timer_cancellable_function =
+        threadpool_impl::inline_function<timer_cancellable_callable, timer_inline_capacity>;
+
+    /// <summary>
+    /// The description of a timer, shown as the thread description while
+    /// its callback runs. It is kept as the format string and a copy of
+    /// the arguments and only formatted when it is first needed, so timers
+    /// that are cancelled before they fire never pay for it. Arguments that
+    /// point to data (e.g. `wchar_t const*`) must outlive the timer.
+    /// </summary>
+    class timer_description
+    {
+    public:
+        timer_description() = default;
+
+        template <typename... Args>
+        explicit timer_description(std::wformat_string<Args...> fmt, Args&&... args):
+            m_format([fmt = fmt.get(), ... args = std::forward<Args>(args)]() {
+                return std::vformat(fmt, std::make_wformat_args(args...));
+            })
+        {}
+
+        bool
+        empty() const noexcept
+        {
+            return !m_format;
+        }
+
+        std::wstring
+        str()
+        {
+            return m_format ? m_format() : std::wstring();
+        }
+
+    private:
+        threadpool_impl::inline_function<std::wstring(), timer_inline_capacity> m_format;
+    };
+
+    namespace threadpool_impl
+    {
+        class parallel_job;
+    }
+
+    class strand;
+
     class threadpool_class
     {
     public:
@@ -84,43 +344,428 @@ namespace m
         std::shared_ptr<timer>
         create_timer(F&& f)
         {
-            return do_create_timer(std::packaged_task<timer_callable>(std::forward<F>(f)), L"");
+            return do_create_timer(timer_function(std::forward<F>(f)), timer_description());
         }
 
         template <typename F, typename... Args>
         std::shared_ptr<timer>
         create_timer(F&& f, std::wformat_string<Args...>&& fmt, Args&&... args)
         {
-            auto description = std::format(std::forward<std::wformat_string<Args...>>(fmt),
-                                           std::forward<Args>(args)...);
-            return do_create_timer(std::packaged_task<timer_callable>(std::forward<F>(f)),
-                                   std::move(description));
+            return do_create_timer(timer_function(std::forward<F>(f)),
+                                   timer_description(std::move(fmt), std::forward<Args>(args)...));
         }
 
         template <typename F>
         std::shared_ptr<timer>
         create_cancellable_timer(F&& f)
         {
-            return do_create_timer(
-                std::packaged_task<timer_cancellable_callable>(std::forward<F>(f)), L"");
+            return do_create_timer(timer_cancellable_function(std::forward<F>(f)),
+                                   timer_description());
+        }
+
+        /// <summary>
+        /// Runs `f` on one of the threadpool's CPU workers. These are meant
+        /// for work that does not block; see `submit_blocking`.
+        /// </summary>
+        template <typename F>
+        void
+        submit(F&& f, work_priority priority = work_priority::normal)
+        {
+            do_submit(std::move_only_function<void()>(std::forward<F>(f)), priority, {});
+        }
+
+        /// <summary>
+        /// As above; the worker takes `description` as its thread
+        /// description while `f` runs, and statistics may be broken down
+        /// by it.
+        /// </summary>
+        template <typename F>
+        void
+        submit(F&& f, work_priority priority, std::wstring description)
+        {
+            do_submit(std::move_only_function<void()>(std::forward<F>(f)),
+                      priority,
+                      std::move(description));
+        }
+
+        /// <summary>
+        /// Runs `f`, which may block for a long time (e.g. in file I/O), on a
+        /// separate set of threads that grows as needed so that blocked
+        /// work never holds up work submitted with `submit`.
+        /// </summary>
+        template <typename F>
+        void
+        submit_blocking(F&& f)
+        {
+            do_submit_blocking(std::move_only_function<void()>(std::forward<F>(f)), {});
+        }
+
+        template <typename F>
+        void
+        submit_blocking(F&& f, std::wstring description)
+        {
+            do_submit_blocking(std::move_only_function<void()>(std::forward<F>(f)),
+                               std::move(description));
+        }
+
+        /// <summary>
+        /// Like `submit`, but prefers a CPU worker on NUMA node `node`, e.g.
+        /// the one holding the data `f` works on. Other nodes' workers only
+        /// pick the work up when they run out of their own. The hint is
+        /// ignored by pools whose workers are not placed per node.
+        /// </summary>
+        template <typename F>
+        void
+        submit_on_node(std::size_t node, F&& f, work_priority priority = work_priority::normal)
+        {
+            do_submit_on_node(std::move_only_function<void()>(std::forward<F>(f)), priority, node);
+        }
+
+        /// <summary>
+        /// Calls `callback` on a CPU worker, with the events that occurred,
+        /// once `fd` (a socket, pipe, eventfd, inotify descriptor, etc.) is
+        /// ready for any of `events`. The wait is one-shot; see
+        /// `fd_wait::rearm`. A descriptor may have only one wait at a
+        /// time, so wait for reading and writing together if need be, and
+        /// it must stay open until the wait has been cancelled or
+        /// destroyed. Not supported on Windows.
+        /// </summary>
+        template <typename F>
+        std::shared_ptr<fd_wait>
+        wait_for_fd(int fd, fd_events events, F&& callback)
+        {
+            return do_wait_for_fd(fd, events, fd_wait_function(std::forward<F>(callback)));
+        }
+
+        /// <summary>
+        /// The number of CPU workers, i.e. how much work submitted with
+        /// `submit` can run at the same time.
+        /// </summary>
+        std::size_t
+        concurrency()
+        {
+            return do_concurrency();
+        }
+
+        /// <summary>
+        /// A snapshot of how busy the pool is and has been: queue depths,
+        /// queue wait and run time histograms per priority, worker
+        /// utilization, steals and timer lateness.
+        /// </summary>
+        threadpool_statistics
+        statistics()
+        {
+            return do_statistics_recorder().snapshot(do_concurrency());
+        }
+
+        /// <summary>
+        /// The number of NUMA nodes the CPU workers are spread over; 1 unless
+        /// the pool was created with `worker_placement::per_node` or
+        /// `worker_placement::per_core`.
+        /// </summary>
+        std::size_t
+        node_count()
+        {
+            return do_node_count();
+        }
+
+        /// <summary>
+        /// A new strand on this pool (see strand.h): work posted to it runs
+        /// at `priority`, one item at a time and in order. The pool must
+        /// outlive the strand.
+        /// </summary>
+        std::shared_ptr<strand>
+        make_strand(work_priority priority = work_priority::normal);
+
+        /// <summary>
+        /// Calls `f` on every element of `range`, in parallel.
+        ///
+        /// The range is split in halves recursively down to pieces of at
+        /// most `grain` elements. Each thread works through its own pieces
+        /// and, once out of work, steals the largest outstanding piece
+        /// from another. The calling thread takes part rather than
+        /// blocking, so this may be called from a threadpool callback.
+        ///
+        /// If `f` throws, elements not yet started are skipped and the
+        /// first exception is rethrown once every thread has let go of the
+        /// range.
+        /// </summary>
+        template <std::ranges::random_access_range R, typename F>
+            requires std::ranges::sized_range<R>
+        void
+        parallel_for(R&& range, std::size_t grain, F&& f)
+        {
+            auto const first = std::ranges::begin(range);
+
+            invoke_parallel(static_cast<std::size_t>(std::ranges::size(range)),
+                            grain,
+                            [&](std::size_t begin, std::size_t end) {
+                                for (auto i = begin; i != end; i++)
+                                    f(first[static_cast<std::ranges::range_difference_t<R>>(i)]);
+                            });
+        }
+
+        /// <summary>
+        /// Returns `init` combined, in order, with `transform(e)` for every
+        /// element `e` of `range` using `reduce`, which must be associative.
+        ///
+        /// The range is cut into consecutive chunks of `grain` elements
+        /// that are reduced in parallel as for `parallel_for`, after which
+        /// the per-chunk results are combined left to right. The result
+        /// does not depend on how the work was spread over threads.
+        /// </summary>
+        template <std::ranges::random_access_range R,
+                  typename T,
+                  typename Reduce,
+                  typename Transform = std::identity>
+            requires std::ranges::sized_range<R>
+        T
+        parallel_reduce(R&&         range,
+                        std::size_t grain,
+                        T           init,
+                        Reduce&&    reduce,
+                        Transform&& transform = {})
+        {
+            using difference_type = std::ranges::range_difference_t<R>;
+
+            auto const first = std::ranges::begin(range);
+            auto const count = static_cast<std::size_t>(std::ranges::size(range));
+
+            grain = (std::max)(grain, std::size_t{1});
+
+            std::vector<std::optional<T>> partials((count + grain - 1) / grain);
+
+            invoke_parallel(partials.size(), 1, [&](std::size_t begin, std::size_t end) {
+                for (auto chunk = begin; chunk != end; chunk++)
+                {
+                    auto const chunk_begin = chunk * grain;
+                    auto const chunk_end   = (std::min)(chunk_begin + grain, count);
+
+                    auto i   = chunk_begin;
+                    auto acc = T(transform(first[static_cast<difference_type>(i)]));
+
+                    for (i++; i != chunk_end; i++)
+                        acc = reduce(std::move(acc),
+                                     transform(first[static_cast<difference_type>(i)]));
+
+                    partials[chunk].emplace(std::move(acc));
+                }
+            });
+
+            for (auto& partial: partials)
+                init = reduce(std::move(init), std::move(*partial));
+
+            return init;
+        }
+
+        //
+        // Awaitable returned by schedule(); resumes the awaiting coroutine
+        // on a threadpool thread.
+        //
+        struct schedule_awaiter
+        {
+            bool
+            await_ready() noexcept
+            {
+                return false;
+            }
+
+            void
+            await_suspend(std::coroutine_handle<> awaiting)
+            {
+                if (m_blocking)
+                    m_pool->do_submit_blocking([awaiting]() { awaiting.resume(); }, {});
+                else
+                    m_pool->do_submit([awaiting]() { awaiting.resume(); }, m_priority, {});
+            }
+
+            void
+            await_resume() noexcept
+            {}
+
+            threadpool_class* m_pool;
+            work_priority     m_priority;
+            bool              m_blocking;
+        };
+
+        //
+        // Awaitable returned by delay(); resumes the awaiting coroutine on
+        // a threadpool thread once the duration has elapsed.
+        //
+        struct delay_awaiter
+        {
+            bool
+            await_ready() noexcept
+            {
+                return m_duration <= threadpool_types::duration::zero();
+            }
+
+            void
+            await_suspend(std::coroutine_handle<> awaiting)
+            {
+                //
+                // The timer callback hands the coroutine to another work
+                // item rather than resuming it directly: the coroutine
+                // releases this timer when it moves on, and a timer cannot
+                // be destroyed from inside its own callback. The local
+                // reference keeps the timer alive until set() has returned
+                // even if the coroutine has been resumed by then.
+                //
+                auto timer = m_pool->create_timer([pool = m_pool, awaiting]() {
+                    pool->do_submit([awaiting]() { awaiting.resume(); }, work_priority::normal, {});
+                });
+
+                m_timer = timer;
+                timer->set(m_duration);
+            }
+
+            void
+            await_resume() noexcept
+            {}
+
+            threadpool_class*          m_pool;
+            threadpool_types::duration m_duration;
+            std::shared_ptr<m::timer>  m_timer;
+        };
+
+        /// <summary>
+        /// `co_await pool.schedule()` continues the coroutine on a
+        /// threadpool thread.
+        /// </summary>
+        schedule_awaiter
+        schedule(work_priority priority = work_priority::normal) noexcept
+        {
+            return {this, priority, false};
+        }
+
+        /// <summary>
+        /// `co_await pool.schedule_blocking()` continues the coroutine on a
+        /// thread set aside for blocking work, as for `submit_blocking`.
+        /// </summary>
+        schedule_awaiter
+        schedule_blocking() noexcept
+        {
+            return {this, work_priority::normal, true};
+        }
+
+        /// <summary>
+        /// `co_await pool.delay(d)` continues the coroutine on a threadpool
+        /// thread after `d`, without blocking any thread meanwhile.
+        /// </summary>
+        template <typename Rep, typename Period>
+        delay_awaiter
+        delay(std::chrono::duration<Rep, Period> d)
+        {
+            return {this, std::chrono::ceil<threadpool_types::duration>(d), {}};
         }
 
     protected:
         virtual ~threadpool_class() = default;
 
+        //
+        // Type erased body of a parallel loop; invoked on [first, last)
+        // subranges of the iteration space.
+        //
+        class parallel_body
+        {
+        public:
+            virtual void
+            invoke(std::size_t first, std::size_t last) = 0;
+
+        protected:
+            ~parallel_body() = default;
+        };
+
+        template <typename F>
+        void
+        invoke_parallel(std::size_t count, std::size_t grain, F&& f)
+        {
+            struct body : public parallel_body
+            {
+                explicit body(F& f): m_f(f) {}
+
+                void
+                invoke(std::size_t first, std::size_t last) override
+                {
+                    m_f(first, last);
+                }
+
+                F& m_f;
+            } b(f);
+
+            run_parallel(count, grain, b);
+        }
+
+        //
+        // Work stealing driver behind parallel_for and parallel_reduce,
+        // common to all platforms. Helpers are started with do_submit.
+        //
+        void
+        run_parallel(std::size_t count, std::size_t grain, parallel_body& body);
+
+        //
+        // Runs `work` on a CPU worker at some point.
+        //
+        virtual void
+        do_submit(std::move_only_function<void()>&& work,
+                  work_priority                     priority,
+                  std::wstring&&                    description) = 0;
+
+        //
+        // Runs `work` on a thread for blocking work at some point.
+        //
+        virtual void
+        do_submit_blocking(std::move_only_function<void()>&& work,
+                           std::wstring&&                    description) = 0;
+
+        //
+        // As do_submit, preferring the workers on `node`.
+        //
+        virtual void
+        do_submit_on_node(std::move_only_function<void()>&& work,
+                          work_priority                     priority,
+                          std::size_t                       node) = 0;
+
+        virtual std::size_t
+        do_node_count() = 0;
+
+        virtual threadpool_impl::statistics_recorder&
+        do_statistics_recorder() = 0;
+
+        //
+        // The node the calling thread is running on, as far as the pool can
+        // tell; run_parallel uses it to steal from nearby threads first.
+        //
+        virtual std::size_t
+        do_current_node() = 0;
+
+        //
+        // The number of threads that can run pool work at the same time.
+        //
+        virtual std::size_t
+        do_concurrency() = 0;
+
         virtual std::shared_ptr<timer>
-        do_create_timer(std::packaged_task<timer_callable>&& task, std::wstring&& description) = 0;
+        do_create_timer(timer_function&& task, timer_description&& description) = 0;
 
         virtual std::shared_ptr<timer>
-        do_create_timer(std::packaged_task<timer_cancellable_callable>&& task, std::wstring&& description) = 0;
+        do_create_timer(timer_cancellable_function&& task, timer_description&& description) = 0;
+
+        virtual std::shared_ptr<fd_wait>
+        do_wait_for_fd(int fd, fd_events events, fd_wait_function&& callback) = 0;
 
         friend class timer;
+        friend class threadpool_impl::parallel_job;
     };
 
     // Implemented by platforms to allow for e.g. Windows vs. Linux support
     std::shared_ptr<threadpool_class>
     make_platform_default_threadpool();
 
+    // A threadpool other than the default, e.g. with pinned workers
+    std::shared_ptr<threadpool_class>
+    make_platform_threadpool(threadpool_options const& options);
+
     struct global_threadpool_type
     {
         static std::shared_ptr<threadpool_class>
@@ -0,0 +1,78 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include <m/threadpool/threadpool.h>
+
+namespace m
+{
+    /// <summary>
+    /// A threadpool whose timers run on a virtual clock that only moves
+    /// when `advance` is called, for testing timer driven code quickly and
+    /// deterministically.
+    ///
+    /// Work and timer callbacks still run on real worker threads. Moving
+    /// the clock fires the due timers one deadline at a time, in deadline
+    /// order, and waits for everything that results (callbacks, work they
+    /// submit, timers they set that fall due in turn) to finish before
+    /// moving on to the next deadline. Timers fire exactly on their
+    /// deadline; tolerances are ignored and periodic timers never miss a
+    /// tick.
+    ///
+    /// `advance` and `run_until_idle` block and must not be called from
+    /// work running on the pool.
+    /// </summary>
+    class virtual_time_threadpool : public threadpool_class
+    {
+    public:
+        using duration = threadpool_types::duration;
+
+        /// <summary>
+        /// How far the virtual clock has moved since the pool was created.
+        /// </summary>
+        duration
+        now()
+        {
+            return do_now();
+        }
+
+        /// <summary>
+        /// Moves the virtual clock forward by `d`, firing every timer that
+        /// falls due on the way, and returns once the pool is idle.
+        /// </summary>
+        template <typename Rep, typename Period>
+        void
+        advance(std::chrono::duration<Rep, Period> d)
+        {
+            do_advance(std::chrono::ceil<duration>(d));
+        }
+
+        /// <summary>
+        /// Waits until no work is queued or running and no timer is due at
+        /// the current virtual time, without moving the clock.
+        /// </summary>
+        void
+        run_until_idle()
+        {
+            do_advance(duration::zero());
+        }
+
+    protected:
+        virtual duration
+        do_now() = 0;
+
+        virtual void
+        do_advance(duration d) = 0;
+    };
+
+    /// <summary>
+    /// A virtual time threadpool whose work runs on a private platform
+    /// threadpool created with `options`.
+    /// </summary>
+    std::shared_ptr<virtual_time_threadpool>
+    make_virtual_time_threadpool(threadpool_options const& options = {});
+} // namespace m
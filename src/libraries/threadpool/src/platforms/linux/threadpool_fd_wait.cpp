@@ -0,0 +1,191 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <stdexcept>
+#include <utility>
+
+#include <sys/epoll.h>
+
+#include "threadpool_fd_wait.h"
+
+m::threadpool_impl::fd_wait::fd_wait(std::shared_ptr<reactor>      reactor,
+                                     std::shared_ptr<worker_group> workers,
+                                     int                           fd,
+                                     fd_events                     events,
+                                     fd_wait_function&&            callback):
+    m_reactor(std::move(reactor)),
+    m_workers(std::move(workers)),
+    m_fd(fd),
+    m_events(events),
+    m_callback(std::move(callback))
+{
+    //
+}
+
+m::threadpool_impl::fd_wait::~fd_wait()
+{
+    do_cancel();
+
+    auto l = std::unique_lock(m_mutex);
+    m_cv.wait(l, [this]() { return !m_in_flight; });
+}
+
+void
+m::threadpool_impl::fd_wait::start()
+{
+    auto l = std::unique_lock(m_mutex);
+
+    m_armed        = true;
+    m_registration = m_reactor->add(m_fd, epoll_events(), *this);
+    m_registered   = true;
+}
+
+bool
+m::threadpool_impl::fd_wait::do_cancel()
+{
+    bool was_armed{};
+    bool registered{};
+
+    {
+        auto l = std::unique_lock(m_mutex);
+
+        was_armed    = m_armed;
+        registered   = m_registered;
+        m_cancelled  = true;
+        m_armed      = false;
+        m_registered = false;
+    }
+
+    //
+    // Not under m_mutex: removal waits for an on_ready() in progress, which
+    // takes it. If that call has not yet looked at the state it now finds
+    // the wait cancelled.
+    //
+    if (registered)
+        m_reactor->remove(m_registration, m_fd);
+
+    return was_armed;
+}
+
+void
+m::threadpool_impl::fd_wait::do_rearm()
+{
+    auto l = std::unique_lock(m_mutex);
+
+    if (m_cancelled)
+        throw std::logic_error("fd_wait has been cancelled");
+
+    if (m_armed)
+        return;
+
+    m_reactor->modify(m_registration, m_fd, epoll_events());
+    m_armed = true;
+}
+
+void
+m::threadpool_impl::fd_wait::on_ready(std::uint32_t events) noexcept
+{
+    auto l = std::unique_lock(m_mutex);
+
+    if (!m_armed)
+        return;
+
+    auto ready = fd_events::none;
+
+    if (events & EPOLLIN)
+        ready = ready | fd_events::readable;
+
+    if (events & EPOLLOUT)
+        ready = ready | fd_events::writable;
+
+    if (events & (EPOLLERR | EPOLLHUP))
+        ready = ready | fd_events::error;
+
+    m_ready = ready;
+    m_armed = false;
+
+    //
+    // The callback rearmed the wait and the descriptor became ready again
+    // before it returned; release() queues the item again, so callbacks
+    // never overlap.
+    //
+    if (m_in_flight)
+    {
+        m_pending = true;
+        return;
+    }
+
+    m_in_flight = true;
+
+    try
+    {
+        m_workers->submit(*this);
+    }
+    catch (...)
+    {
+        // The workers are gone; nothing will ever run the callback
+        m_in_flight = false;
+        m_cv.notify_all();
+    }
+}
+
+void
+m::threadpool_impl::fd_wait::run() noexcept
+{
+    fd_events ready{};
+
+    {
+        auto l = std::unique_lock(m_mutex);
+        ready  = m_ready;
+    }
+
+    try
+    {
+        m_callback(ready);
+    }
+    catch (...)
+    {
+        // As for timers, this is not reported
+    }
+}
+
+void
+m::threadpool_impl::fd_wait::release() noexcept
+{
+    //
+    // Notify while still holding the lock; a waiting destructor cannot
+    // proceed until the lock is released and this thread does not touch
+    // the wait afterwards.
+    //
+    auto l = std::unique_lock(m_mutex);
+
+    if (std::exchange(m_pending, false) && !m_cancelled)
+    {
+        try
+        {
+            m_workers->submit(*this);
+            return;
+        }
+        catch (...)
+        {
+            // The workers are gone
+        }
+    }
+
+    m_in_flight = false;
+    m_cv.notify_all();
+}
+
+std::uint32_t
+m::threadpool_impl::fd_wait::epoll_events() const noexcept
+{
+    std::uint32_t events = EPOLLONESHOT;
+
+    if ((m_events & fd_events::readable) != fd_events::none)
+        events |= EPOLLIN;
+
+    if ((m_events & fd_events::writable) != fd_events::none)
+        events |= EPOLLOUT;
+
+    return events;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <m/threadpool/threadpool.h>
+
+#include "threadpool_reactor.h"
+#include "threadpool_work_item.h"
+#include "threadpool_workers.h"
+
+namespace m::threadpool_impl
+{
+    //
+    // A one-shot (EPOLLONESHOT) registration with the reactor that, once
+    // the descriptor is ready, queues itself on the worker group as its own
+    // work item, so waiting and dispatching do not allocate.
+    //
+    class fd_wait : public m::fd_wait, public reactor_entry, public work_item
+    {
+    public:
+        fd_wait(std::shared_ptr<reactor>      reactor,
+                std::shared_ptr<worker_group> workers,
+                int                           fd,
+                fd_events                     events,
+                fd_wait_function&&            callback);
+
+        fd_wait(fd_wait const&) = delete;
+        ~fd_wait();
+
+        void
+        operator=(fd_wait const&) = delete;
+
+        //
+        // Registers with the reactor; separate from construction so that
+        // the reactor never sees a partially constructed object.
+        //
+        void
+        start();
+
+    protected:
+        bool
+        do_cancel() override;
+
+        void
+        do_rearm() override;
+
+        // reactor_entry
+        void
+        on_ready(std::uint32_t events) noexcept override;
+
+        // work_item
+        void
+        run() noexcept override;
+
+        void
+        release() noexcept override;
+
+        std::uint32_t
+        epoll_events() const noexcept;
+
+        std::shared_ptr<reactor>      m_reactor;
+        std::shared_ptr<worker_group> m_workers;
+        int                           m_fd;
+        fd_events                     m_events;
+        fd_wait_function              m_callback;
+        reactor::id                   m_registration{};
+        std::mutex                    m_mutex;
+        std::condition_variable       m_cv;
+        fd_events                     m_ready{};
+        bool                          m_registered{false};
+        bool                          m_armed{false};
+        bool                          m_in_flight{false};
+        bool                          m_pending{false}; // ready again while in flight
+        bool                          m_cancelled{false};
+    };
+} // namespace m::threadpool_impl
@@ -1,30 +1,146 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include <chrono>
+#include <memory>
 #include <tuple>
 
 #include <m/threadpool/threadpool.h>
 
+#include "threadpool_fd_wait.h"
 #include "threadpool_impl.h"
+#include "threadpool_reactor.h"
+#include "threadpool_timer_engine.h"
 #include "threadpool_timer_impl.h"
+#include "threadpool_timer_slab.h"
+#include "threadpool_topology.h"
+#include "threadpool_work_item.h"
+#include "threadpool_workers.h"
+
+namespace
+{
+    //
+    // Threads for blocking work are started on demand, up to this many, and
+    // leave again after sitting idle for a while.
+    //
+    constexpr std::size_t blocking_worker_limit        = 256;
+    constexpr auto        blocking_worker_idle_timeout = std::chrono::seconds(10);
+} // namespace
+
+m::threadpool_impl::threadpool::threadpool(threadpool_options const& options):
+    m_workers(worker_group::create(options.m_placement == worker_placement::unpinned
+                                       ? cpu_topology{}
+                                       : cpu_topology::discover(),
+                                   options)),
+    m_blocking_workers(
+        worker_group::create(0, blocking_worker_limit, blocking_worker_idle_timeout)),
+    m_reactor(std::make_shared<reactor>()),
+    m_timer_engine(std::make_shared<timer_engine>(m_reactor)),
+    m_timer_slab(std::make_shared<block_slab>()),
+    m_statistics(std::make_shared<statistics_recorder>(options.m_statistics_by_description))
+{
+    m_workers->set_statistics(m_statistics, false);
+    m_blocking_workers->set_statistics(m_statistics, true);
+}
+
+m::threadpool_impl::threadpool::~threadpool()
+{
+    // Stop expiring timers and dispatching fd waits before the workers that
+    // would run them go away
+    m_timer_engine->shutdown();
+    m_reactor->shutdown();
+    m_workers->shutdown();
+    m_blocking_workers->shutdown();
+}
 
 std::shared_ptr<m::timer>
-m::threadpool_impl::threadpool::do_create_timer(
-    std::packaged_task<timer_cancellable_callable>&& task,
-    std::wstring&&                                   description)
+m::threadpool_impl::threadpool::do_create_timer(timer_cancellable_function&& task,
+                                                timer_description&&          description)
 {
-    return std::make_shared<m::threadpool_impl::timer>(
+    return std::allocate_shared<m::threadpool_impl::timer>(
+        slab_allocator<m::threadpool_impl::timer>(m_timer_slab),
+        m_timer_engine,
+        m_workers,
         m::threadpool_impl::timer::task_type(std::move(task)),
-        std::forward<std::wstring>(description));
+        std::move(description));
 }
 
 std::shared_ptr<m::timer>
-m::threadpool_impl::threadpool::do_create_timer(std::packaged_task<timer_callable>&& task,
-                                                std::wstring&&                       description)
+m::threadpool_impl::threadpool::do_create_timer(timer_function&&    task,
+                                                timer_description&& description)
 {
-    return std::make_shared<m::threadpool_impl::timer>(
+    return std::allocate_shared<m::threadpool_impl::timer>(
+        slab_allocator<m::threadpool_impl::timer>(m_timer_slab),
+        m_timer_engine,
+        m_workers,
         m::threadpool_impl::timer::task_type(std::move(task)),
-        std::forward<std::wstring>(description));
+        std::move(description));
+}
+
+void
+m::threadpool_impl::threadpool::do_submit(std::move_only_function<void()>&& work,
+                                          work_priority                     priority,
+                                          std::wstring&&                    description)
+{
+    auto item = std::make_unique<function_work_item>(std::move(work), std::move(description));
+    m_workers->submit(*item, priority);
+    std::ignore = item.release();
+}
+
+void
+m::threadpool_impl::threadpool::do_submit_on_node(std::move_only_function<void()>&& work,
+                                                  work_priority                     priority,
+                                                  std::size_t                       node)
+{
+    auto item = std::make_unique<function_work_item>(std::move(work));
+    m_workers->submit(*item, priority, node);
+    std::ignore = item.release();
+}
+
+void
+m::threadpool_impl::threadpool::do_submit_blocking(std::move_only_function<void()>&& work,
+                                                   std::wstring&&                    description)
+{
+    auto item = std::make_unique<function_work_item>(std::move(work), std::move(description));
+    m_blocking_workers->submit(*item);
+    std::ignore = item.release();
+}
+
+std::shared_ptr<m::fd_wait>
+m::threadpool_impl::threadpool::do_wait_for_fd(int                fd,
+                                               fd_events          events,
+                                               fd_wait_function&& callback)
+{
+    auto wait = std::make_shared<m::threadpool_impl::fd_wait>(
+        m_reactor, m_workers, fd, events, std::move(callback));
+
+    wait->start();
+
+    return wait;
+}
+
+std::size_t
+m::threadpool_impl::threadpool::do_concurrency()
+{
+    return m_workers->worker_count();
+}
+
+std::size_t
+m::threadpool_impl::threadpool::do_node_count()
+{
+    return m_workers->node_count();
+}
+
+std::size_t
+m::threadpool_impl::threadpool::do_current_node()
+{
+    return m_workers->current_node();
+}
+
+m::threadpool_impl::statistics_recorder&
+m::threadpool_impl::threadpool::do_statistics_recorder()
+{
+    return *m_statistics;
 }
 
 std::shared_ptr<m::threadpool_class>
@@ -32,3 +148,9 @@ m::make_platform_default_threadpool()
 {
     return std::make_shared<m::threadpool_impl::threadpool>();
 }
+
+std::shared_ptr<m::threadpool_class>
+m::make_platform_threadpool(threadpool_options const& options)
+{
+    return std::make_shared<m::threadpool_impl::threadpool>(options);
+}
@@ -3,23 +3,72 @@
 
 #pragma once
 
+#include <memory>
+
 #include <m/threadpool/threadpool.h>
 
 namespace m::threadpool_impl
 {
+    class block_slab;
+    class reactor;
+    class timer_engine;
+    class worker_group;
+
     class threadpool : public m::threadpool_class
     {
     public:
-        threadpool() {}
-        ~threadpool() {}
+        explicit threadpool(threadpool_options const& options = {});
+        ~threadpool();
         threadpool(threadpool const&) = delete;
         threadpool(threadpool&&);
 
     protected:
         std::shared_ptr<m::timer>
-        do_create_timer(std::packaged_task<timer_cancellable_callable>&& task, std::wstring&& description) override;
+        do_create_timer(timer_cancellable_function&& task,
+                        timer_description&&          description) override;
 
         std::shared_ptr<m::timer>
-        do_create_timer(std::packaged_task<timer_callable>&& task, std::wstring&& description) override;
+        do_create_timer(timer_function&& task, timer_description&& description) override;
+
+        void
+        do_submit(std::move_only_function<void()>&& work,
+                  work_priority                     priority,
+                  std::wstring&&                    description) override;
+
+        void
+        do_submit_blocking(std::move_only_function<void()>&& work,
+                           std::wstring&&                    description) override;
+
+        void
+        do_submit_on_node(std::move_only_function<void()>&& work,
+                          work_priority                     priority,
+                          std::size_t                       node) override;
+
+        std::size_t
+        do_node_count() override;
+
+        std::size_t
+        do_current_node() override;
+
+        statistics_recorder&
+        do_statistics_recorder() override;
+
+        std::size_t
+        do_concurrency() override;
+
+        std::shared_ptr<m::fd_wait>
+        do_wait_for_fd(int fd, fd_events events, fd_wait_function&& callback) override;
+
+        //
+        // Timers and fd waits keep their own references to these so that
+        // one which outlives the pool does not dangle.
+        //
+        std::shared_ptr<worker_group> m_workers;
+        std::shared_ptr<worker_group> m_blocking_workers;
+        std::shared_ptr<reactor>      m_reactor;
+        std::shared_ptr<timer_engine> m_timer_engine;
+        std::shared_ptr<block_slab>   m_timer_slab;
+
+        std::shared_ptr<statistics_recorder> m_statistics;
     };
 } // namespace m::threadpool_impl
@@ -0,0 +1,183 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <array>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <m/thread_description/thread_description.h>
+
+#include "threadpool_reactor.h"
+
+namespace
+{
+    // Registration id of the eventfd that wakes the reactor to stop
+    constexpr m::threadpool_impl::reactor::id wakeup_id = 0;
+
+    constexpr int max_events = 64;
+} // namespace
+
+m::threadpool_impl::reactor::reactor()
+{
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll == -1)
+        throw std::system_error(errno, std::generic_category(), "epoll_create1");
+
+    m_wakeup = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wakeup == -1)
+    {
+        auto const error = errno;
+        ::close(m_epoll);
+        throw std::system_error(error, std::generic_category(), "eventfd");
+    }
+
+    epoll_event ev{};
+    ev.events   = EPOLLIN;
+    ev.data.u64 = wakeup_id;
+
+    if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &ev) == -1)
+    {
+        auto const error = errno;
+        ::close(m_wakeup);
+        ::close(m_epoll);
+        throw std::system_error(error, std::generic_category(), "epoll_ctl");
+    }
+
+    m_thread = std::thread([this]() { run(); });
+}
+
+m::threadpool_impl::reactor::~reactor()
+{
+    shutdown();
+
+    ::close(std::exchange(m_wakeup, -1));
+    ::close(std::exchange(m_epoll, -1));
+}
+
+m::threadpool_impl::reactor::id
+m::threadpool_impl::reactor::add(int fd, std::uint32_t events, reactor_entry& entry)
+{
+    auto l = std::unique_lock(m_mutex);
+
+    if (m_stopping)
+        throw std::runtime_error("threadpool reactor has been shut down");
+
+    auto const registration = m_next_id++;
+
+    epoll_event ev{};
+    ev.events   = events;
+    ev.data.u64 = registration;
+
+    if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) == -1)
+        throw std::system_error(errno, std::generic_category(), "epoll_ctl");
+
+    m_entries.emplace(registration, &entry);
+
+    return registration;
+}
+
+void
+m::threadpool_impl::reactor::modify(id registration, int fd, std::uint32_t events)
+{
+    epoll_event ev{};
+    ev.events   = events;
+    ev.data.u64 = registration;
+
+    if (::epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &ev) == -1)
+        throw std::system_error(errno, std::generic_category(), "epoll_ctl");
+}
+
+void
+m::threadpool_impl::reactor::remove(id registration, int fd) noexcept
+{
+    auto l = std::unique_lock(m_mutex);
+
+    m_entries.erase(registration);
+
+    // Fails harmlessly if the descriptor has already been closed
+    epoll_event ev{};
+    static_cast<void>(::epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, &ev));
+
+    if (std::this_thread::get_id() != m_thread.get_id())
+        m_cv.wait(l, [&]() { return m_dispatching != registration; });
+}
+
+void
+m::threadpool_impl::reactor::shutdown()
+{
+    {
+        auto l = std::unique_lock(m_mutex);
+
+        if (m_stopping)
+            return;
+
+        m_stopping = true;
+    }
+
+    std::uint64_t const one = 1;
+    static_cast<void>(::write(m_wakeup, &one, sizeof(one)));
+
+    if (m_thread.joinable())
+    {
+        if (m_thread.get_id() == std::this_thread::get_id())
+            m_thread.detach();
+        else
+            m_thread.join();
+    }
+}
+
+void
+m::threadpool_impl::reactor::run()
+{
+    m::thread_description td(L"m::threadpool reactor");
+
+    std::array<epoll_event, max_events> events;
+
+    for (;;)
+    {
+        auto const n = ::epoll_wait(m_epoll, events.data(), max_events, -1);
+
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            auto const registration = events[i].data.u64;
+
+            reactor_entry* entry{};
+
+            {
+                auto l = std::unique_lock(m_mutex);
+
+                if (m_stopping)
+                    return;
+
+                auto const it = m_entries.find(registration);
+                if (it == m_entries.end())
+                    continue;
+
+                entry         = it->second;
+                m_dispatching = registration;
+            }
+
+            entry->on_ready(events[i].events);
+
+            {
+                auto l        = std::unique_lock(m_mutex);
+                m_dispatching = 0;
+                m_cv.notify_all();
+            }
+        }
+    }
+}
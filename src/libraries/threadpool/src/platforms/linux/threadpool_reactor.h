@@ -0,0 +1,89 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace m::threadpool_impl
+{
+    //
+    // Something waiting on the reactor for a file descriptor.
+    //
+    struct reactor_entry
+    {
+        //
+        // Called on the reactor thread with the epoll events that occurred.
+        // The reactor lock is not held, but remove() waits for the call to
+        // return.
+        //
+        virtual void
+        on_ready(std::uint32_t events) noexcept = 0;
+
+    protected:
+        ~reactor_entry() = default;
+    };
+
+    //
+    // One thread per threadpool blocked in epoll_wait on behalf of every
+    // file descriptor wait and of the timer engine's timerfd. Ready entries
+    // are expected to hand their work to the worker group rather than run
+    // it on the reactor thread.
+    //
+    // Entries are registered under an id rather than by address, so that
+    // an event already returned by epoll_wait for an entry that has since
+    // been removed is recognized and dropped.
+    //
+    class reactor
+    {
+    public:
+        using id = std::uint64_t;
+
+        reactor();
+        reactor(reactor const&) = delete;
+        ~reactor();
+
+        void
+        operator=(reactor const&) = delete;
+
+        //
+        // Starts watching `fd` for `events` (EPOLLIN etc., including e.g.
+        // EPOLLONESHOT). Throws if epoll refuses the descriptor.
+        //
+        id
+        add(int fd, std::uint32_t events, reactor_entry& entry);
+
+        //
+        // Changes the events of, or rearms a one-shot, registration.
+        //
+        void
+        modify(id registration, int fd, std::uint32_t events);
+
+        //
+        // Stops watching; once this returns the entry is not called again.
+        //
+        void
+        remove(id registration, int fd) noexcept;
+
+        void
+        shutdown();
+
+    protected:
+        void
+        run();
+
+        std::mutex                             m_mutex;
+        std::condition_variable                m_cv;
+        std::unordered_map<id, reactor_entry*> m_entries;
+        id                                     m_next_id{1};
+        id                                     m_dispatching{};
+        int                                    m_epoll{-1};
+        int                                    m_wakeup{-1};
+        bool                                   m_stopping{false};
+        std::thread                            m_thread;
+    };
+} // namespace m::threadpool_impl
@@ -0,0 +1,210 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <bit>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "threadpool_timer_engine.h"
+
+m::threadpool_impl::timer_engine::timer_engine(std::shared_ptr<reactor> reactor):
+    m_reactor(std::move(reactor)), m_epoch(clock::now())
+{
+    // std::chrono::steady_clock is CLOCK_MONOTONIC on Linux, which is what
+    // lets absolute timerfd deadlines be computed from our time points.
+    m_timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (m_timerfd == -1)
+        throw std::system_error(errno, std::generic_category(), "timerfd_create");
+
+    try
+    {
+        m_registration = m_reactor->add(m_timerfd, EPOLLIN, *this);
+    }
+    catch (...)
+    {
+        ::close(std::exchange(m_timerfd, -1));
+        throw;
+    }
+}
+
+m::threadpool_impl::timer_engine::~timer_engine()
+{
+    shutdown();
+
+    if (m_timerfd != -1)
+        ::close(std::exchange(m_timerfd, -1));
+}
+
+m::threadpool_impl::timer_engine::schedule_result
+m::threadpool_impl::timer_engine::schedule(timer_engine_entry&      entry,
+                                           time_point               deadline,
+                                           std::chrono::nanoseconds tolerance)
+{
+    auto l = std::unique_lock(m_mutex);
+
+    //
+    // The reactor marks entries in flight under this lock, so an entry
+    // that is not in flight here cannot be dispatched from its old slot
+    // while it is being moved.
+    //
+    if (entry.m_in_flight.load(std::memory_order_acquire))
+        return schedule_result::in_flight;
+
+    m_wheel.remove(entry);
+
+    if (deadline <= clock::now())
+    {
+        entry.m_in_flight.store(true, std::memory_order_release);
+        return schedule_result::expired;
+    }
+
+    if (m_stopping)
+        throw std::runtime_error("timer engine has been shut down");
+
+    auto const slack = std::chrono::floor<tick_duration_t>(tolerance).count();
+    auto const expiry =
+        coalesce(to_tick_ceil(deadline), slack > 0 ? static_cast<tick_t>(slack) : tick_t{0});
+
+    m_wheel.insert(entry, expiry);
+
+    if (!m_armed_tick || expiry < *m_armed_tick)
+        arm(expiry);
+
+    return schedule_result::armed;
+}
+
+bool
+m::threadpool_impl::timer_engine::cancel(timer_engine_entry& entry) noexcept
+{
+    auto l = std::unique_lock(m_mutex);
+
+    if (entry.m_in_flight.load(std::memory_order_acquire))
+        return false;
+
+    return m_wheel.remove(entry);
+}
+
+void
+m::threadpool_impl::timer_engine::shutdown()
+{
+    {
+        auto l = std::unique_lock(m_mutex);
+
+        if (m_stopping)
+            return;
+
+        m_stopping = true;
+    }
+
+    // Waits for an expiry being handled right now
+    m_reactor->remove(m_registration, m_timerfd);
+}
+
+void
+m::threadpool_impl::timer_engine::on_ready(std::uint32_t) noexcept
+{
+    timer_wheel_list expired;
+    timer_wheel_list dispatch;
+
+    // Only resets the timerfd's readiness; the wheel says what expired
+    std::uint64_t expirations{};
+    static_cast<void>(::read(m_timerfd, &expirations, sizeof(expirations)));
+
+    {
+        auto l = std::unique_lock(m_mutex);
+
+        if (m_stopping)
+            return;
+
+        m_wheel.advance(to_tick_floor(clock::now()), expired);
+        m_armed_tick.reset();
+
+        try
+        {
+            arm(m_wheel.next_event_tick());
+        }
+        catch (...)
+        {
+            // Not expected of a valid timerfd; the next schedule() retries
+        }
+
+        //
+        // Mark the expired entries while still holding the lock so that
+        // cancel() leaves them alone; from here on only this thread
+        // touches `dispatch`.
+        //
+        while (auto const e = expired.pop_front())
+        {
+            static_cast<timer_engine_entry*>(e)->m_in_flight.store(true,
+                                                                  std::memory_order_release);
+            dispatch.push_back(*e);
+        }
+    }
+
+    while (auto const e = dispatch.pop_front())
+        static_cast<timer_engine_entry*>(e)->on_expired();
+}
+
+m::threadpool_impl::tick_t
+m::threadpool_impl::timer_engine::to_tick_ceil(time_point t) const noexcept
+{
+    auto const ticks = std::chrono::ceil<tick_duration_t>(t - m_epoch).count();
+    return ticks < 0 ? tick_t{0} : static_cast<tick_t>(ticks);
+}
+
+m::threadpool_impl::tick_t
+m::threadpool_impl::timer_engine::to_tick_floor(time_point t) const noexcept
+{
+    auto const ticks = std::chrono::floor<tick_duration_t>(t - m_epoch).count();
+    return ticks < 0 ? tick_t{0} : static_cast<tick_t>(ticks);
+}
+
+m::threadpool_impl::tick_t
+m::threadpool_impl::timer_engine::coalesce(tick_t earliest, tick_t slack) noexcept
+{
+    //
+    // Pick the latest tick in [earliest, earliest + slack] that is a
+    // multiple of the largest power of two not above `slack`. Entries with
+    // overlapping windows and similar slack round to the same tick, land
+    // in the same wheel slot and are expired by a single wakeup.
+    //
+    if (slack == 0)
+        return earliest;
+
+    auto const granularity = std::bit_floor(slack);
+    auto const latest      = earliest + slack;
+
+    return latest - (latest % granularity);
+}
+
+void
+m::threadpool_impl::timer_engine::arm(std::optional<tick_t> tick)
+{
+    itimerspec its{};
+
+    if (tick)
+    {
+        auto const deadline = m_epoch + tick_duration_t(static_cast<tick_duration_t::rep>(*tick));
+        auto const ns       = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadline.time_since_epoch());
+
+        its.it_value.tv_sec  = static_cast<time_t>(ns.count() / 1'000'000'000);
+        its.it_value.tv_nsec = static_cast<long>(ns.count() % 1'000'000'000);
+
+        // An all-zero it_value would disarm the timer
+        if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+            its.it_value.tv_nsec = 1;
+    }
+
+    if (::timerfd_settime(m_timerfd, TFD_TIMER_ABSTIME, &its, nullptr) == -1)
+        throw std::system_error(errno, std::generic_category(), "timerfd_settime");
+
+    m_armed_tick = tick;
+}
@@ -0,0 +1,128 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+#include "threadpool_reactor.h"
+#include "threadpool_timer_wheel.h"
+#include "threadpool_workers.h"
+
+namespace m::threadpool_impl
+{
+    //
+    // Something that can be scheduled on the timer engine.
+    //
+    // m_in_flight is set by the engine, under its lock, at the moment the
+    // entry leaves the wheel to be dispatched. The owner clears it once the
+    // dispatched work has completed. An owner that wants to tear down an
+    // entry first calls timer_engine::cancel() and, if that reports the
+    // entry was not in the wheel, waits for m_in_flight to clear.
+    //
+    // An entry in flight cannot be scheduled again until it has landed;
+    // timer_engine::schedule() says so and leaves it alone.
+    //
+    struct timer_engine_entry : public timer_wheel_entry
+    {
+        //
+        // Called without the engine lock held, on the reactor thread or,
+        // for an entry scheduled already expired, by its owner.
+        //
+        virtual void
+        on_expired() noexcept = 0;
+
+        std::atomic<bool> m_in_flight{false};
+
+    protected:
+        ~timer_engine_entry() = default;
+    };
+
+    //
+    // Drives a timer_wheel from a timerfd armed for the wheel's next event,
+    // which the pool's reactor thread waits on along with any other file
+    // descriptors. Expired entries are handed back to their owners which
+    // typically submit work to the worker group.
+    //
+    class timer_engine : public reactor_entry
+    {
+    public:
+        using clock      = std::chrono::steady_clock;
+        using time_point = clock::time_point;
+
+        //
+        // One wheel tick. Entries never expire early, but may expire up to
+        // one tick late (plus scheduling latency).
+        //
+        using tick_duration_t = std::chrono::milliseconds;
+
+        enum class schedule_result
+        {
+            armed,     // In the wheel
+            expired,   // Already due and now in flight; call on_expired()
+            in_flight, // Still in flight from before; nothing was done
+        };
+
+        explicit timer_engine(std::shared_ptr<reactor> reactor);
+        timer_engine(timer_engine const&) = delete;
+        ~timer_engine();
+
+        void
+        operator=(timer_engine const&) = delete;
+
+        //
+        // Arms `entry` to expire at `deadline`, or at any point up to
+        // `tolerance` later if that lets it share a wakeup with other
+        // entries. An entry that is already armed is moved.
+        //
+        // An entry whose deadline has already passed is marked in flight
+        // and left to the caller to expire, once it has let go of any lock
+        // on_expired() might need. An entry that is in flight is not
+        // touched.
+        //
+        [[nodiscard]] schedule_result
+        schedule(timer_engine_entry&      entry,
+                 time_point               deadline,
+                 std::chrono::nanoseconds tolerance = std::chrono::nanoseconds::zero());
+
+        //
+        // Removes `entry` from the wheel. Returns false if it was not armed;
+        // it may be in flight.
+        //
+        bool
+        cancel(timer_engine_entry& entry) noexcept;
+
+        void
+        shutdown();
+
+    protected:
+        // reactor_entry; the timerfd has expired
+        void
+        on_ready(std::uint32_t events) noexcept override;
+
+        tick_t
+        to_tick_ceil(time_point t) const noexcept;
+
+        tick_t
+        to_tick_floor(time_point t) const noexcept;
+
+        static tick_t
+        coalesce(tick_t earliest, tick_t slack) noexcept;
+
+        void
+        arm(std::optional<tick_t> tick);
+
+        std::mutex               m_mutex;
+        std::shared_ptr<reactor> m_reactor;
+        reactor::id              m_registration{};
+        time_point               m_epoch;
+        timer_wheel              m_wheel;
+        std::optional<tick_t>    m_armed_tick;
+        int                      m_timerfd{-1};
+        bool                     m_stopping{false};
+    };
+} // namespace m::threadpool_impl
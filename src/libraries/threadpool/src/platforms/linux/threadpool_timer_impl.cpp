@@ -1,13 +1,19 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include <stdexcept>
 #include <variant>
 
 #include "threadpool_timer_impl.h"
 
-m::threadpool_impl::timer::timer(m::threadpool_impl::timer::task_type&& task,
-                                 std::wstring&&                         description):
-    m_task(std::move(task)), m_description(std::move(description))
+m::threadpool_impl::timer::timer(std::shared_ptr<timer_engine> engine,
+                                 std::shared_ptr<worker_group> workers,
+                                 task_type&&                   task,
+                                 timer_description&&           description):
+    m_engine(std::move(engine)),
+    m_workers(std::move(workers)),
+    m_task(std::move(task)),
+    m_description(std::move(description))
 {
     //
 }
@@ -15,20 +21,34 @@ m::threadpool_impl::timer::timer(m::threadpool_impl::timer::task_type&& task,
 m::threadpool_impl::timer::~timer()
 {
     //
+    // If the timer is still in the wheel it is simply unlinked. Otherwise
+    // it may have been handed to a worker, in which case destruction is
+    // delayed until the callback has finished. m_destroying stops a
+    // periodic timer from putting itself back in the wheel meanwhile.
+    //
+    auto l = std::unique_lock(m_mutex);
+
+    m_destroying = true;
+
+    for (;;)
+    {
+        if (m_engine->cancel(*this) || !m_in_flight.load(std::memory_order_acquire))
+            return;
+
+        m_cv.wait(l);
+    }
 }
 
 bool
 m::threadpool_impl::timer::do_cancel_requested()
 {
-    auto l = std::unique_lock(m_mutex);
-    return m_cancel_requested;
+    return m_cancel_requested.load(std::memory_order_acquire);
 }
 
 bool
 m::threadpool_impl::timer::do_done()
 {
-    auto l = std::unique_lock(m_mutex);
-    return m_done;
+    return m_done.load(std::memory_order_acquire);
 }
 
 void
@@ -37,13 +57,193 @@ m::threadpool_impl::timer::do_try_cancel()
     // Can't try to hold the mutex here since the mutex is held over the
     // task execution!
     m_cancel_requested.store(true, std::memory_order_release);
+
+    //
+    // If the timer had not yet left the wheel it never will, so it is done
+    // right away. Otherwise the worker observes m_cancel_requested.
+    //
+    if (m_engine->cancel(*this))
+    {
+        m_cancelled.store(true, std::memory_order_release);
+        m_done.store(true, std::memory_order_release);
+    }
+}
+
+void
+m::threadpool_impl::timer::do_set(duration dur, duration tolerance)
+{
+    auto l = std::unique_lock(m_mutex);
+
+    m_duration      = dur;
+    m_period        = duration::zero();
+    m_next_deadline = timer_engine::clock::now() + dur;
+    m_done.store(false, std::memory_order_release);
+
+    arm(l, tolerance);
 }
 
 void
-m::threadpool_impl::timer::do_set(duration dur)
+m::threadpool_impl::timer::do_set_periodic(duration           period,
+                                           duration           phase,
+                                           missed_tick_policy policy)
 {
+    if (period <= duration::zero())
+        throw std::invalid_argument("periodic timer period must be positive");
+
     auto l = std::unique_lock(m_mutex);
 
-    m_duration = dur;
-    m_task.reset();
+    m_duration      = phase;
+    m_period        = period;
+    m_policy        = policy;
+    m_next_deadline = timer_engine::clock::now() + phase;
+    m_done.store(false, std::memory_order_release);
+
+    arm(l, duration::zero());
+}
+
+void
+m::threadpool_impl::timer::arm(std::unique_lock<std::mutex>& l, duration tolerance)
+{
+    switch (m_engine->schedule(*this, m_next_deadline, tolerance))
+    {
+        case timer_engine::schedule_result::armed: break;
+
+        case timer_engine::schedule_result::in_flight:
+            //
+            // Queued or running for an earlier expiry. Submitting it again
+            // would run it twice at once, so leave it to release().
+            //
+            m_rearm_pending   = true;
+            m_rearm_tolerance = tolerance;
+            break;
+
+        case timer_engine::schedule_result::expired:
+            // on_expired() takes m_mutex if the workers are gone
+            l.unlock();
+            on_expired();
+            break;
+    }
+}
+
+bool
+m::threadpool_impl::timer::next_periodic_tick()
+{
+    if (m_period == duration::zero())
+        return false;
+
+    m_next_deadline += m_period;
+
+    if (m_policy == missed_tick_policy::skip)
+    {
+        // Move to the first tick on the schedule that is still ahead
+        auto const now = timer_engine::clock::now();
+
+        if (m_next_deadline <= now)
+            m_next_deadline += ((now - m_next_deadline) / m_period + 1) * m_period;
+    }
+
+    return true;
+}
+
+void
+m::threadpool_impl::timer::on_expired() noexcept
+{
+    try
+    {
+        m_workers->submit(*this);
+    }
+    catch (...)
+    {
+        // The workers are gone; nothing will ever run the callback.
+        auto l = std::unique_lock(m_mutex);
+        m_done.store(true, std::memory_order_release);
+        m_in_flight.store(false, std::memory_order_release);
+        m_cv.notify_all();
+    }
+}
+
+std::wstring_view
+m::threadpool_impl::timer::description() noexcept
+{
+    //
+    // Only ever called by the worker about to run the timer, so nothing
+    // else touches the cached text meanwhile.
+    //
+    if (m_formatted_description.empty() && !m_description.empty())
+    {
+        try
+        {
+            m_formatted_description = m_description.str();
+        }
+        catch (...)
+        {
+            // Only diagnostics go without
+        }
+    }
+
+    return m_formatted_description;
+}
+
+void
+m::threadpool_impl::timer::run() noexcept
+{
+    auto l = std::unique_lock(m_mutex);
+
+    if (auto const statistics = m_workers->statistics())
+        statistics->timer_fired(timer_engine::clock::now() - m_next_deadline);
+
+    if (m_cancel_requested)
+    {
+        // If the cancellation request came in before we've started the task
+        // we'll not even start it. Note that the state in this case is odd.
+        // m_done == true, but m_started == false.
+        m_cancelled.store(true, std::memory_order_release);
+    }
+    else
+    {
+        m_started = true;
+        m_task(m_cancel_requested);
+    }
+}
+
+void
+m::threadpool_impl::timer::release() noexcept
+{
+    auto l = std::unique_lock(m_mutex);
+
+    auto const rearm     = std::exchange(m_rearm_pending, false);
+    auto const tolerance = std::exchange(m_rearm_tolerance, duration::zero());
+
+    auto const stopped = m_destroying || m_cancelled.load(std::memory_order_acquire) ||
+                         m_cancel_requested.load(std::memory_order_acquire);
+
+    if (!stopped && (rearm || next_periodic_tick()))
+    {
+        //
+        // The engine only takes the entry back once it has left flight.
+        // Holding m_mutex keeps the destructor out until the timer is in a
+        // state it can cancel.
+        //
+        m_in_flight.store(false, std::memory_order_release);
+
+        try
+        {
+            arm(l, tolerance);
+            return;
+        }
+        catch (...)
+        {
+            // The engine has been shut down; this was the last expiry.
+        }
+    }
+
+    m_done.store(true, std::memory_order_release);
+
+    //
+    // Notify while still holding the lock; a waiting destructor cannot
+    // proceed until the lock is released and this thread does not touch
+    // the timer afterwards.
+    //
+    m_in_flight.store(false, std::memory_order_release);
+    m_cv.notify_all();
 }
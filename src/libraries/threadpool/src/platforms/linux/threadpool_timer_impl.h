@@ -4,6 +4,7 @@
 #pragma once
 
 #include <chrono>
+#include <condition_variable>
 #include <filesystem>
 #include <functional>
 #include <future>
@@ -17,72 +18,55 @@
 #include <m/utility/pointers.h>
 
 #include "threadpool_impl.h"
+#include "threadpool_timer_engine.h"
+#include "threadpool_work_item.h"
+#include "threadpool_workers.h"
 
 namespace m::threadpool_impl
 {
-    class timer : public m::timer
+    //
+    // A timer is its own wheel entry and its own work item so that arming
+    // and firing it never allocates.
+    //
+    class timer : public m::timer, public timer_engine_entry, public work_item
     {
     public:
         using duration = m::threadpool_types::duration;
 
         struct task_type
         {
-            task_type(std::packaged_task<timer_callable>&& task):
-                m_discriminant(discriminant::uncancellable), m_tasks(std::move(task))
-            {}
+            task_type(timer_function&& task): m_task(std::move(task)) {}
 
-            task_type(std::packaged_task<timer_cancellable_callable>&& task):
-                m_discriminant(discriminant::cancellable), m_tasks(std::move(task))
-            {}
+            task_type(timer_cancellable_function&& task): m_task(std::move(task)) {}
 
-            enum class discriminant
-            {
-                uncancellable,
-                cancellable,
-            };
-
-            discriminant m_discriminant;
-            struct tasks
-            {
-                tasks(std::packaged_task<timer_callable>&& task): m_packaged_task(std::move(task))
-                {}
-
-                tasks(std::packaged_task<timer_cancellable_callable>&& task):
-                    m_cancellable_packaged_task(std::move(task))
-                {}
-
-                std::packaged_task<timer_callable>             m_packaged_task;
-                std::packaged_task<timer_cancellable_callable> m_cancellable_packaged_task;
-            } m_tasks;
+            std::variant<timer_function, timer_cancellable_function> m_task;
 
+            //
+            // The same callable is invoked on every expiry. As with the
+            // std::packaged_task this used to be, an exception escaping the
+            // callback is not reported anywhere.
+            //
             void
-            operator()(std::atomic<bool>& cancelled)
+            operator()(std::atomic<bool>& cancelled) noexcept
             {
-                switch (m_discriminant)
+                try
                 {
-                    case discriminant::uncancellable: m_tasks.m_packaged_task(); break;
-                    case discriminant::cancellable:
-                        m_tasks.m_cancellable_packaged_task(cancelled);
-                        break;
-                    default: throw std::runtime_error("Should not be able to reach this code path");
+                    if (auto const f = std::get_if<timer_function>(&m_task))
+                        (*f)();
+                    else
+                        std::get<timer_cancellable_function>(m_task)(cancelled);
                 }
-            }
-
-            void
-            reset()
-            {
-                switch (m_discriminant)
+                catch (...)
                 {
-                    case discriminant::uncancellable: m_tasks.m_packaged_task.reset(); break;
-                    case discriminant::cancellable:
-                        m_tasks.m_cancellable_packaged_task.reset();
-                        break;
-                    default: throw std::runtime_error("Should not be able to reach this code path");
+                    //
                 }
             }
         };
 
-        timer(task_type&& task, std::wstring&& description);
+        timer(std::shared_ptr<timer_engine> engine,
+              std::shared_ptr<worker_group> workers,
+              task_type&&                   task,
+              timer_description&&           description);
         timer(m::threadpool_impl::timer&& other) = delete;
         timer(m::threadpool_impl::timer const&)  = delete;
         ~timer();
@@ -104,16 +88,65 @@ namespace m::threadpool_impl
         do_try_cancel() override;
 
         void
-        do_set(duration dur) override;
-
-        mutable std::mutex m_mutex;
-        task_type          m_task;
-        duration           m_duration;
-        std::wstring       m_description;
-        std::atomic<bool>  m_cancel_requested{false};
-        bool               m_cancelled{false};
-        bool               m_done{true};
-        bool               m_started{false};
+        do_set(duration dur, duration tolerance) override;
+
+        void
+        do_set_periodic(duration period, duration phase, missed_tick_policy policy) override;
+
+        //
+        // Hands the timer to the engine for m_next_deadline. If it is
+        // already due it is expired here, with `l` released first. If an
+        // earlier expiry is still in flight the timer is armed once that
+        // has finished, by release(). Called with m_mutex held through `l`.
+        //
+        void
+        arm(std::unique_lock<std::mutex>& l, duration tolerance);
+
+        //
+        // Called with m_mutex held after a periodic callback has returned.
+        // Moves m_next_deadline on to the next tick and returns whether
+        // there is one.
+        //
+        bool
+        next_periodic_tick();
+
+        // timer_engine_entry
+        void
+        on_expired() noexcept override;
+
+        // work_item
+        void
+        run() noexcept override;
+
+        void
+        release() noexcept override;
+
+        std::wstring_view
+        description() noexcept override;
+
+        std::shared_ptr<timer_engine> m_engine;
+        std::shared_ptr<worker_group> m_workers;
+        mutable std::mutex            m_mutex;
+        std::condition_variable       m_cv;
+        task_type                     m_task;
+        duration                      m_duration;
+        duration                      m_period{}; // zero for one-shot timers
+        timer_engine::time_point      m_next_deadline;
+        missed_tick_policy            m_policy{missed_tick_policy::skip};
+        timer_description             m_description;
+        std::wstring                  m_formatted_description;
+        std::atomic<bool>             m_cancel_requested{false};
+        std::atomic<bool>             m_done{true};
+        std::atomic<bool>             m_cancelled{false}; // Written by do_try_cancel unlocked
+        bool                          m_started{false};
+        bool                          m_destroying{false};
+
+        //
+        // set() was called while an expiry was in flight; release() arms
+        // the timer for m_next_deadline with this tolerance.
+        //
+        bool     m_rearm_pending{false};
+        duration m_rearm_tolerance{};
     };
 
 } // namespace m::threadpool_impl
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "threadpool_timer_slab.h"
+
+m::threadpool_impl::block_slab::~block_slab()
+{
+    for (auto const slab: m_slabs)
+        ::operator delete(slab);
+}
+
+void*
+m::threadpool_impl::block_slab::allocate(std::size_t size)
+{
+    auto l = std::unique_lock(m_mutex);
+
+    if (m_block_size == 0)
+    {
+        // Keep every block suitably aligned for anything
+        constexpr auto alignment = alignof(std::max_align_t);
+        m_block_size = ((std::max)(size, sizeof(free_block)) + alignment - 1) & ~(alignment - 1);
+    }
+
+    if (size > m_block_size)
+    {
+        l.unlock();
+        return ::operator new(size);
+    }
+
+    if (!m_free)
+    {
+        m_slabs.reserve(m_slabs.size() + 1);
+
+        auto const slab = static_cast<std::byte*>(::operator new(m_block_size * blocks_per_slab));
+        m_slabs.push_back(slab);
+
+        for (std::size_t i = blocks_per_slab; i-- != 0;)
+            m_free = ::new (slab + i * m_block_size) free_block{m_free};
+    }
+
+    return std::exchange(m_free, m_free->m_next);
+}
+
+void
+m::threadpool_impl::block_slab::deallocate(void* p, std::size_t size) noexcept
+{
+    auto l = std::unique_lock(m_mutex);
+
+    if (size > m_block_size)
+    {
+        l.unlock();
+        ::operator delete(p);
+        return;
+    }
+
+    m_free = ::new (p) free_block{m_free};
+}
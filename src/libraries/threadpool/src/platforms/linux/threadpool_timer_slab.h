@@ -0,0 +1,102 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace m::threadpool_impl
+{
+    //
+    // Hands out fixed size blocks carved from larger slabs and keeps the
+    // ones given back on a free list for reuse. The block size is set by
+    // the first allocation; requests of any other size go to the heap.
+    //
+    // Timers are allocated from one of these (together with their
+    // shared_ptr control block) so that creating and destroying them in a
+    // steady state, e.g. one per request, does not touch the heap.
+    //
+    class block_slab
+    {
+    public:
+        block_slab() = default;
+        block_slab(block_slab const&) = delete;
+        ~block_slab();
+
+        void
+        operator=(block_slab const&) = delete;
+
+        void*
+        allocate(std::size_t size);
+
+        void
+        deallocate(void* p, std::size_t size) noexcept;
+
+    private:
+        static constexpr std::size_t blocks_per_slab = 64;
+
+        struct free_block
+        {
+            free_block* m_next;
+        };
+
+        std::mutex         m_mutex;
+        std::size_t        m_block_size{};
+        free_block*        m_free{};
+        std::vector<void*> m_slabs;
+    };
+
+    //
+    // Allocator that takes single objects from a block_slab, for use with
+    // std::allocate_shared. The slab is kept alive by every copy of the
+    // allocator, including the one stored in each control block.
+    //
+    template <typename T>
+    class slab_allocator
+    {
+    public:
+        using value_type = T;
+
+        explicit slab_allocator(std::shared_ptr<block_slab> slab) noexcept: m_slab(std::move(slab))
+        {}
+
+        template <typename U>
+        slab_allocator(slab_allocator<U> const& other) noexcept: m_slab(other.m_slab)
+        {}
+
+        T*
+        allocate(std::size_t n)
+        {
+            if (n != 1)
+                return std::allocator<T>().allocate(n);
+
+            return static_cast<T*>(m_slab->allocate(sizeof(T)));
+        }
+
+        void
+        deallocate(T* p, std::size_t n) noexcept
+        {
+            if (n != 1)
+                std::allocator<T>().deallocate(p, n);
+            else
+                m_slab->deallocate(p, sizeof(T));
+        }
+
+        template <typename U>
+        bool
+        operator==(slab_allocator<U> const& other) const noexcept
+        {
+            return m_slab == other.m_slab;
+        }
+
+    private:
+        template <typename U>
+        friend class slab_allocator;
+
+        std::shared_ptr<block_slab> m_slab;
+    };
+} // namespace m::threadpool_impl
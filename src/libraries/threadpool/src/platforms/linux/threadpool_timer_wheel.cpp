@@ -0,0 +1,273 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <bit>
+
+#include "threadpool_timer_wheel.h"
+
+void
+m::threadpool_impl::timer_wheel_list::push_back(timer_wheel_entry& entry) noexcept
+{
+    entry.m_list = this;
+    entry.m_next = nullptr;
+    entry.m_prev = m_tail;
+
+    if (m_tail)
+        m_tail->m_next = &entry;
+    else
+        m_head = &entry;
+
+    m_tail = &entry;
+}
+
+void
+m::threadpool_impl::timer_wheel_list::remove(timer_wheel_entry& entry) noexcept
+{
+    if (entry.m_prev)
+        entry.m_prev->m_next = entry.m_next;
+    else
+        m_head = entry.m_next;
+
+    if (entry.m_next)
+        entry.m_next->m_prev = entry.m_prev;
+    else
+        m_tail = entry.m_prev;
+
+    entry.m_prev = nullptr;
+    entry.m_next = nullptr;
+    entry.m_list = nullptr;
+}
+
+m::threadpool_impl::timer_wheel_entry*
+m::threadpool_impl::timer_wheel_list::pop_front() noexcept
+{
+    auto const entry = m_head;
+
+    if (entry)
+        remove(*entry);
+
+    return entry;
+}
+
+m::threadpool_impl::timer_wheel::timer_wheel(tick_t now) noexcept: m_now(now) {}
+
+void
+m::threadpool_impl::timer_wheel::insert(timer_wheel_entry& entry, tick_t expiry) noexcept
+{
+    entry.m_expiry_tick = expiry;
+    place(entry);
+    m_count++;
+}
+
+bool
+m::threadpool_impl::timer_wheel::remove(timer_wheel_entry& entry) noexcept
+{
+    if (!entry.linked())
+        return false;
+
+    unlink(entry);
+    m_count--;
+    return true;
+}
+
+std::optional<m::threadpool_impl::tick_t>
+m::threadpool_impl::timer_wheel::next_event_tick() const noexcept
+{
+    if (m_count == 0)
+        return std::nullopt;
+
+    if (!m_expired.empty())
+        return m_now;
+
+    std::optional<tick_t> result;
+
+    auto const consider = [&result](tick_t t) {
+        if (!result || t < *result)
+            result = t;
+    };
+
+    for (std::size_t level = 0; level < level_count; level++)
+    {
+        auto const shift   = bits_per_level * level;
+        auto const current = static_cast<std::size_t>((m_now >> shift) & slot_mask);
+
+        auto const slot = find_next_slot(m_occupied[level], current);
+        if (!slot)
+            continue;
+
+        //
+        // A slot at or behind the current index belongs to the next
+        // rotation of this level.
+        //
+        auto const rotation_shift = shift + bits_per_level;
+        tick_t     base           = (m_now >> rotation_shift) << rotation_shift;
+
+        if (*slot <= current)
+            base += tick_t{1} << rotation_shift;
+
+        consider(base + (tick_t{*slot} << shift));
+    }
+
+    if (!m_overflow.empty())
+        consider(((m_now / wheel_span) + 1) * wheel_span);
+
+    return result;
+}
+
+void
+m::threadpool_impl::timer_wheel::advance(tick_t target, timer_wheel_list& expired) noexcept
+{
+    for (;;)
+    {
+        while (auto const entry = m_expired.pop_front())
+        {
+            m_count--;
+            expired.push_back(*entry);
+        }
+
+        auto const next = next_event_tick();
+        if (!next || *next > target)
+            break;
+
+        m_now = *next;
+        process_tick(expired);
+    }
+
+    if (target > m_now)
+        m_now = target;
+}
+
+void
+m::threadpool_impl::timer_wheel::place(timer_wheel_entry& entry) noexcept
+{
+    if (entry.m_expiry_tick <= m_now)
+    {
+        entry.m_level = expired_level;
+        m_expired.push_back(entry);
+        return;
+    }
+
+    auto const delta = entry.m_expiry_tick - m_now;
+
+    for (std::size_t level = 0; level < level_count; level++)
+    {
+        if (delta < (tick_t{1} << (bits_per_level * (level + 1))))
+        {
+            auto const shift = bits_per_level * level;
+            auto const slot  = static_cast<std::size_t>((entry.m_expiry_tick >> shift) & slot_mask);
+
+            entry.m_level = static_cast<std::uint8_t>(level);
+            entry.m_slot  = static_cast<std::uint8_t>(slot);
+            m_slots[level][slot].push_back(entry);
+            set_occupied(level, slot);
+            return;
+        }
+    }
+
+    entry.m_level = overflow_level;
+    m_overflow.push_back(entry);
+}
+
+void
+m::threadpool_impl::timer_wheel::unlink(timer_wheel_entry& entry) noexcept
+{
+    auto const list = entry.m_list;
+
+    list->remove(entry);
+
+    if (entry.m_level < level_count && list->empty())
+        clear_occupied(entry.m_level, entry.m_slot);
+}
+
+void
+m::threadpool_impl::timer_wheel::cascade(timer_wheel_list& list) noexcept
+{
+    // Re-placing a wheel slot relative to the new now() always lands on a
+    // finer level (or the expired list), never back on `list`.
+    while (auto const entry = list.pop_front())
+        place(*entry);
+}
+
+void
+m::threadpool_impl::timer_wheel::process_tick(timer_wheel_list& expired) noexcept
+{
+    if ((m_now % wheel_span) == 0)
+    {
+        // Entries that are still out of range go back on the overflow list
+        // so take them all off of it first.
+        timer_wheel_list overflow;
+
+        while (auto const entry = m_overflow.pop_front())
+            overflow.push_back(*entry);
+
+        cascade(overflow);
+    }
+
+    for (std::size_t level = level_count - 1; level > 0; level--)
+    {
+        auto const shift = bits_per_level * level;
+
+        if ((m_now & ((tick_t{1} << shift) - 1)) != 0)
+            continue;
+
+        auto const slot = static_cast<std::size_t>((m_now >> shift) & slot_mask);
+
+        clear_occupied(level, slot);
+        cascade(m_slots[level][slot]);
+    }
+
+    auto const slot = static_cast<std::size_t>(m_now & slot_mask);
+
+    clear_occupied(0, slot);
+
+    auto& list = m_slots[0][slot];
+    while (auto const entry = list.pop_front())
+    {
+        m_count--;
+        expired.push_back(*entry);
+    }
+}
+
+void
+m::threadpool_impl::timer_wheel::set_occupied(std::size_t level, std::size_t slot) noexcept
+{
+    m_occupied[level][slot / 64] |= std::uint64_t{1} << (slot % 64);
+}
+
+void
+m::threadpool_impl::timer_wheel::clear_occupied(std::size_t level, std::size_t slot) noexcept
+{
+    m_occupied[level][slot / 64] &= ~(std::uint64_t{1} << (slot % 64));
+}
+
+std::optional<std::size_t>
+m::threadpool_impl::timer_wheel::find_next_slot(bitmap_t const& bitmap, std::size_t after) noexcept
+{
+    //
+    // Search (after, slots_per_level) and then wrap around to [0, after].
+    //
+    auto const search = [&bitmap](std::size_t first,
+                                  std::size_t last) -> std::optional<std::size_t> {
+        for (auto word = first / 64; word <= (last - 1) / 64 && first < last; word++)
+        {
+            auto bits = bitmap[word];
+
+            if (word == first / 64)
+                bits &= ~std::uint64_t{0} << (first % 64);
+
+            if (word == (last - 1) / 64 && (last % 64) != 0)
+                bits &= ~(~std::uint64_t{0} << (last % 64));
+
+            if (bits)
+                return word * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+        }
+
+        return std::nullopt;
+    };
+
+    if (auto const slot = search(after + 1, slots_per_level))
+        return slot;
+
+    return search(0, after + 1);
+}
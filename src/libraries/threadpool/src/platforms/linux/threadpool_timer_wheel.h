@@ -0,0 +1,179 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace m::threadpool_impl
+{
+    using tick_t = std::uint64_t;
+
+    class timer_wheel_list;
+
+    //
+    // Intrusive node for the timer wheel. Whoever owns the entry keeps it
+    // alive while it is linked.
+    //
+    struct timer_wheel_entry
+    {
+        timer_wheel_entry* m_prev{};
+        timer_wheel_entry* m_next{};
+        timer_wheel_list*  m_list{};
+        tick_t             m_expiry_tick{};
+        std::uint8_t       m_level{};
+        std::uint8_t       m_slot{};
+
+        bool
+        linked() const noexcept
+        {
+            return m_list != nullptr;
+        }
+    };
+
+    //
+    // Doubly linked list of timer_wheel_entry, O(1) insertion and removal.
+    //
+    class timer_wheel_list
+    {
+    public:
+        bool
+        empty() const noexcept
+        {
+            return m_head == nullptr;
+        }
+
+        void
+        push_back(timer_wheel_entry& entry) noexcept;
+
+        void
+        remove(timer_wheel_entry& entry) noexcept;
+
+        timer_wheel_entry*
+        pop_front() noexcept;
+
+    private:
+        timer_wheel_entry* m_head{};
+        timer_wheel_entry* m_tail{};
+    };
+
+    //
+    // Hierarchical timing wheel.
+    //
+    // Time is measured in abstract ticks; the wheel has no notion of a
+    // clock. There are `level_count` wheels of `slots_per_level` slots each.
+    // Level 0 slots are one tick wide, level 1 slots are `slots_per_level`
+    // ticks wide and so on. An entry is placed on the lowest level whose
+    // span covers its distance from now() and is "cascaded" down to a finer
+    // level when the wheel reaches the start of its slot. Anything beyond
+    // the span of the top level waits on an overflow list that is
+    // re-examined whenever the top level wraps.
+    //
+    // Insertion and removal are O(1). Each level keeps a bitmap of occupied
+    // slots so that next_event_tick() and advance() skip empty stretches of
+    // time without walking them tick by tick.
+    //
+    // Not synchronized; the owner provides locking.
+    //
+    class timer_wheel
+    {
+    public:
+        static constexpr std::size_t bits_per_level  = 8;
+        static constexpr std::size_t slots_per_level = std::size_t{1} << bits_per_level;
+        static constexpr std::size_t level_count     = 4;
+
+        explicit timer_wheel(tick_t now = 0) noexcept;
+        timer_wheel(timer_wheel const&) = delete;
+
+        void
+        operator=(timer_wheel const&) = delete;
+
+        tick_t
+        now() const noexcept
+        {
+            return m_now;
+        }
+
+        std::size_t
+        size() const noexcept
+        {
+            return m_count;
+        }
+
+        bool
+        empty() const noexcept
+        {
+            return m_count == 0;
+        }
+
+        //
+        // Links `entry` to expire at `expiry`. An expiry at or before now()
+        // is reported by the next call to advance().
+        //
+        void
+        insert(timer_wheel_entry& entry, tick_t expiry) noexcept;
+
+        //
+        // Unlinks `entry` if it is in the wheel. Returns whether it was.
+        //
+        bool
+        remove(timer_wheel_entry& entry) noexcept;
+
+        //
+        // The earliest tick at which advance() has anything to do, either
+        // expiring entries or cascading them to a finer level. std::nullopt
+        // if the wheel is empty.
+        //
+        std::optional<tick_t>
+        next_event_tick() const noexcept;
+
+        //
+        // Moves now() forward to `target`. Every entry whose expiry is at or
+        // before `target` is unlinked from the wheel and appended to
+        // `expired`.
+        //
+        void
+        advance(tick_t target, timer_wheel_list& expired) noexcept;
+
+    private:
+        static constexpr std::size_t   words_per_bitmap = slots_per_level / 64;
+        static constexpr std::uint8_t  expired_level    = level_count;
+        static constexpr std::uint8_t  overflow_level   = level_count + 1;
+        static constexpr std::size_t   slot_mask        = slots_per_level - 1;
+        static constexpr std::uint64_t wheel_span       = std::uint64_t{1}
+                                                    << (bits_per_level * level_count);
+
+        using bitmap_t = std::array<std::uint64_t, words_per_bitmap>;
+
+        void
+        place(timer_wheel_entry& entry) noexcept;
+
+        void
+        unlink(timer_wheel_entry& entry) noexcept;
+
+        void
+        cascade(timer_wheel_list& list) noexcept;
+
+        void
+        process_tick(timer_wheel_list& expired) noexcept;
+
+        void
+        set_occupied(std::size_t level, std::size_t slot) noexcept;
+
+        void
+        clear_occupied(std::size_t level, std::size_t slot) noexcept;
+
+        static std::optional<std::size_t>
+        find_next_slot(bitmap_t const& bitmap, std::size_t after) noexcept;
+
+        tick_t                                                                 m_now;
+        std::size_t                                                            m_count{};
+        std::array<std::array<timer_wheel_list, slots_per_level>, level_count> m_slots;
+        std::array<bitmap_t, level_count>                                      m_occupied{};
+        timer_wheel_list                                                       m_expired;
+        timer_wheel_list                                                       m_overflow;
+    };
+} // namespace m::threadpool_impl
@@ -0,0 +1,206 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <sched.h>
+
+#include "threadpool_topology.h"
+
+namespace
+{
+    std::vector<int>
+    allowed_cpus()
+    {
+        std::vector<int> cpus;
+        cpu_set_t        set;
+
+        CPU_ZERO(&set);
+
+        if (::sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if (CPU_ISSET(cpu, &set))
+                    cpus.push_back(cpu);
+            }
+        }
+
+        if (cpus.empty())
+            cpus.push_back(0);
+
+        return cpus;
+    }
+
+    std::string
+    read_line(std::filesystem::path const& path)
+    {
+        std::ifstream file(path);
+        std::string   line;
+        std::getline(file, line);
+        return line;
+    }
+} // namespace
+
+std::vector<int>
+m::threadpool_impl::cpu_topology::parse_cpu_list(std::string_view text)
+{
+    std::vector<int> cpus;
+
+    auto const parse_number = [](std::string_view s, int& value) {
+        auto const [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+        return ec == std::errc{} && end == s.data() + s.size();
+    };
+
+    while (!text.empty())
+    {
+        auto const comma = text.find(',');
+        auto       item  = text.substr(0, comma);
+
+        text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+
+        while (!item.empty() && (item.back() == '\n' || item.back() == ' '))
+            item.remove_suffix(1);
+
+        if (item.empty())
+            continue;
+
+        auto const dash = item.find('-');
+        int        first{};
+        int        last{};
+
+        if (dash == std::string_view::npos)
+        {
+            if (!parse_number(item, first))
+                continue;
+            last = first;
+        }
+        else if (!parse_number(item.substr(0, dash), first) ||
+                 !parse_number(item.substr(dash + 1), last))
+        {
+            continue;
+        }
+
+        for (int cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+    }
+
+    std::ranges::sort(cpus);
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+
+    return cpus;
+}
+
+m::threadpool_impl::cpu_topology
+m::threadpool_impl::cpu_topology::single_node(std::vector<int> cpus)
+{
+    cpu_topology topology;
+    topology.m_nodes.push_back({std::move(cpus), {}});
+    return topology;
+}
+
+m::threadpool_impl::cpu_topology
+m::threadpool_impl::cpu_topology::discover()
+{
+    namespace fs = std::filesystem;
+
+    auto const allowed = allowed_cpus();
+
+    struct sysfs_node
+    {
+        int              m_id;
+        std::vector<int> m_cpus;
+        std::vector<int> m_distances;
+    };
+
+    std::vector<sysfs_node> found;
+    std::error_code         ec;
+
+    for (auto const& entry: fs::directory_iterator("/sys/devices/system/node", ec))
+    {
+        auto const name = entry.path().filename().string();
+
+        if (!name.starts_with("node"))
+            continue;
+
+        int id{};
+        auto const [end, parse_ec] =
+            std::from_chars(name.data() + 4, name.data() + name.size(), id);
+        if (parse_ec != std::errc{} || end != name.data() + name.size())
+            continue;
+
+        std::vector<int> cpus;
+        std::ranges::set_intersection(
+            parse_cpu_list(read_line(entry.path() / "cpulist")), allowed, std::back_inserter(cpus));
+
+        if (cpus.empty())
+            continue;
+
+        std::istringstream distances(read_line(entry.path() / "distance"));
+        found.push_back({id, std::move(cpus), {std::istream_iterator<int>(distances), {}}});
+    }
+
+    if (found.empty())
+        return single_node(allowed);
+
+    std::ranges::sort(found, {}, &sysfs_node::m_id);
+
+    cpu_topology topology;
+
+    for (auto& n: found)
+        topology.m_nodes.push_back({std::move(n.m_cpus), {}});
+
+    //
+    // The distance file lists the distance to every node the kernel knows
+    // of, by kernel node id. Missing or short files just make every other
+    // node equally far away.
+    //
+    auto const distance = [&](std::size_t from, std::size_t to) {
+        auto const& d  = found[from].m_distances;
+        auto const  id = static_cast<std::size_t>(found[to].m_id);
+        return id < d.size() ? d[id] : 0;
+    };
+
+    for (std::size_t i = 0; i < found.size(); i++)
+    {
+        auto& neighbours = topology.m_nodes[i].m_neighbours;
+
+        for (std::size_t j = 0; j < found.size(); j++)
+        {
+            if (j != i)
+                neighbours.push_back(j);
+        }
+
+        std::ranges::stable_sort(neighbours, {}, [&](std::size_t j) { return distance(i, j); });
+    }
+
+    return topology;
+}
+
+std::size_t
+m::threadpool_impl::cpu_topology::cpu_count() const noexcept
+{
+    return std::accumulate(m_nodes.begin(), m_nodes.end(), std::size_t{0}, [](auto n, auto& node) {
+        return n + node.m_cpus.size();
+    });
+}
+
+std::size_t
+m::threadpool_impl::cpu_topology::node_of_cpu(int cpu) const noexcept
+{
+    for (std::size_t i = 0; i < m_nodes.size(); i++)
+    {
+        if (std::ranges::binary_search(m_nodes[i].m_cpus, cpu))
+            return i;
+    }
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace m::threadpool_impl
+{
+    //
+    // The CPUs this process may run on, grouped by NUMA node, as described
+    // by /sys/devices/system/node. Nodes without any usable CPU are left
+    // out and the rest renumbered densely, so node indices here need not
+    // match the kernel's.
+    //
+    class cpu_topology
+    {
+    public:
+        //
+        // Reads the topology from sysfs, restricted to the process's
+        // affinity mask. Falls back to a single node holding every usable
+        // CPU when sysfs has nothing to say.
+        //
+        static cpu_topology
+        discover();
+
+        //
+        // A single node with the given CPUs.
+        //
+        static cpu_topology
+        single_node(std::vector<int> cpus);
+
+        //
+        // Parses the kernel's CPU list format, e.g. "0-3,8,10-11".
+        //
+        static std::vector<int>
+        parse_cpu_list(std::string_view text);
+
+        std::size_t
+        node_count() const noexcept
+        {
+            return m_nodes.size();
+        }
+
+        std::size_t
+        cpu_count() const noexcept;
+
+        std::vector<int> const&
+        node_cpus(std::size_t node) const
+        {
+            return m_nodes[node].m_cpus;
+        }
+
+        //
+        // The other nodes, nearest first.
+        //
+        std::vector<std::size_t> const&
+        neighbours(std::size_t node) const
+        {
+            return m_nodes[node].m_neighbours;
+        }
+
+        //
+        // The node that `cpu` belongs to, or 0 if it is not one of ours.
+        //
+        std::size_t
+        node_of_cpu(int cpu) const noexcept;
+
+    private:
+        struct node
+        {
+            std::vector<int>         m_cpus;
+            std::vector<std::size_t> m_neighbours;
+        };
+
+        std::vector<node> m_nodes;
+    };
+} // namespace m::threadpool_impl
@@ -0,0 +1,135 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <m/threadpool/statistics.h>
+
+namespace m::threadpool_impl
+{
+    //
+    // Intrusive unit of work executed by the worker group.
+    //
+    // The worker group never allocates or frees work items; the owner of
+    // the item guarantees it stays alive until release() has been called.
+    // A worker calls run(), records statistics, and then release(). Timers
+    // embed their work item so that dispatching an expiration does not
+    // allocate.
+    //
+    class work_item
+    {
+    public:
+        using clock = statistics_recorder::clock;
+
+        virtual void
+        run() noexcept = 0;
+
+        virtual void
+        release() noexcept
+        {}
+
+        //
+        // Shown as the worker's thread description while the item runs.
+        // Valid until release().
+        //
+        virtual std::wstring_view
+        description() noexcept
+        {
+            return {};
+        }
+
+        work_item*        m_next_work_item{};
+        clock::time_point m_enqueued{};
+        std::uint8_t      m_category{};
+
+    protected:
+        ~work_item() = default;
+    };
+
+    //
+    // Heap allocated work item for work that has no object of its own to
+    // embed one in. Deletes itself once it has run.
+    //
+    class function_work_item final : public work_item
+    {
+    public:
+        explicit function_work_item(std::move_only_function<void()>&& function,
+                                    std::wstring&&                    description = {}):
+            m_function(std::move(function)), m_description(std::move(description))
+        {}
+
+        void
+        run() noexcept override
+        {
+            m_function();
+        }
+
+        void
+        release() noexcept override
+        {
+            delete this;
+        }
+
+        std::wstring_view
+        description() noexcept override
+        {
+            return m_description;
+        }
+
+    private:
+        std::move_only_function<void()> m_function;
+        std::wstring                    m_description;
+    };
+
+    //
+    // FIFO of work items linked through m_next_work_item. Not synchronized.
+    //
+    class work_item_queue
+    {
+    public:
+        bool
+        empty() const noexcept
+        {
+            return m_head == nullptr;
+        }
+
+        void
+        push_back(work_item& item) noexcept
+        {
+            item.m_next_work_item = nullptr;
+
+            if (m_tail)
+                m_tail->m_next_work_item = &item;
+            else
+                m_head = &item;
+
+            m_tail = &item;
+        }
+
+        work_item*
+        pop_front() noexcept
+        {
+            auto const item = m_head;
+
+            if (item)
+            {
+                m_head = item->m_next_work_item;
+                if (!m_head)
+                    m_tail = nullptr;
+                item->m_next_work_item = nullptr;
+            }
+
+            return item;
+        }
+
+    private:
+        work_item* m_head{};
+        work_item* m_tail{};
+    };
+} // namespace m::threadpool_impl
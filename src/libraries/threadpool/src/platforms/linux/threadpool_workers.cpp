@@ -0,0 +1,627 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <utility>
+
+#include <sched.h>
+
+#include <m/thread_description/thread_description.h>
+
+#include "threadpool_workers.h"
+
+namespace
+{
+    //
+    // Which group, if any, the current thread is a worker of, and the node
+    // it lives on.
+    //
+    thread_local m::threadpool_impl::worker_group* t_group{};
+    thread_local std::size_t                      t_node{};
+    thread_local std::size_t                      t_blocking_depth{};
+
+    //
+    // Adaptive groups take a hill climbing step this often, and only treat
+    // a change in throughput bigger than significant_change (relative) as
+    // a signal. Up to compensation_limit extra threads may stand in for
+    // workers that are blocked.
+    //
+    constexpr auto        sample_interval    = std::chrono::milliseconds(100);
+    constexpr double      significant_change = 0.05;
+    constexpr std::size_t compensation_limit = 256;
+
+    void
+    pin_current_thread(std::vector<int> const& cpus)
+    {
+        if (cpus.empty())
+            return;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+
+        for (auto const cpu: cpus)
+            CPU_SET(cpu, &set);
+
+        // Not being allowed to pin (e.g. inside a restricted cgroup) only
+        // costs locality, so it is not an error.
+        static_cast<void>(::sched_setaffinity(0, sizeof(set), &set));
+    }
+} // namespace
+
+std::shared_ptr<m::threadpool_impl::worker_group>
+m::threadpool_impl::worker_group::create(std::size_t               min_workers,
+                                         std::size_t               max_workers,
+                                         std::chrono::milliseconds idle_timeout)
+{
+    if (max_workers == 0 || min_workers > max_workers)
+        throw std::invalid_argument("invalid worker group size");
+
+    auto group = std::make_shared<worker_group>();
+
+    group->m_topology     = cpu_topology::single_node({});
+    group->m_nodes        = std::vector<node_queues>(1);
+    group->m_min_workers  = min_workers;
+    group->m_max_workers  = max_workers;
+    group->m_target       = max_workers;
+    group->m_thread_limit = max_workers;
+    group->m_idle_timeout = idle_timeout;
+
+    auto l = std::unique_lock(group->m_mutex);
+
+    for (std::size_t i = 0; i < min_workers; i++)
+        group->start_thread({});
+
+    return group;
+}
+
+std::shared_ptr<m::threadpool_impl::worker_group>
+m::threadpool_impl::worker_group::create_adaptive(std::size_t               min_workers,
+                                                  std::size_t               max_workers,
+                                                  std::chrono::milliseconds idle_timeout)
+{
+    if (min_workers == 0 || min_workers > max_workers)
+        throw std::invalid_argument("invalid worker group size");
+
+    auto group = create(min_workers, max_workers, idle_timeout);
+
+    auto l = std::unique_lock(group->m_mutex);
+
+    group->m_target       = min_workers;
+    group->m_thread_limit = max_workers + compensation_limit;
+    group->m_adaptive     = true;
+    group->m_sample_start = clock::now();
+
+    return group;
+}
+
+std::shared_ptr<m::threadpool_impl::worker_group>
+m::threadpool_impl::worker_group::create(cpu_topology topology, threadpool_options const& options)
+{
+    auto const placement    = options.m_placement;
+    auto       worker_count = options.m_worker_count;
+
+    if (placement == worker_placement::unpinned)
+    {
+        if (worker_count == 0)
+            worker_count = default_worker_count();
+
+        return create_adaptive(worker_count,
+                               (std::max)(worker_count, options.m_max_worker_count),
+                               options.m_idle_timeout);
+    }
+
+    auto const cpu_count = topology.cpu_count();
+
+    if (worker_count == 0)
+        worker_count = cpu_count;
+
+    //
+    // Lay the CPUs out node by node and hand them to the workers in turn,
+    // so that each node gets a share of the workers in proportion to its
+    // share of the CPUs.
+    //
+    std::vector<std::pair<std::size_t, int>> cpus;
+
+    for (std::size_t node = 0; node < topology.node_count(); node++)
+    {
+        for (auto const cpu: topology.node_cpus(node))
+            cpus.emplace_back(node, cpu);
+    }
+
+    auto group = std::make_shared<worker_group>();
+
+    group->m_nodes        = std::vector<node_queues>(topology.node_count());
+    group->m_topology     = std::move(topology);
+    group->m_min_workers  = worker_count;
+    group->m_max_workers  = worker_count;
+    group->m_target       = worker_count;
+    group->m_thread_limit = worker_count;
+
+    auto l = std::unique_lock(group->m_mutex);
+
+    for (std::size_t i = 0; i < worker_count; i++)
+    {
+        if (placement == worker_placement::per_core)
+        {
+            auto const [node, cpu] = cpus[i % cpu_count];
+            group->start_thread({node, {cpu}});
+        }
+        else
+        {
+            auto const node = cpus[i * cpu_count / worker_count].first;
+            group->start_thread({node, group->m_topology.node_cpus(node)});
+        }
+    }
+
+    return group;
+}
+
+m::threadpool_impl::worker_group::~worker_group()
+{
+    shutdown();
+}
+
+std::size_t
+m::threadpool_impl::worker_group::default_worker_count()
+{
+    // hardware_concurrency() is allowed to return zero when it cannot tell
+    return (std::max)(std::size_t{2}, std::size_t{std::thread::hardware_concurrency()});
+}
+
+std::size_t
+m::threadpool_impl::worker_group::current_node() const noexcept
+{
+    if (t_group == this)
+        return t_node;
+
+    if (m_nodes.size() == 1)
+        return 0;
+
+    auto const cpu = ::sched_getcpu();
+    return cpu == -1 ? 0 : m_topology.node_of_cpu(cpu);
+}
+
+void
+m::threadpool_impl::worker_group::start_thread(worker_affinity affinity)
+{
+    m_threads.emplace_back();
+
+    auto const it = std::prev(m_threads.end());
+
+    try
+    {
+        *it = std::thread([self = shared_from_this(), it, affinity = std::move(affinity)]() {
+            self->worker_loop(it, affinity);
+        });
+    }
+    catch (...)
+    {
+        m_threads.erase(it);
+        throw;
+    }
+}
+
+void
+m::threadpool_impl::worker_group::submit(work_item& item, work_priority priority)
+{
+    submit(item, priority, current_node());
+}
+
+void
+m::threadpool_impl::worker_group::set_statistics(std::shared_ptr<statistics_recorder> recorder,
+                                                 bool                                 blocking)
+{
+    auto l = std::unique_lock(m_mutex);
+
+    m_recorder = std::move(recorder);
+    m_blocking = blocking;
+
+    publish();
+}
+
+void
+m::threadpool_impl::worker_group::blocking_started() noexcept
+{
+    auto l = std::unique_lock(m_mutex);
+
+    m_blocked++;
+    grow();
+    publish();
+}
+
+void
+m::threadpool_impl::worker_group::blocking_finished() noexcept
+{
+    auto l = std::unique_lock(m_mutex);
+
+    // Any worker now above the target leaves once it finishes its item
+    m_blocked--;
+    publish();
+}
+
+void
+m::threadpool_impl::worker_group::submit(work_item&    item,
+                                         work_priority priority,
+                                         std::size_t   node)
+{
+    item.m_enqueued = work_item::clock::now();
+    item.m_category = static_cast<std::uint8_t>(
+        m_blocking ? statistics_recorder::blocking_category : static_cast<std::size_t>(priority));
+
+    std::vector<std::thread> exited;
+    std::condition_variable* local{};
+    std::condition_variable* remote{};
+
+    {
+        auto l = std::unique_lock(m_mutex);
+
+        if (m_stopping)
+            throw std::runtime_error("threadpool worker group has been shut down");
+
+        if (node >= m_nodes.size())
+            node = current_node();
+
+        auto const p      = static_cast<std::size_t>(priority);
+        auto&      target = m_nodes[node];
+
+        if (m_recorder)
+            m_recorder->queued(item.m_category);
+
+        target.m_queues[p].push_back(item);
+        target.m_nonempty |= 1u << p;
+        m_queued++;
+
+        //
+        // Wake a worker on the node itself and, when there is more work
+        // queued than it has idle workers, one on the nearest node that
+        // has any so that it can come and help.
+        //
+        if (target.m_idle != 0)
+            local = &target.m_cv;
+
+        if (m_queued > target.m_idle)
+        {
+            for (auto const n: m_topology.neighbours(node))
+            {
+                if (m_nodes[n].m_idle != 0)
+                {
+                    remote = &m_nodes[n].m_cv;
+                    break;
+                }
+            }
+        }
+
+        grow();
+
+        exited.swap(m_exited);
+    }
+
+    if (local)
+        local->notify_one();
+
+    if (remote)
+        remote->notify_one();
+
+    for (auto& t: exited)
+        t.join();
+}
+
+void
+m::threadpool_impl::worker_group::grow() noexcept
+{
+    //
+    // Rather than leave work waiting behind workers that may be blocked
+    // for a long time, start another. The queued item is still picked up
+    // by whichever worker gets to it first.
+    //
+    auto const threads = m_threads.size();
+
+    if (m_stopping || m_queued <= m_idle || threads - m_blocked >= m_target ||
+        threads >= m_thread_limit)
+        return;
+
+    try
+    {
+        start_thread({});
+    }
+    catch (...)
+    {
+        // Out of threads; the existing workers will get to it
+        return;
+    }
+
+    if (m_recorder && !m_blocking)
+    {
+        m_recorder->thread_started(threads >= m_target);
+        publish();
+    }
+}
+
+void
+m::threadpool_impl::worker_group::retire(thread_list::iterator self)
+{
+    m_exited.push_back(std::move(*self));
+    m_threads.erase(self);
+
+    if (m_recorder && !m_blocking)
+    {
+        m_recorder->thread_retired();
+        publish();
+    }
+}
+
+void
+m::threadpool_impl::worker_group::adjust_target(clock::time_point now)
+{
+    auto const elapsed    = std::chrono::duration<double>(now - m_sample_start).count();
+    auto const throughput = static_cast<double>(m_sample_completed) / elapsed;
+
+    m_sample_start     = now;
+    m_sample_completed = 0;
+
+    //
+    // More workers only help if work is waiting for them. Without a
+    // backlog start over: the next busy spell begins by trying one more.
+    //
+    if (m_queued == 0)
+    {
+        m_last_throughput = 0;
+        m_last_step       = 1;
+        return;
+    }
+
+    auto step = 0;
+
+    if (m_last_throughput == 0)
+        step = 1;
+    else if (throughput > m_last_throughput * (1 + significant_change))
+        step = m_last_step;
+    else if (throughput < m_last_throughput * (1 - significant_change))
+        step = -m_last_step;
+
+    m_last_throughput = throughput;
+
+    if (step == 0)
+        return;
+
+    m_last_step = step;
+
+    auto const target = step > 0 ? (std::min)(m_target + 1, m_max_workers)
+                                 : (std::max)(m_target - 1, m_min_workers);
+
+    if (target == m_target)
+        return;
+
+    if (m_recorder && !m_blocking)
+        m_recorder->target_changed(m_target, target);
+
+    m_target = target;
+
+    grow();
+    publish();
+}
+
+void
+m::threadpool_impl::worker_group::publish() noexcept
+{
+    if (m_recorder && !m_blocking)
+        m_recorder->workers_changed(m_threads.size(), m_target, m_blocked);
+}
+
+void
+m::threadpool_impl::worker_group::shutdown()
+{
+    std::vector<std::thread> exited;
+
+    {
+        auto l = std::unique_lock(m_mutex);
+        if (m_stopping)
+            return;
+        m_stopping = true;
+    }
+
+    for (auto& node: m_nodes)
+        node.m_cv.notify_all();
+
+    //
+    // Workers no longer leave once m_stopping is set other than by running
+    // out of work, so the lists are stable from here on apart from the
+    // threads themselves finishing.
+    //
+    {
+        auto l = std::unique_lock(m_mutex);
+        exited.swap(m_exited);
+    }
+
+    for (auto& t: exited)
+        t.join();
+
+    for (;;)
+    {
+        std::thread t;
+
+        {
+            auto l = std::unique_lock(m_mutex);
+
+            if (m_threads.empty())
+                break;
+
+            t = std::move(m_threads.front());
+            m_threads.pop_front();
+        }
+
+        if (!t.joinable())
+            continue;
+
+        // The last reference to the pool may be released by a callback
+        // running on one of our own workers.
+        if (t.get_id() == std::this_thread::get_id())
+            t.detach();
+        else
+            t.join();
+    }
+}
+
+m::threadpool_impl::work_item*
+m::threadpool_impl::worker_group::pop_highest(std::size_t node) noexcept
+{
+    auto const take = [this](node_queues& n) -> work_item* {
+        if (n.m_nonempty == 0)
+            return nullptr;
+
+        auto const p    = static_cast<std::size_t>(std::countr_zero(n.m_nonempty));
+        auto const item = n.m_queues[p].pop_front();
+
+        if (n.m_queues[p].empty())
+            n.m_nonempty &= ~(1u << p);
+
+        m_queued--;
+        return item;
+    };
+
+    if (auto const item = take(m_nodes[node]))
+        return item;
+
+    for (auto const n: m_topology.neighbours(node))
+    {
+        if (auto const item = take(m_nodes[n]))
+        {
+            if (m_recorder)
+                m_recorder->stolen();
+
+            return item;
+        }
+    }
+
+    return nullptr;
+}
+
+void
+m::threadpool_impl::worker_group::run_item(work_item& item) noexcept
+{
+    auto const start      = work_item::clock::now();
+    auto const queue_wait = start - item.m_enqueued;
+    auto const category   = item.m_category;
+
+    if (m_recorder)
+        m_recorder->started(category, queue_wait);
+
+    auto const description = item.description();
+
+    if (description.empty())
+    {
+        item.run();
+    }
+    else
+    {
+        m::thread_description td(description);
+        item.run();
+    }
+
+    if (m_recorder)
+        m_recorder->finished(category, queue_wait, work_item::clock::now() - start, description);
+
+    item.release();
+}
+
+void
+m::threadpool_impl::worker_group::worker_loop(thread_list::iterator  self,
+                                              worker_affinity const& affinity)
+{
+    m::thread_description td(L"m::threadpool worker");
+
+    pin_current_thread(affinity.m_cpus);
+
+    t_group = this;
+    t_node  = affinity.m_node;
+
+    auto& home = m_nodes[affinity.m_node];
+    auto  l    = std::unique_lock(m_mutex);
+
+    for (;;)
+    {
+        auto const ready = [this]() { return m_stopping || m_queued != 0; };
+
+        m_idle++;
+        home.m_idle++;
+
+        //
+        // Workers inside a blocking_region do not count here, so a worker
+        // standing in for one stays while it is blocked.
+        //
+        if (m_threads.size() - m_blocked > m_min_workers && !m_stopping)
+        {
+            if (!home.m_cv.wait_for(l, m_idle_timeout, ready) &&
+                m_threads.size() - m_blocked > m_min_workers)
+            {
+                // Idle for long enough; leave
+                m_idle--;
+                home.m_idle--;
+
+                if (m_adaptive && m_target > m_min_workers)
+                {
+                    if (m_recorder && !m_blocking)
+                        m_recorder->target_changed(m_target, m_target - 1);
+
+                    m_target--;
+                }
+
+                retire(self);
+                return;
+            }
+        }
+        else
+        {
+            home.m_cv.wait(l, ready);
+        }
+
+        m_idle--;
+        home.m_idle--;
+
+        auto const item = pop_highest(affinity.m_node);
+
+        // Queued work is drained before the workers exit so that anything
+        // waiting for an item to complete (e.g. a timer's destructor) is
+        // released.
+        if (!item)
+        {
+            if (m_stopping)
+                return;
+
+            // Timed out, but we are needed to keep the minimum
+            continue;
+        }
+
+        l.unlock();
+        run_item(*item);
+        l.lock();
+
+        if (m_adaptive)
+        {
+            m_sample_completed++;
+
+            if (auto const now = clock::now(); now - m_sample_start >= sample_interval)
+                adjust_target(now);
+
+            if (m_threads.size() - m_blocked > m_target && !m_stopping)
+            {
+                retire(self);
+                return;
+            }
+        }
+    }
+}
+
+m::blocking_region::blocking_region() noexcept
+{
+    if (t_group && t_blocking_depth++ == 0)
+        t_group->blocking_started();
+}
+
+m::blocking_region::~blocking_region()
+{
+    if (t_group && --t_blocking_depth == 0)
+        t_group->blocking_finished();
+}
@@ -0,0 +1,247 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <m/threadpool/threadpool.h>
+
+#include "threadpool_topology.h"
+#include "threadpool_work_item.h"
+
+namespace m::threadpool_impl
+{
+    //
+    // The set of threads that execute work items on behalf of the Linux
+    // threadpool. Timer expirations and any other submitted work end up
+    // here.
+    //
+    // There is one queue per work_priority and a bitmap of the non-empty
+    // ones, so a worker finds the most urgent item with a single bit scan
+    // however many priorities there are.
+    //
+    // A group created from a cpu_topology pins its workers and keeps a set
+    // of queues per NUMA node. Work is queued on the submitting thread's
+    // node unless told otherwise; a worker only takes work from other
+    // nodes, nearest first, when its own node has none.
+    //
+    // A group has between `min_workers` and `max_workers` threads. When the
+    // two differ the group is elastic: a submission that finds no idle
+    // worker starts another thread, and a thread above the minimum that
+    // stays idle for `idle_timeout` exits. That suits work that blocks.
+    //
+    // An adaptive group instead aims for a target number of workers that
+    // are not inside a blocking_region. The target starts at the minimum
+    // and is moved by hill climbing: every sample_interval, while there is
+    // a backlog, the throughput over the interval is compared with that of
+    // the previous one and the target keeps moving in the same direction
+    // if that helped and turns around if it hurt. A worker entering a
+    // blocking_region no longer counts towards the target, so another is
+    // started if work is waiting; workers above the target exit as they
+    // finish their current item.
+    //
+    // Each worker holds a reference to the group so that the last release
+    // may safely happen on a worker thread.
+    //
+    class worker_group : public std::enable_shared_from_this<worker_group>
+    {
+    public:
+        static std::shared_ptr<worker_group>
+        create(std::size_t               min_workers,
+               std::size_t               max_workers,
+               std::chrono::milliseconds idle_timeout);
+
+        static std::shared_ptr<worker_group>
+        create_adaptive(std::size_t               min_workers,
+                        std::size_t               max_workers,
+                        std::chrono::milliseconds idle_timeout);
+
+        //
+        // An adaptive group when `options` leave the workers unpinned,
+        // otherwise a fixed one laid out over `topology`.
+        //
+        static std::shared_ptr<worker_group>
+        create(cpu_topology topology, threadpool_options const& options);
+
+        worker_group()                    = default;
+        worker_group(worker_group const&) = delete;
+        worker_group(worker_group&&)      = delete;
+        ~worker_group();
+
+        void
+        operator=(worker_group const&) = delete;
+
+        void
+        operator=(worker_group&&) = delete;
+
+        void
+        submit(work_item& item, work_priority priority = work_priority::normal);
+
+        //
+        // Queues `item` on `node`; a node out of range means no preference.
+        //
+        void
+        submit(work_item& item, work_priority priority, std::size_t node);
+
+        //
+        // Has the workers record what they do in `recorder`, with all work
+        // counted as blocking work if `blocking`. Must be called before
+        // anything is submitted.
+        //
+        void
+        set_statistics(std::shared_ptr<statistics_recorder> recorder, bool blocking);
+
+        statistics_recorder*
+        statistics() const noexcept
+        {
+            return m_recorder.get();
+        }
+
+        //
+        // Called by blocking_region on one of our workers, outermost
+        // regions only.
+        //
+        void
+        blocking_started() noexcept;
+
+        void
+        blocking_finished() noexcept;
+
+        //
+        // Runs whatever work is still queued and then joins the worker
+        // threads. Submitting after shutdown() is an error.
+        //
+        void
+        shutdown();
+
+        //
+        // The most threads that may run work at once, not counting those
+        // started to stand in for blocked workers.
+        //
+        std::size_t
+        worker_count() const noexcept
+        {
+            return m_max_workers;
+        }
+
+        std::size_t
+        node_count() const noexcept
+        {
+            return m_nodes.size();
+        }
+
+        //
+        // The node of the calling thread: its home node if it is one of our
+        // workers, otherwise that of the CPU it happens to be running on.
+        //
+        std::size_t
+        current_node() const noexcept;
+
+        static std::size_t
+        default_worker_count();
+
+    protected:
+        static constexpr std::size_t priority_count = 3;
+
+        using thread_list = std::list<std::thread>;
+
+        struct node_queues
+        {
+            std::array<work_item_queue, priority_count> m_queues;
+            unsigned                                    m_nonempty{};
+            std::condition_variable                     m_cv;
+            std::size_t                                 m_idle{};
+        };
+
+        //
+        // Where one worker runs; no CPUs means anywhere.
+        //
+        struct worker_affinity
+        {
+            std::size_t      m_node{};
+            std::vector<int> m_cpus;
+        };
+
+        using clock = std::chrono::steady_clock;
+
+        // Called with m_mutex held
+        void
+        start_thread(worker_affinity affinity);
+
+        //
+        // Starts another worker if work is waiting for one and fewer than
+        // m_target are free to run it. Called with m_mutex held.
+        //
+        void
+        grow() noexcept;
+
+        //
+        // Takes the calling worker out of the group; its std::thread is
+        // parked on m_exited for the next submit() or shutdown() to join.
+        // Called with m_mutex held.
+        //
+        void
+        retire(thread_list::iterator self);
+
+        //
+        // One hill climbing step. Called with m_mutex held.
+        //
+        void
+        adjust_target(clock::time_point now);
+
+        // Called with m_mutex held
+        void
+        publish() noexcept;
+
+        // Called with m_mutex held
+        work_item*
+        pop_highest(std::size_t node) noexcept;
+
+        void
+        worker_loop(thread_list::iterator self, worker_affinity const& affinity);
+
+        void
+        run_item(work_item& item) noexcept;
+
+        std::mutex                m_mutex;
+        cpu_topology              m_topology;
+        std::vector<node_queues>  m_nodes;
+        bool                      m_stopping{false};
+        std::size_t               m_min_workers{};
+        std::size_t               m_max_workers{};
+        std::chrono::milliseconds m_idle_timeout{};
+        std::size_t               m_idle{};
+        std::size_t               m_queued{};
+        thread_list               m_threads;
+
+        // Workers not inside a blocking_region that the group aims for,
+        // between m_min_workers and m_max_workers, and the most threads
+        // it may have including those standing in for blocked ones
+        std::size_t m_target{};
+        std::size_t m_thread_limit{};
+        std::size_t m_blocked{};
+        bool        m_adaptive{false};
+
+        // Hill climbing state
+        clock::time_point m_sample_start{};
+        std::uint64_t     m_sample_completed{};
+        double            m_last_throughput{};
+        int               m_last_step{1};
+
+        std::shared_ptr<statistics_recorder> m_recorder;
+        bool                                 m_blocking{false};
+
+        // Threads that exited for being idle, still to be joined
+        std::vector<std::thread> m_exited;
+    };
+} // namespace m::threadpool_impl
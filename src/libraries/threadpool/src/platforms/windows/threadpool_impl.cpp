@@ -1,34 +1,253 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <thread>
 #include <tuple>
 
+#include <Windows.h>
+
+#include <m/thread_description/thread_description.h>
 #include <m/threadpool/threadpool.h>
 
 #include "threadpool_impl.h"
 #include "threadpool_timer_impl.h"
 
+namespace
+{
+    // Blocking work may tie up this many threads of the private pool
+    constexpr DWORD blocking_thread_limit = 256;
+
+    //
+    // The callback the current thread is running for the pool, if any,
+    // and whether it has already told the system threadpool that it may
+    // run long.
+    //
+    thread_local PTP_CALLBACK_INSTANCE t_callback_instance{};
+    thread_local bool                  t_may_run_long{};
+} // namespace
+
+m::threadpool_impl::threadpool::threadpool(threadpool_options const& options):
+    m_statistics(std::make_shared<statistics_recorder>(options.m_statistics_by_description))
+{
+    constexpr std::array<TP_CALLBACK_PRIORITY, priority_count> priorities{
+        TP_CALLBACK_PRIORITY_HIGH, TP_CALLBACK_PRIORITY_NORMAL, TP_CALLBACK_PRIORITY_LOW};
+
+    for (std::size_t i = 0; i < priority_count; i++)
+    {
+        ::InitializeThreadpoolEnvironment(&m_priority_environments[i]);
+        ::SetThreadpoolCallbackPriority(&m_priority_environments[i], priorities[i]);
+    }
+
+    m_blocking_pool = ::CreateThreadpool(nullptr);
+    if (m_blocking_pool == nullptr)
+        throw std::system_error(
+            static_cast<int>(::GetLastError()), std::system_category(), "CreateThreadpool");
+
+    ::SetThreadpoolThreadMaximum(m_blocking_pool, blocking_thread_limit);
+
+    ::InitializeThreadpoolEnvironment(&m_blocking_environment);
+    ::SetThreadpoolCallbackPool(&m_blocking_environment, m_blocking_pool);
+    ::SetThreadpoolCallbackRunsLong(&m_blocking_environment);
+}
+
+m::threadpool_impl::threadpool::~threadpool()
+{
+    ::DestroyThreadpoolEnvironment(&m_blocking_environment);
+
+    if (m_blocking_pool != nullptr)
+        ::CloseThreadpool(m_blocking_pool);
+
+    for (auto& environment: m_priority_environments)
+        ::DestroyThreadpoolEnvironment(&environment);
+}
+
 std::shared_ptr<m::timer>
-m::threadpool_impl::threadpool::do_create_timer(
-    std::packaged_task<timer_cancellable_callable>&& task,
-    std::wstring&&                                   description)
+m::threadpool_impl::threadpool::do_create_timer(timer_cancellable_function&& task,
+                                                timer_description&&          description)
 {
     return std::make_shared<m::threadpool_impl::timer>(
         m::threadpool_impl::timer::task_type(std::move(task)),
-        std::forward<std::wstring>(description));
+        std::move(description),
+        m_statistics);
 }
 
 std::shared_ptr<m::timer>
-m::threadpool_impl::threadpool::do_create_timer(std::packaged_task<timer_callable>&& task,
-                                                std::wstring&&                       description)
+m::threadpool_impl::threadpool::do_create_timer(timer_function&&    task,
+                                                timer_description&& description)
 {
     return std::make_shared<m::threadpool_impl::timer>(
         m::threadpool_impl::timer::task_type(std::move(task)),
-        std::forward<std::wstring>(description));
+        std::move(description),
+        m_statistics);
+}
+
+namespace
+{
+    using clock = m::threadpool_impl::statistics_recorder::clock;
+
+    //
+    // What travels with a submitted callback. The recorder is held by
+    // reference count since the callback may outlive the pool object.
+    //
+    struct submitted_work
+    {
+        std::move_only_function<void()>                          m_work;
+        std::wstring                                             m_description;
+        std::shared_ptr<m::threadpool_impl::statistics_recorder> m_statistics;
+        std::size_t                                              m_category{};
+        clock::time_point                                        m_enqueued;
+    };
+
+    void CALLBACK
+    submitted_work_callback(PTP_CALLBACK_INSTANCE instance, PVOID context)
+    {
+        auto const work = std::unique_ptr<submitted_work>(static_cast<submitted_work*>(context));
+
+        t_callback_instance = instance;
+        t_may_run_long      = false;
+
+        auto const start      = clock::now();
+        auto const queue_wait = start - work->m_enqueued;
+
+        work->m_statistics->started(work->m_category, queue_wait);
+
+        if (work->m_description.empty())
+        {
+            work->m_work();
+        }
+        else
+        {
+            m::thread_description td(work->m_description);
+            work->m_work();
+        }
+
+        work->m_statistics->finished(
+            work->m_category, queue_wait, clock::now() - start, work->m_description);
+
+        t_callback_instance = nullptr;
+    }
+} // namespace
+
+void
+m::threadpool_impl::threadpool::do_submit(std::move_only_function<void()>&& work,
+                                          work_priority                     priority,
+                                          std::wstring&&                    description)
+{
+    auto const p = static_cast<std::size_t>(priority);
+    submit_to(std::move(work), std::move(description), p, &m_priority_environments[p]);
+}
+
+void
+m::threadpool_impl::threadpool::do_submit_blocking(std::move_only_function<void()>&& work,
+                                                   std::wstring&&                    description)
+{
+    submit_to(std::move(work),
+              std::move(description),
+              statistics_recorder::blocking_category,
+              &m_blocking_environment);
+}
+
+void
+m::threadpool_impl::threadpool::submit_to(std::move_only_function<void()>&& work,
+                                          std::wstring&&                    description,
+                                          std::size_t                       category,
+                                          PTP_CALLBACK_ENVIRON              environment)
+{
+    auto context = std::make_unique<submitted_work>(
+        std::move(work), std::move(description), m_statistics, category, clock::now());
+
+    m_statistics->queued(category);
+
+    if (!::TrySubmitThreadpoolCallback(submitted_work_callback, context.get(), environment))
+    {
+        auto const error = ::GetLastError();
+
+        m_statistics->abandoned(category);
+
+        throw std::system_error(
+            static_cast<int>(error), std::system_category(), "TrySubmitThreadpoolCallback");
+    }
+
+    std::ignore = context.release();
 }
 
+//
+// The system threadpool's threads cannot be placed, so node hints are
+// ignored and the pool presents itself as a single node.
+//
+void
+m::threadpool_impl::threadpool::do_submit_on_node(std::move_only_function<void()>&& work,
+                                                  work_priority                     priority,
+                                                  std::size_t)
+{
+    do_submit(std::move(work), priority, {});
+}
+
+std::size_t
+m::threadpool_impl::threadpool::do_node_count()
+{
+    return 1;
+}
+
+std::size_t
+m::threadpool_impl::threadpool::do_current_node()
+{
+    return 0;
+}
+
+std::size_t
+m::threadpool_impl::threadpool::do_concurrency()
+{
+    // The system threadpool grows to keep the processors busy
+    return (std::max)(std::size_t{1}, std::size_t{std::thread::hardware_concurrency()});
+}
+
+m::threadpool_impl::statistics_recorder&
+m::threadpool_impl::threadpool::do_statistics_recorder()
+{
+    return *m_statistics;
+}
+
+//
+// There are no file descriptors to speak of; handles are waited on with
+// the system threadpool's own wait objects.
+//
+std::shared_ptr<m::fd_wait>
+m::threadpool_impl::threadpool::do_wait_for_fd(int, fd_events, fd_wait_function&&)
+{
+    throw std::system_error(std::make_error_code(std::errc::operation_not_supported),
+                            "wait_for_fd");
+}
+
+//
+// The system threadpool does its own compensation for callbacks that
+// block once it is told they may run long.
+//
+m::blocking_region::blocking_region() noexcept
+{
+    if (t_callback_instance != nullptr && !t_may_run_long)
+    {
+        // Fails only when the pool is at its thread maximum already
+        std::ignore    = ::CallbackMayRunLong(t_callback_instance);
+        t_may_run_long = true;
+    }
+}
+
+m::blocking_region::~blocking_region() {}
+
 std::shared_ptr<m::threadpool_class>
 m::make_platform_default_threadpool()
 {
     return std::make_shared<m::threadpool_impl::threadpool>();
 }
+
+std::shared_ptr<m::threadpool_class>
+m::make_platform_threadpool(threadpool_options const& options)
+{
+    // Work runs on the system threadpool, which places its own threads
+    return std::make_shared<m::threadpool_impl::threadpool>(options);
+}
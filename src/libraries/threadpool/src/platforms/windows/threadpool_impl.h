@@ -3,6 +3,10 @@
 
 #pragma once
 
+#include <array>
+
+#include <Windows.h>
+
 #include <m/threadpool/threadpool.h>
 
 namespace m::threadpool_impl
@@ -18,16 +22,66 @@ namespace m::threadpool_impl
     class threadpool : public m::threadpool_class
     {
     public:
-        threadpool() {}
-        ~threadpool() {}
+        explicit threadpool(threadpool_options const& options = {});
+        ~threadpool();
         threadpool(threadpool const&) = delete;
         threadpool(threadpool&&);
 
     protected:
         std::shared_ptr<m::timer>
-        do_create_timer(std::packaged_task<timer_cancellable_callable>&& task, std::wstring&& description) override;
+        do_create_timer(timer_cancellable_function&& task,
+                        timer_description&&          description) override;
 
         std::shared_ptr<m::timer>
-        do_create_timer(std::packaged_task<timer_callable>&& task, std::wstring&& description) override;
+        do_create_timer(timer_function&& task, timer_description&& description) override;
+
+        void
+        do_submit(std::move_only_function<void()>&& work,
+                  work_priority                     priority,
+                  std::wstring&&                    description) override;
+
+        void
+        do_submit_blocking(std::move_only_function<void()>&& work,
+                           std::wstring&&                    description) override;
+
+        void
+        do_submit_on_node(std::move_only_function<void()>&& work,
+                          work_priority                     priority,
+                          std::size_t                       node) override;
+
+        std::size_t
+        do_node_count() override;
+
+        std::size_t
+        do_current_node() override;
+
+        std::size_t
+        do_concurrency() override;
+
+        statistics_recorder&
+        do_statistics_recorder() override;
+
+        std::shared_ptr<m::fd_wait>
+        do_wait_for_fd(int fd, fd_events events, fd_wait_function&& callback) override;
+
+        void
+        submit_to(std::move_only_function<void()>&& work,
+                  std::wstring&&                    description,
+                  std::size_t                       category,
+                  PTP_CALLBACK_ENVIRON              environment);
+
+        //
+        // CPU work goes to the process default pool, with the callback
+        // priority taken from one of these environments. Blocking work
+        // goes to a private pool so that it cannot tie up the default
+        // pool's threads.
+        //
+        static constexpr std::size_t priority_count = 3;
+
+        std::array<TP_CALLBACK_ENVIRON, priority_count> m_priority_environments{};
+        PTP_POOL                                        m_blocking_pool{};
+        TP_CALLBACK_ENVIRON                             m_blocking_environment{};
+
+        std::shared_ptr<statistics_recorder> m_statistics;
     };
 } // namespace m::threadpool_impl
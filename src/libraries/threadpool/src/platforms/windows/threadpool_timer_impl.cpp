@@ -1,7 +1,10 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+#include <algorithm>
 #include <chrono>
+#include <limits>
+#include <stdexcept>
 #include <variant>
 
 #include <m/debugging/dbg_format.h>
@@ -13,14 +16,23 @@
 using namespace std::chrono_literals;
 
 m::threadpool_impl::timer::timer(m::threadpool_impl::timer::task_type&& task,
-                                 std::wstring&&                         description):
-    m_task(std::move(task)), m_description(std::move(description))
+                                 timer_description&&                    description,
+                                 std::shared_ptr<statistics_recorder>   statistics):
+    m_task(std::move(task)),
+    m_description(std::move(description)),
+    m_statistics(std::move(statistics))
 {
     m_timer = ::CreateThreadpoolTimer(tp_timer_callback, this, nullptr);
 }
 
 m::threadpool_impl::timer::~timer()
 {
+    {
+        // Keep a periodic callback that is running now from rearming
+        auto l       = std::unique_lock(m_mutex);
+        m_destroying = true;
+    }
+
     if (auto timer = std::exchange(m_timer, nullptr); timer != nullptr)
     {
         ::SetThreadpoolTimer(timer, nullptr, 0, 0);
@@ -48,19 +60,30 @@ m::threadpool_impl::timer::do_try_cancel()
     // Can't try to hold the mutex here since the mutex is held over the
     // task execution!
     m_cancel_requested.store(true, std::memory_order_release);
+
+    //
+    // If the timer had not expired yet, pull it back so that it is done
+    // right away. Otherwise the callback observes m_cancel_requested.
+    //
+    if (::SetThreadpoolTimerEx(m_timer, nullptr, 0, 0))
+    {
+        m_cancelled = true;
+        m_done.store(true, std::memory_order_release);
+    }
 }
 
 void
-m::threadpool_impl::timer::do_set(duration dur)
+m::threadpool_impl::timer::do_set(duration dur, duration tolerance)
 {
     set_threadpool_timer_ex_parameters parameters;
-    compute_timer_times(dur, parameters);
+    compute_timer_times(dur, tolerance, parameters);
 
     auto l = std::unique_lock(m_mutex);
 
-    m_duration = dur;
+    m_duration      = dur;
+    m_period        = duration::zero();
+    m_next_deadline = std::chrono::steady_clock::now() + dur;
     m_done.store(false, std::memory_order_release);
-    m_task.reset();
 
     FILETIME ftZero{};
 
@@ -75,8 +98,70 @@ m::threadpool_impl::timer::do_set(duration dur)
     std::ignore = cancelled;
 }
 
+void
+m::threadpool_impl::timer::do_set_periodic(duration           period,
+                                           duration           phase,
+                                           missed_tick_policy policy)
+{
+    if (period <= duration::zero())
+        throw std::invalid_argument("periodic timer period must be positive");
+
+    auto l = std::unique_lock(m_mutex);
+
+    m_duration      = phase;
+    m_period        = period;
+    m_policy        = policy;
+    m_next_deadline = std::chrono::steady_clock::now() + phase;
+    m_done.store(false, std::memory_order_release);
+
+    set_due(m_next_deadline);
+}
+
+bool
+m::threadpool_impl::timer::rearm_periodic()
+{
+    if (m_period == duration::zero() || m_cancelled || m_destroying ||
+        m_cancel_requested.load(std::memory_order_acquire))
+        return false;
+
+    m_next_deadline += m_period;
+
+    if (m_policy == missed_tick_policy::skip)
+    {
+        // Move to the first tick on the schedule that is still ahead
+        auto const now = std::chrono::steady_clock::now();
+
+        if (m_next_deadline <= now)
+            m_next_deadline += ((now - m_next_deadline) / m_period + 1) * m_period;
+    }
+
+    set_due(m_next_deadline);
+    return true;
+}
+
+void
+m::threadpool_impl::timer::set_due(std::chrono::steady_clock::time_point deadline)
+{
+    //
+    // Each tick is armed as a one-shot relative to the absolute schedule
+    // rather than with the threadpool's own period, which is what lets
+    // missed ticks be skipped or caught up and keeps callbacks from
+    // overlapping.
+    //
+    auto const now = std::chrono::steady_clock::now();
+    auto const due =
+        deadline > now ? std::chrono::ceil<duration>(deadline - now) : duration::zero();
+
+    set_threadpool_timer_ex_parameters parameters;
+    compute_timer_times(due, duration::zero(), parameters);
+
+    ::SetThreadpoolTimerEx(
+        m_timer, parameters.m_p_ft_due_time, parameters.m_ms_period, parameters.m_ms_window_length);
+}
+
 void
 m::threadpool_impl::timer::compute_timer_times(duration                            dur,
+                                               duration                            tolerance,
                                                set_threadpool_timer_ex_parameters& parameters)
 {
     parameters.m_buffer_do_not_pass.dwLowDateTime  = 0;
@@ -108,8 +193,15 @@ m::threadpool_impl::timer::compute_timer_times(duration
         parameters.m_p_ft_due_time                     = &parameters.m_buffer_do_not_pass;
     }
 
+    //
+    // The threadpool's window length is exactly our tolerance: the system
+    // may delay the callback by up to that much to batch it with others.
+    //
+    auto const window = std::chrono::ceil<std::chrono::milliseconds>(tolerance).count();
+
     parameters.m_ms_period        = 0; // these are not periodic timers
-    parameters.m_ms_window_length = 100;
+    parameters.m_ms_window_length = static_cast<DWORD>(
+        std::clamp<decltype(window)>(window, 0, (std::numeric_limits<DWORD>::max)()));
 }
 
 void
@@ -126,7 +218,21 @@ m::threadpool_impl::timer::on_tp_timer(PTP_CALLBACK_INSTANCE) noexcept
 {
     auto l = std::unique_lock(m_mutex);
 
-    m::thread_description td(m_description);
+    if (m_formatted_description.empty() && !m_description.empty())
+    {
+        try
+        {
+            m_formatted_description = m_description.str();
+        }
+        catch (...)
+        {
+            // Only diagnostics go without
+        }
+    }
+
+    m::thread_description td(m_formatted_description);
+
+    m_statistics->timer_fired(std::chrono::steady_clock::now() - m_next_deadline);
 
     if (m_cancel_requested)
     {
@@ -142,5 +248,8 @@ m::threadpool_impl::timer::on_tp_timer(PTP_CALLBACK_INSTANCE) noexcept
 
     m_task(m_cancel_requested);
 
+    if (rearm_periodic())
+        return;
+
     m_done.store(true, std::memory_order_release);
 }
@@ -29,62 +29,37 @@ namespace m::threadpool_impl
 
         struct task_type
         {
-            task_type(std::packaged_task<timer_callable>&& task):
-                m_discriminant(discriminant::uncancellable), m_tasks(std::move(task))
-            {}
+            task_type(timer_function&& task): m_task(std::move(task)) {}
 
-            task_type(std::packaged_task<timer_cancellable_callable>&& task):
-                m_discriminant(discriminant::cancellable), m_tasks(std::move(task))
-            {}
+            task_type(timer_cancellable_function&& task): m_task(std::move(task)) {}
 
-            enum class discriminant
-            {
-                uncancellable,
-                cancellable,
-            };
-
-            discriminant m_discriminant;
-            struct tasks
-            {
-                tasks(std::packaged_task<timer_callable>&& task): m_packaged_task(std::move(task))
-                {}
-
-                tasks(std::packaged_task<timer_cancellable_callable>&& task):
-                    m_cancellable_packaged_task(std::move(task))
-                {}
-
-                std::packaged_task<timer_callable>             m_packaged_task;
-                std::packaged_task<timer_cancellable_callable> m_cancellable_packaged_task;
-            } m_tasks;
+            std::variant<timer_function, timer_cancellable_function> m_task;
 
+            //
+            // The same callable is invoked on every expiry. As with the
+            // std::packaged_task this used to be, an exception escaping the
+            // callback is not reported anywhere.
+            //
             void
-            operator()(std::atomic<bool>& cancelled)
+            operator()(std::atomic<bool>& cancelled) noexcept
             {
-                switch (m_discriminant)
+                try
                 {
-                    case discriminant::uncancellable: m_tasks.m_packaged_task(); break;
-                    case discriminant::cancellable:
-                        m_tasks.m_cancellable_packaged_task(cancelled);
-                        break;
-                    default: throw std::runtime_error("Should not be able to reach this code path");
+                    if (auto const f = std::get_if<timer_function>(&m_task))
+                        (*f)();
+                    else
+                        std::get<timer_cancellable_function>(m_task)(cancelled);
                 }
-            }
-
-            void
-            reset()
-            {
-                switch (m_discriminant)
+                catch (...)
                 {
-                    case discriminant::uncancellable: m_tasks.m_packaged_task.reset(); break;
-                    case discriminant::cancellable:
-                        m_tasks.m_cancellable_packaged_task.reset();
-                        break;
-                    default: throw std::runtime_error("Should not be able to reach this code path");
+                    //
                 }
             }
         };
 
-        timer(task_type&& task, std::wstring&& description);
+        timer(task_type&&                          task,
+              timer_description&&                  description,
+              std::shared_ptr<statistics_recorder> statistics);
         timer(m::threadpool_impl::timer&& other) = delete;
         timer(m::threadpool_impl::timer const&)  = delete;
         ~timer();
@@ -106,7 +81,10 @@ namespace m::threadpool_impl
         do_try_cancel() override;
 
         void
-        do_set(duration dur) override;
+        do_set(duration dur, duration tolerance) override;
+
+        void
+        do_set_periodic(duration period, duration phase, missed_tick_policy policy) override;
 
         struct set_threadpool_timer_ex_parameters
         {
@@ -117,7 +95,9 @@ namespace m::threadpool_impl
         };
 
         static void
-        compute_timer_times(duration dur, set_threadpool_timer_ex_parameters& parameters);
+        compute_timer_times(duration                            dur,
+                            duration                            tolerance,
+                            set_threadpool_timer_ex_parameters& parameters);
 
         static void
         tp_timer_callback(PTP_CALLBACK_INSTANCE tp_callback_instance,
@@ -126,15 +106,31 @@ namespace m::threadpool_impl
 
         void on_tp_timer(PTP_CALLBACK_INSTANCE) noexcept;
 
-        mutable std::mutex m_mutex;
-        PTP_TIMER          m_timer{};
-        task_type          m_task;
-        duration           m_duration;
-        std::wstring       m_description;
-        std::atomic<bool>  m_cancel_requested{false};
-        std::atomic<bool>  m_done{true};
-        bool               m_cancelled{false};
-        bool               m_started{false};
+        //
+        // Called with m_mutex held after a periodic callback has returned.
+        // Returns whether the timer was armed for its next tick.
+        //
+        bool
+        rearm_periodic();
+
+        void
+        set_due(std::chrono::steady_clock::time_point deadline);
+
+        mutable std::mutex                    m_mutex;
+        PTP_TIMER                             m_timer{};
+        task_type                             m_task;
+        duration                              m_duration;
+        duration                              m_period{}; // zero for one-shot timers
+        std::chrono::steady_clock::time_point m_next_deadline;
+        missed_tick_policy                    m_policy{missed_tick_policy::skip};
+        timer_description                     m_description;
+        std::wstring                          m_formatted_description;
+        std::shared_ptr<statistics_recorder>  m_statistics;
+        std::atomic<bool>                     m_cancel_requested{false};
+        std::atomic<bool>                     m_done{true};
+        bool                                  m_cancelled{false};
+        bool                                  m_started{false};
+        bool                                  m_destroying{false};
     };
 
 } // namespace m::threadpool_impl
@@ -0,0 +1,103 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <array>
+#include <cstddef>
+#include <new>
+
+#include <m/threadpool/task.h>
+
+namespace
+{
+    //
+    // Frames are rounded up to a multiple of `granularity` bytes. Each
+    // thread keeps a short free list per size class; a frame released on
+    // a thread other than the one that allocated it simply joins the
+    // releasing thread's list, which is what a pipeline hopping between
+    // workers wants anyway.
+    //
+    constexpr std::size_t granularity      = 64;
+    constexpr std::size_t size_class_count = 32; // Up to 2KiB frames
+    constexpr std::size_t max_cached       = 64; // Per size class, per thread
+
+    struct free_frame
+    {
+        free_frame* m_next;
+    };
+
+    struct frame_cache
+    {
+        frame_cache() = default;
+
+        frame_cache(frame_cache const&) = delete;
+
+        void
+        operator=(frame_cache const&) = delete;
+
+        ~frame_cache()
+        {
+            for (std::size_t i = 0; i < size_class_count; i++)
+            {
+                while (auto const frame = m_lists[i])
+                {
+                    m_lists[i] = frame->m_next;
+                    ::operator delete(frame, (i + 1) * granularity);
+                }
+            }
+        }
+
+        std::array<free_frame*, size_class_count> m_lists{};
+        std::array<std::size_t, size_class_count> m_counts{};
+    };
+
+    thread_local frame_cache t_frame_cache;
+
+    constexpr std::size_t
+    size_class(std::size_t size) noexcept
+    {
+        return (size + granularity - 1) / granularity - 1;
+    }
+} // namespace
+
+void*
+m::threadpool_impl::allocate_frame(std::size_t size)
+{
+    auto const c = size_class(size);
+
+    if (size == 0 || c >= size_class_count)
+        return ::operator new(size);
+
+    auto& cache = t_frame_cache;
+
+    if (auto const frame = cache.m_lists[c])
+    {
+        cache.m_lists[c] = frame->m_next;
+        cache.m_counts[c]--;
+        return frame;
+    }
+
+    return ::operator new((c + 1) * granularity);
+}
+
+void
+m::threadpool_impl::deallocate_frame(void* p, std::size_t size) noexcept
+{
+    auto const c = size_class(size);
+
+    if (size == 0 || c >= size_class_count)
+    {
+        ::operator delete(p, size);
+        return;
+    }
+
+    auto& cache = t_frame_cache;
+
+    if (cache.m_counts[c] == max_cached)
+    {
+        ::operator delete(p, (c + 1) * granularity);
+        return;
+    }
+
+    cache.m_lists[c] = ::new (p) free_frame{cache.m_lists[c]};
+    cache.m_counts[c]++;
+}
@@ -0,0 +1,295 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include <m/threadpool/threadpool.h>
+
+namespace m::threadpool_impl
+{
+    //
+    // Shared state of one parallel_for / parallel_reduce call.
+    //
+    // Every participating thread owns a slot holding a deque of subranges.
+    // A thread pops from the back of its own deque, so it keeps working on
+    // the piece it split most recently while it is still warm, and steals
+    // from the front of other deques, which is where the largest pieces
+    // are. Thieves try threads on their own NUMA node before those on
+    // other nodes. The calling thread is slot 0; helpers claim the others
+    // in the order they start. The job is reference counted because a
+    // helper may only get to run after the call has already returned.
+    //
+    class parallel_job
+    {
+    public:
+        using body_type = m::threadpool_class::parallel_body;
+
+        parallel_job(std::size_t          slot_count,
+                     std::size_t          count,
+                     std::size_t          grain,
+                     body_type&           body,
+                     std::size_t          caller_node,
+                     statistics_recorder& statistics):
+            m_slots(std::make_unique<slot[]>(slot_count)),
+            m_slot_count(slot_count),
+            m_grain(grain),
+            m_body(body),
+            m_statistics(statistics),
+            m_remaining(count)
+        {
+            m_slots[0].m_ranges.push_back({0, count});
+            m_slots[0].m_node.store(caller_node, std::memory_order_relaxed);
+        }
+
+        parallel_job(parallel_job const&) = delete;
+
+        void
+        operator=(parallel_job const&) = delete;
+
+        //
+        // Called by the thread that started the job. Returns once every
+        // element has been dealt with.
+        //
+        void
+        run_caller()
+        {
+            work(0);
+
+            //
+            // Whatever is left is being run by helpers and there is nothing
+            // to steal, so just wait for them.
+            //
+            for (auto n = m_remaining.load(std::memory_order_acquire); n != 0;
+                 n      = m_remaining.load(std::memory_order_acquire))
+            {
+                m_remaining.wait(n, std::memory_order_acquire);
+            }
+
+            // Helpers that got in before the end may still be using the pool
+            for (auto n = m_active.load(); n != 0; n = m_active.load())
+                m_active.wait(n);
+
+            if (m_exception)
+                std::rethrow_exception(m_exception);
+        }
+
+        //
+        // Called on a pool thread, possibly long after the job is over, in
+        // which case neither the pool nor the body may be touched. A helper
+        // registers as active before checking, and the caller waits for
+        // the active ones before it returns, so both stay alive for any
+        // helper that finds the job still running.
+        //
+        void
+        run_helper(m::threadpool_class& pool)
+        {
+            m_active.fetch_add(1);
+
+            if (m_remaining.load() != 0)
+            {
+                auto const slot = m_next_slot.fetch_add(1, std::memory_order_relaxed);
+
+                if (slot < m_slot_count)
+                {
+                    m_slots[slot].m_node.store(pool.do_current_node(), std::memory_order_relaxed);
+                    work(slot);
+                }
+            }
+
+            if (m_active.fetch_sub(1) == 1)
+                m_active.notify_all();
+        }
+
+    private:
+        struct range
+        {
+            std::size_t m_first;
+            std::size_t m_last;
+        };
+
+        struct slot
+        {
+            std::mutex               m_mutex;
+            std::deque<range>        m_ranges;
+            std::atomic<std::size_t> m_node{};
+        };
+
+        // How many times a thread that finds nothing to steal looks again
+        // before it gives up on the job.
+        static constexpr int steal_attempts = 64;
+
+        std::optional<range>
+        pop_own(std::size_t self)
+        {
+            auto& s = m_slots[self];
+            auto  l = std::unique_lock(s.m_mutex);
+
+            if (s.m_ranges.empty())
+                return std::nullopt;
+
+            auto const r = s.m_ranges.back();
+            s.m_ranges.pop_back();
+            return r;
+        }
+
+        std::optional<range>
+        steal(std::size_t self)
+        {
+            auto const node = m_slots[self].m_node.load(std::memory_order_relaxed);
+
+            // First pass: same node only. Second pass: everyone else.
+            for (auto const same_node: {true, false})
+            {
+                for (std::size_t i = 1; i < m_slot_count; i++)
+                {
+                    auto& s = m_slots[(self + i) % m_slot_count];
+
+                    if ((s.m_node.load(std::memory_order_relaxed) == node) != same_node)
+                        continue;
+
+                    auto l = std::unique_lock(s.m_mutex);
+
+                    if (s.m_ranges.empty())
+                        continue;
+
+                    auto const r = s.m_ranges.front();
+                    s.m_ranges.pop_front();
+                    l.unlock();
+
+                    m_statistics.stolen();
+                    return r;
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        void
+        push_own(std::size_t self, range r)
+        {
+            auto& s = m_slots[self];
+            auto  l = std::unique_lock(s.m_mutex);
+            s.m_ranges.push_back(r);
+        }
+
+        void
+        work(std::size_t self)
+        {
+            int idle = 0;
+
+            while (m_remaining.load(std::memory_order_acquire) != 0)
+            {
+                auto r = pop_own(self);
+
+                if (!r)
+                    r = steal(self);
+
+                if (!r)
+                {
+                    if (++idle == steal_attempts)
+                        return;
+
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                idle = 0;
+                execute(self, *r);
+            }
+        }
+
+        void
+        execute(std::size_t self, range r)
+        {
+            //
+            // Split off right halves, leaving them for ourselves or for
+            // thieves, until what is left is no more than one grain.
+            //
+            while (r.m_last - r.m_first > m_grain)
+            {
+                auto const middle = r.m_first + (r.m_last - r.m_first) / 2;
+                push_own(self, {middle, r.m_last});
+                r.m_last = middle;
+            }
+
+            if (!m_failed.load(std::memory_order_acquire))
+            {
+                try
+                {
+                    m_body.invoke(r.m_first, r.m_last);
+                }
+                catch (...)
+                {
+                    auto l = std::unique_lock(m_exception_mutex);
+
+                    if (!m_exception)
+                        m_exception = std::current_exception();
+
+                    m_failed.store(true, std::memory_order_release);
+                }
+            }
+
+            auto const size = r.m_last - r.m_first;
+
+            if (m_remaining.fetch_sub(size, std::memory_order_acq_rel) == size)
+                m_remaining.notify_all();
+        }
+
+        std::unique_ptr<slot[]>  m_slots;
+        std::size_t              m_slot_count;
+        std::size_t              m_grain;
+        body_type&               m_body;
+        statistics_recorder&     m_statistics;
+        std::atomic<std::size_t> m_remaining;
+        std::atomic<std::size_t> m_next_slot{1};
+        std::atomic<std::size_t> m_active{0};
+        std::atomic<bool>        m_failed{false};
+        std::mutex               m_exception_mutex;
+        std::exception_ptr       m_exception;
+    };
+} // namespace m::threadpool_impl
+
+void
+m::threadpool_class::run_parallel(std::size_t count, std::size_t grain, parallel_body& body)
+{
+    if (count == 0)
+        return;
+
+    grain = (std::max)(grain, std::size_t{1});
+
+    auto const pieces  = (count + grain - 1) / grain;
+    auto const helpers = (std::min)(do_concurrency(), pieces - 1);
+
+    if (helpers == 0)
+    {
+        body.invoke(0, count);
+        return;
+    }
+
+    auto job = std::make_shared<m::threadpool_impl::parallel_job>(
+        helpers + 1, count, grain, body, do_current_node(), do_statistics_recorder());
+
+    for (std::size_t i = 0; i < helpers; i++)
+    {
+        try
+        {
+            do_submit([this, job]() { job->run_helper(*this); }, work_priority::normal, {});
+        }
+        catch (...)
+        {
+            // The pool is going away; the calling thread does the rest.
+            break;
+        }
+    }
+
+    job->run_caller();
+}
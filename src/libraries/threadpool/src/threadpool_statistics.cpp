@@ -0,0 +1,252 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include <m/threadpool/statistics.h>
+
+namespace
+{
+    std::uint64_t
+    to_microseconds(std::chrono::steady_clock::duration d) noexcept
+    {
+        auto const us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+        return us < 0 ? 0 : static_cast<std::uint64_t>(us);
+    }
+
+    std::size_t
+    bucket_of(std::uint64_t us) noexcept
+    {
+        return (std::min)(static_cast<std::size_t>(std::bit_width(us)),
+                          m::latency_histogram::bucket_count - 1);
+    }
+
+    void
+    add(m::latency_histogram& h, std::uint64_t us) noexcept
+    {
+        using duration = m::latency_histogram::duration;
+
+        h.m_buckets[bucket_of(us)]++;
+        h.m_count++;
+        h.m_total += duration(static_cast<duration::rep>(us));
+        h.m_max = (std::max)(h.m_max, duration(static_cast<duration::rep>(us)));
+    }
+} // namespace
+
+m::latency_histogram::duration
+m::latency_histogram::percentile(double p) const noexcept
+{
+    if (m_count == 0)
+        return duration::zero();
+
+    auto const quantile = std::clamp(p, 0.0, 1.0) * static_cast<double>(m_count);
+    auto const rank     = static_cast<std::uint64_t>(std::ceil(quantile));
+
+    std::uint64_t seen = 0;
+
+    for (std::size_t i = 0; i + 1 < bucket_count; i++)
+    {
+        seen += m_buckets[i];
+
+        if (seen >= (std::max)(rank, std::uint64_t{1}))
+            return (std::min)(duration(duration::rep{1} << i), m_max);
+    }
+
+    return m_max;
+}
+
+m::threadpool_impl::statistics_recorder::statistics_recorder(bool by_description):
+    m_created(clock::now()), m_by_description(by_description)
+{}
+
+void
+m::threadpool_impl::statistics_recorder::histogram::record(clock::duration d) noexcept
+{
+    auto const us = to_microseconds(d);
+
+    m_buckets[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_total.fetch_add(us, std::memory_order_relaxed);
+
+    auto max = m_max.load(std::memory_order_relaxed);
+    while (us > max && !m_max.compare_exchange_weak(max, us, std::memory_order_relaxed))
+    {
+    }
+}
+
+m::latency_histogram
+m::threadpool_impl::statistics_recorder::histogram::load() const noexcept
+{
+    using duration = latency_histogram::duration;
+
+    latency_histogram h;
+
+    for (std::size_t i = 0; i < h.m_buckets.size(); i++)
+        h.m_buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+
+    h.m_count = m_count.load(std::memory_order_relaxed);
+    h.m_total = duration(static_cast<duration::rep>(m_total.load(std::memory_order_relaxed)));
+    h.m_max   = duration(static_cast<duration::rep>(m_max.load(std::memory_order_relaxed)));
+
+    return h;
+}
+
+void
+m::threadpool_impl::statistics_recorder::queued(std::size_t category) noexcept
+{
+    m_categories[category].m_queued.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+m::threadpool_impl::statistics_recorder::abandoned(std::size_t category) noexcept
+{
+    m_categories[category].m_queued.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void
+m::threadpool_impl::statistics_recorder::started(std::size_t     category,
+                                                 clock::duration queue_wait) noexcept
+{
+    auto& c = m_categories[category];
+
+    c.m_queued.fetch_sub(1, std::memory_order_relaxed);
+    c.m_running.fetch_add(1, std::memory_order_relaxed);
+    c.m_queue_wait.record(queue_wait);
+}
+
+void
+m::threadpool_impl::statistics_recorder::finished(std::size_t       category,
+                                                  clock::duration   queue_wait,
+                                                  clock::duration   run_time,
+                                                  std::wstring_view description) noexcept
+{
+    auto& c = m_categories[category];
+
+    c.m_run_time.record(run_time);
+    c.m_running.fetch_sub(1, std::memory_order_relaxed);
+    c.m_completed.fetch_add(1, std::memory_order_relaxed);
+
+    // Blocking work has threads of its own; it does not use the CPU workers
+    if (category != blocking_category)
+        m_busy_time.fetch_add(to_microseconds(run_time), std::memory_order_relaxed);
+
+    if (!m_by_description || description.empty())
+        return;
+
+    try
+    {
+        auto l = std::unique_lock(m_description_mutex);
+
+        auto it = m_descriptions.find(description);
+        if (it == m_descriptions.end())
+            it = m_descriptions.emplace(std::wstring(description), work_statistics{}).first;
+
+        add(it->second.m_queue_wait, to_microseconds(queue_wait));
+        add(it->second.m_run_time, to_microseconds(run_time));
+        it->second.m_completed++;
+    }
+    catch (...)
+    {
+        // Out of memory for a new description; the totals are still right
+    }
+}
+
+void
+m::threadpool_impl::statistics_recorder::stolen(std::uint64_t count) noexcept
+{
+    m_steals.fetch_add(count, std::memory_order_relaxed);
+}
+
+void
+m::threadpool_impl::statistics_recorder::timer_fired(clock::duration lateness) noexcept
+{
+    m_timer_lateness.record(lateness);
+}
+
+void
+m::threadpool_impl::statistics_recorder::workers_changed(std::size_t threads,
+                                                         std::size_t target,
+                                                         std::size_t blocked) noexcept
+{
+    m_worker_threads.store(threads, std::memory_order_relaxed);
+    m_worker_target.store(target, std::memory_order_relaxed);
+    m_blocked_workers.store(blocked, std::memory_order_relaxed);
+}
+
+void
+m::threadpool_impl::statistics_recorder::thread_started(bool compensating) noexcept
+{
+    m_threads_started.fetch_add(1, std::memory_order_relaxed);
+
+    if (compensating)
+        m_compensating_threads.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+m::threadpool_impl::statistics_recorder::thread_retired() noexcept
+{
+    m_threads_retired.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+m::threadpool_impl::statistics_recorder::target_changed(std::size_t from, std::size_t to) noexcept
+{
+    if (to > from)
+        m_target_raised.fetch_add(1, std::memory_order_relaxed);
+    else if (to < from)
+        m_target_lowered.fetch_add(1, std::memory_order_relaxed);
+}
+
+m::threadpool_statistics
+m::threadpool_impl::statistics_recorder::snapshot(std::size_t workers) const
+{
+    auto const load = [](category const& c) {
+        work_statistics s;
+
+        s.m_queue_wait = c.m_queue_wait.load();
+        s.m_run_time   = c.m_run_time.load();
+        s.m_queued     = c.m_queued.load(std::memory_order_relaxed);
+        s.m_running    = c.m_running.load(std::memory_order_relaxed);
+        s.m_completed  = c.m_completed.load(std::memory_order_relaxed);
+
+        return s;
+    };
+
+    threadpool_statistics s;
+
+    for (std::size_t i = 0; i < s.m_by_priority.size(); i++)
+        s.m_by_priority[i] = load(m_categories[i]);
+
+    using std::chrono::microseconds;
+
+    auto const busy = m_busy_time.load(std::memory_order_relaxed);
+
+    s.m_blocking       = load(m_categories[blocking_category]);
+    s.m_timer_lateness = m_timer_lateness.load();
+    s.m_workers        = workers;
+    s.m_uptime         = std::chrono::duration_cast<microseconds>(clock::now() - m_created);
+    s.m_busy_time      = microseconds(static_cast<microseconds::rep>(busy));
+    s.m_steals         = m_steals.load(std::memory_order_relaxed);
+
+    s.m_worker_threads       = m_worker_threads.load(std::memory_order_relaxed);
+    s.m_worker_target        = m_worker_target.load(std::memory_order_relaxed);
+    s.m_blocked_workers      = m_blocked_workers.load(std::memory_order_relaxed);
+    s.m_threads_started      = m_threads_started.load(std::memory_order_relaxed);
+    s.m_threads_retired      = m_threads_retired.load(std::memory_order_relaxed);
+    s.m_compensating_threads = m_compensating_threads.load(std::memory_order_relaxed);
+    s.m_target_raised        = m_target_raised.load(std::memory_order_relaxed);
+    s.m_target_lowered       = m_target_lowered.load(std::memory_order_relaxed);
+
+    if (m_by_description)
+    {
+        auto l             = std::unique_lock(m_description_mutex);
+        s.m_by_description = m_descriptions;
+    }
+
+    return s;
+}
@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+#include <m/threadpool/strand.h>
+#include <m/threadpool/threadpool.h>
+
+namespace
+{
+    //
+    // How many items a strand runs before handing the rest back to the
+    // pool, and the strand, if any, the current thread is running work for.
+    //
+    constexpr std::size_t batch_limit = 64;
+
+    thread_local m::strand const* t_current_strand{};
+} // namespace
+
+std::shared_ptr<m::strand>
+m::threadpool_class::make_strand(work_priority priority)
+{
+    return std::make_shared<strand>(*this, priority);
+}
+
+m::strand::strand(threadpool_class& pool, work_priority priority) noexcept:
+    m_pool(&pool), m_priority(priority)
+{}
+
+bool
+m::strand::running_in_this_thread() const noexcept
+{
+    return t_current_strand == this;
+}
+
+void
+m::strand::enqueue(std::unique_ptr<node> n)
+{
+    auto const p    = n.release();
+    auto const prev = m_tail.exchange(p, std::memory_order_acq_rel);
+
+    if (prev != nullptr)
+    {
+        // The drainer waits for this link if it gets to `prev` first
+        prev->m_next.store(p, std::memory_order_release);
+        return;
+    }
+
+    //
+    // The strand was idle so this item starts a new run. Should the pool
+    // refuse it (e.g. while shutting down) the run happens here instead,
+    // which is still serial since nobody else can be draining.
+    //
+    if (!try_schedule(p))
+        drain(p);
+}
+
+bool
+m::strand::try_schedule(node* head) noexcept
+{
+    try
+    {
+        m_pool->submit([self = shared_from_this(), head]() { self->drain(head); }, m_priority);
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+void
+m::strand::drain(node* head)
+{
+    auto const previous = t_current_strand;
+    t_current_strand    = this;
+
+    for (std::size_t ran = 1;; ran++)
+    {
+        //
+        // Letting an exception out would leave the rest of the queue, and
+        // with it the strand, stuck behind a non-null tail.
+        //
+        try
+        {
+            head->m_work();
+        }
+        catch (...)
+        {
+            // As for timer callbacks, this is not reported
+        }
+
+        auto next = head->m_next.load(std::memory_order_acquire);
+
+        if (next == nullptr)
+        {
+            auto expected = head;
+
+            if (m_tail.compare_exchange_strong(
+                    expected, nullptr, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                delete head;
+                break;
+            }
+
+            // A post has taken the tail but not yet linked its item
+            while ((next = head->m_next.load(std::memory_order_acquire)) == nullptr)
+                std::this_thread::yield();
+        }
+
+        delete head;
+        head = next;
+
+        if (ran == batch_limit && try_schedule(head))
+            break;
+    }
+
+    t_current_strand = previous;
+}
@@ -0,0 +1,506 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <m/thread_description/thread_description.h>
+#include <m/threadpool/threadpool.h>
+#include <m/threadpool/virtual_time.h>
+
+namespace m::threadpool_impl
+{
+    class virtual_timer;
+
+    //
+    // State shared by a virtual time threadpool and its timers, which may
+    // outlive it. A single mutex covers the clock, the armed timers and
+    // the count of outstanding work; callbacks and work never run with it
+    // held.
+    //
+    class virtual_clock
+    {
+    public:
+        using duration = threadpool_types::duration;
+        using clock    = statistics_recorder::clock;
+
+        explicit virtual_clock(threadpool_options const& options):
+            m_pool(make_platform_threadpool(options)),
+            m_statistics(options.m_statistics_by_description)
+        {}
+
+        //
+        // Counts `work` as outstanding until it has run and hands it, with
+        // the bookkeeping wrapped around it, to `to_pool`. Called with
+        // m_mutex held.
+        //
+        template <typename Submit>
+        void
+        submit(std::move_only_function<void()>&& work,
+               std::size_t                       category,
+               std::wstring&&                    description,
+               Submit&&                          to_pool)
+        {
+            m_outstanding++;
+            m_statistics.queued(category);
+
+            try
+            {
+                to_pool([this,
+                         work        = std::move(work),
+                         category    = category,
+                         description = std::move(description),
+                         enqueued    = clock::now()]() mutable {
+                    run(work, category, description, enqueued);
+                });
+            }
+            catch (...)
+            {
+                m_outstanding--;
+                m_statistics.abandoned(category);
+                throw;
+            }
+        }
+
+        void
+        advance(duration d);
+
+        // Called with m_mutex held
+        void
+        arm(virtual_timer& t, duration deadline);
+
+        // Called with m_mutex held
+        void
+        disarm(virtual_timer& t) noexcept;
+
+        void
+        wait_until_idle();
+
+        std::mutex                        m_mutex;
+        std::condition_variable           m_cv;
+        std::shared_ptr<threadpool_class> m_pool;
+        statistics_recorder               m_statistics;
+        duration                          m_now{};
+        std::size_t                       m_outstanding{};
+        std::uint64_t                     m_sequence{};
+
+        // Armed timers by deadline, then by the order they were armed in
+        std::map<std::pair<duration, std::uint64_t>, virtual_timer*> m_timers;
+
+    private:
+        void
+        run(std::move_only_function<void()>& work,
+            std::size_t                      category,
+            std::wstring const&              description,
+            clock::time_point                enqueued) noexcept;
+
+        // Called with m_mutex held
+        void
+        fire(virtual_timer& t);
+    };
+
+    class virtual_timer : public m::timer
+    {
+    public:
+        virtual_timer(std::shared_ptr<virtual_clock> clock,
+                      timer_function&&               function,
+                      timer_description&&            description):
+            m_clock(std::move(clock)),
+            m_function(std::move(function)),
+            m_description(std::move(description))
+        {}
+
+        virtual_timer(std::shared_ptr<virtual_clock> clock,
+                      timer_cancellable_function&&   function,
+                      timer_description&&            description):
+            m_clock(std::move(clock)),
+            m_cancellable_function(std::move(function)),
+            m_description(std::move(description))
+        {}
+
+        virtual_timer(virtual_timer const&) = delete;
+
+        void
+        operator=(virtual_timer const&) = delete;
+
+        ~virtual_timer()
+        {
+            auto l = std::unique_lock(m_clock->m_mutex);
+
+            m_destroying = true;
+            m_clock->disarm(*this);
+            m_clock->m_cv.wait(l, [this]() { return !m_in_flight; });
+        }
+
+    protected:
+        bool
+        do_cancel_requested() override
+        {
+            return m_cancel_requested.load(std::memory_order_acquire);
+        }
+
+        bool
+        do_done() override
+        {
+            return m_done.load(std::memory_order_acquire);
+        }
+
+        void
+        do_try_cancel() override
+        {
+            m_cancel_requested.store(true, std::memory_order_release);
+
+            auto l = std::unique_lock(m_clock->m_mutex);
+
+            // A timer still waiting for its deadline never fires; one that
+            // has fired sees m_cancel_requested.
+            if (m_armed)
+            {
+                m_clock->disarm(*this);
+                m_done.store(true, std::memory_order_release);
+            }
+        }
+
+        void
+        do_set(duration dur, duration) override
+        {
+            auto l = std::unique_lock(m_clock->m_mutex);
+
+            m_period = duration::zero();
+            m_done.store(false, std::memory_order_release);
+            m_clock->arm(*this, m_clock->m_now + (std::max)(dur, duration::zero()));
+        }
+
+        void
+        do_set_periodic(duration period, duration phase, missed_tick_policy) override
+        {
+            if (period <= duration::zero())
+                throw std::invalid_argument("periodic timer period must be positive");
+
+            auto l = std::unique_lock(m_clock->m_mutex);
+
+            m_period = period;
+            m_done.store(false, std::memory_order_release);
+            m_clock->arm(*this, m_clock->m_now + (std::max)(phase, duration::zero()));
+        }
+
+        //
+        // Runs the callback on a worker. Time does not move until it has
+        // returned, so a periodic timer's next tick is always ahead.
+        //
+        void
+        run() noexcept
+        {
+            if (!m_cancel_requested.load(std::memory_order_acquire))
+            {
+                try
+                {
+                    if (m_function)
+                        m_function();
+                    else
+                        m_cancellable_function(m_cancel_requested);
+                }
+                catch (...)
+                {
+                    // As for the platform timers, this is not reported
+                }
+            }
+
+            auto l = std::unique_lock(m_clock->m_mutex);
+
+            if (m_period != duration::zero() && !m_destroying &&
+                !m_cancel_requested.load(std::memory_order_acquire))
+                m_clock->arm(*this, m_key.first + m_period);
+            else
+                m_done.store(true, std::memory_order_release);
+
+            //
+            // Notify while still holding the lock; a waiting destructor
+            // cannot proceed until it is released and this thread does not
+            // touch the timer afterwards.
+            //
+            m_in_flight = false;
+            m_clock->m_cv.notify_all();
+        }
+
+        // Called with the clock's mutex held, only as the timer fires
+        std::wstring
+        take_description()
+        {
+            if (m_formatted_description.empty() && !m_description.empty())
+            {
+                try
+                {
+                    m_formatted_description = m_description.str();
+                }
+                catch (...)
+                {
+                    // Only diagnostics go without
+                }
+            }
+
+            return m_formatted_description;
+        }
+
+        friend class virtual_clock;
+
+        std::shared_ptr<virtual_clock>     m_clock;
+        timer_function                     m_function;
+        timer_cancellable_function         m_cancellable_function;
+        timer_description                  m_description;
+        std::wstring                       m_formatted_description;
+        duration                           m_period{}; // zero for one-shot timers
+        std::pair<duration, std::uint64_t> m_key{};    // in m_clock->m_timers
+        bool                               m_armed{false};
+        bool                               m_in_flight{false};
+        bool                               m_destroying{false};
+        std::atomic<bool>                  m_cancel_requested{false};
+        std::atomic<bool>                  m_done{true};
+    };
+
+    class virtual_time_threadpool_impl : public virtual_time_threadpool
+    {
+    public:
+        explicit virtual_time_threadpool_impl(threadpool_options const& options):
+            m_clock(std::make_shared<virtual_clock>(options))
+        {}
+
+        ~virtual_time_threadpool_impl()
+        {
+            // Work in flight refers to the clock without owning it
+            m_clock->wait_until_idle();
+        }
+
+    protected:
+        duration
+        do_now() override
+        {
+            auto l = std::unique_lock(m_clock->m_mutex);
+            return m_clock->m_now;
+        }
+
+        void
+        do_advance(duration d) override
+        {
+            m_clock->advance(d);
+        }
+
+        void
+        do_submit(std::move_only_function<void()>&& work,
+                  work_priority                     priority,
+                  std::wstring&&                    description) override
+        {
+            auto l = std::unique_lock(m_clock->m_mutex);
+
+            m_clock->submit(std::move(work),
+                            static_cast<std::size_t>(priority),
+                            std::move(description),
+                            [&](auto&& f) { m_clock->m_pool->submit(std::move(f), priority); });
+        }
+
+        void
+        do_submit_blocking(std::move_only_function<void()>&& work,
+                           std::wstring&&                    description) override
+        {
+            auto l = std::unique_lock(m_clock->m_mutex);
+
+            m_clock->submit(std::move(work),
+                            statistics_recorder::blocking_category,
+                            std::move(description),
+                            [&](auto&& f) { m_clock->m_pool->submit_blocking(std::move(f)); });
+        }
+
+        void
+        do_submit_on_node(std::move_only_function<void()>&& work,
+                          work_priority                     priority,
+                          std::size_t                       node) override
+        {
+            auto l = std::unique_lock(m_clock->m_mutex);
+
+            m_clock->submit(std::move(work),
+                            static_cast<std::size_t>(priority),
+                            {},
+                            [&](auto&& f) {
+                                m_clock->m_pool->submit_on_node(node, std::move(f), priority);
+                            });
+        }
+
+        std::size_t
+        do_node_count() override
+        {
+            return m_clock->m_pool->node_count();
+        }
+
+        std::size_t
+        do_current_node() override
+        {
+            // Only used as a hint; the platform pool does not expose its own
+            return 0;
+        }
+
+        std::size_t
+        do_concurrency() override
+        {
+            return m_clock->m_pool->concurrency();
+        }
+
+        statistics_recorder&
+        do_statistics_recorder() override
+        {
+            return m_clock->m_statistics;
+        }
+
+        //
+        // Descriptors become ready in real time, so these waits are left
+        // to the platform pool and not counted as outstanding work.
+        //
+        std::shared_ptr<m::fd_wait>
+        do_wait_for_fd(int fd, fd_events events, fd_wait_function&& callback) override
+        {
+            return m_clock->m_pool->wait_for_fd(fd, events, std::move(callback));
+        }
+
+        std::shared_ptr<timer>
+        do_create_timer(timer_function&& task, timer_description&& description) override
+        {
+            return std::make_shared<virtual_timer>(
+                m_clock, std::move(task), std::move(description));
+        }
+
+        std::shared_ptr<timer>
+        do_create_timer(timer_cancellable_function&& task,
+                        timer_description&&          description) override
+        {
+            return std::make_shared<virtual_timer>(
+                m_clock, std::move(task), std::move(description));
+        }
+
+        std::shared_ptr<virtual_clock> m_clock;
+    };
+} // namespace m::threadpool_impl
+
+void
+m::threadpool_impl::virtual_clock::run(std::move_only_function<void()>& work,
+                                       std::size_t                      category,
+                                       std::wstring const&              description,
+                                       clock::time_point                enqueued) noexcept
+{
+    auto const start      = clock::now();
+    auto const queue_wait = start - enqueued;
+
+    m_statistics.started(category, queue_wait);
+
+    if (description.empty())
+    {
+        work();
+    }
+    else
+    {
+        m::thread_description td(description);
+        work();
+    }
+
+    m_statistics.finished(category, queue_wait, clock::now() - start, description);
+
+    auto l = std::unique_lock(m_mutex);
+
+    if (--m_outstanding == 0)
+        m_cv.notify_all();
+}
+
+void
+m::threadpool_impl::virtual_clock::advance(duration d)
+{
+    auto       l      = std::unique_lock(m_mutex);
+    auto const target = m_now + (std::max)(d, duration::zero());
+
+    //
+    // Step from deadline to deadline, letting everything that happens at
+    // one finish before moving on; callbacks may arm timers that fall due
+    // before `target`, including at the current time.
+    //
+    for (;;)
+    {
+        m_cv.wait(l, [this]() { return m_outstanding == 0; });
+
+        if (m_timers.empty() || m_timers.begin()->first.first > target)
+            break;
+
+        m_now = m_timers.begin()->first.first;
+
+        while (!m_timers.empty() && m_timers.begin()->first.first == m_now)
+            fire(*m_timers.begin()->second);
+    }
+
+    m_now = target;
+}
+
+void
+m::threadpool_impl::virtual_clock::arm(virtual_timer& t, duration deadline)
+{
+    disarm(t);
+
+    t.m_key   = {deadline, m_sequence++};
+    t.m_armed = true;
+    m_timers.emplace(t.m_key, &t);
+}
+
+void
+m::threadpool_impl::virtual_clock::disarm(virtual_timer& t) noexcept
+{
+    if (!t.m_armed)
+        return;
+
+    m_timers.erase(t.m_key);
+    t.m_armed = false;
+}
+
+void
+m::threadpool_impl::virtual_clock::fire(virtual_timer& t)
+{
+    disarm(t);
+
+    t.m_in_flight = true;
+
+    // Timers are never late in virtual time
+    m_statistics.timer_fired(duration::zero());
+
+    try
+    {
+        submit([&t]() { t.run(); },
+               static_cast<std::size_t>(work_priority::normal),
+               t.take_description(),
+               [this](auto&& f) { m_pool->submit(std::move(f)); });
+    }
+    catch (...)
+    {
+        // The platform pool is out of resources; this was the last tick
+        t.m_in_flight = false;
+        t.m_done.store(true, std::memory_order_release);
+        m_cv.notify_all();
+    }
+}
+
+void
+m::threadpool_impl::virtual_clock::wait_until_idle()
+{
+    auto l = std::unique_lock(m_mutex);
+    m_cv.wait(l, [this]() { return m_outstanding == 0; });
+}
+
+std::shared_ptr<m::virtual_time_threadpool>
+m::make_virtual_time_threadpool(threadpool_options const& options)
+{
+    return std::make_shared<m::threadpool_impl::virtual_time_threadpool_impl>(options);
+}
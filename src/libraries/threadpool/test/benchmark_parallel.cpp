@@ -0,0 +1,186 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <functional>
+#include <numeric>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <m/threadpool/threadpool.h>
+
+//
+// Compares parallel_for / parallel_reduce against a plain loop on one
+// thread and against the standard parallel algorithms on a few workloads
+// shaped like ours:
+//
+//  - uniform:  cheap, identical work per element (summing a transform)
+//  - rows:     scanning text rows for delimiters, as when reading CSV
+//  - uneven:   per-element cost that varies wildly, as when decoding a
+//              directory full of PE files of very different sizes
+//
+// Note that with libstdc++ std::execution::par only runs in parallel when
+// the TBB backend is available; otherwise it is sequential.
+//
+
+namespace
+{
+    template <typename F>
+    std::chrono::microseconds
+    time(F&& f)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+    }
+
+    void
+    report(std::string_view          workload,
+           std::chrono::microseconds single,
+           std::chrono::microseconds std_par,
+           std::chrono::microseconds pool)
+    {
+        std::println("{:8} single thread {:>10}  std::execution::par {:>10}  parallel_* {:>10}",
+                     workload,
+                     single,
+                     std_par,
+                     pool);
+    }
+
+    std::uint64_t
+    collatz_steps(std::uint64_t n)
+    {
+        std::uint64_t steps = 0;
+
+        while (n != 1)
+        {
+            n = (n % 2 == 0) ? n / 2 : 3 * n + 1;
+            steps++;
+        }
+
+        return steps;
+    }
+} // namespace
+
+TEST(ParallelBenchmark, Uniform)
+{
+    std::vector<double> v(20'000'000);
+    std::iota(v.begin(), v.end(), 1.0);
+
+    auto const transform = [](double d) { return std::sqrt(d); };
+
+    double single{}, std_par{}, pool{};
+
+    auto const t_single = time([&]() {
+        single = std::transform_reduce(v.begin(), v.end(), 0.0, std::plus<>{}, transform);
+    });
+
+    auto const t_std_par = time([&]() {
+        std_par = std::transform_reduce(
+            std::execution::par, v.begin(), v.end(), 0.0, std::plus<>{}, transform);
+    });
+
+    auto const t_pool = time([&]() {
+        pool = m::threadpool->parallel_reduce(v, 64 * 1024, 0.0, std::plus<>{}, transform);
+    });
+
+    report("uniform", t_single, t_std_par, t_pool);
+
+    EXPECT_NEAR(pool / single, 1.0, 1e-9);
+    EXPECT_NEAR(std_par / single, 1.0, 1e-9);
+}
+
+TEST(ParallelBenchmark, Rows)
+{
+    std::mt19937                       rng(7);
+    std::uniform_int_distribution<int> field_length(1, 24);
+
+    std::vector<std::string> rows(400'000);
+
+    for (auto& row: rows)
+    {
+        for (int field = 0; field < 16; field++)
+        {
+            row.append(static_cast<std::size_t>(field_length(rng)), 'x');
+            row.push_back(',');
+        }
+    }
+
+    auto const count_fields = [](std::string const& row) {
+        return static_cast<std::size_t>(std::count(row.begin(), row.end(), ','));
+    };
+
+    std::size_t single{}, std_par{}, pool{};
+
+    auto const t_single = time([&]() {
+        single = std::transform_reduce(
+            rows.begin(), rows.end(), std::size_t{0}, std::plus<>{}, count_fields);
+    });
+
+    auto const t_std_par = time([&]() {
+        std_par = std::transform_reduce(std::execution::par,
+                                        rows.begin(),
+                                        rows.end(),
+                                        std::size_t{0},
+                                        std::plus<>{},
+                                        count_fields);
+    });
+
+    auto const t_pool = time([&]() {
+        pool = m::threadpool->parallel_reduce(
+            rows, 1024, std::size_t{0}, std::plus<>{}, count_fields);
+    });
+
+    report("rows", t_single, t_std_par, t_pool);
+
+    EXPECT_EQ(pool, single);
+    EXPECT_EQ(std_par, single);
+}
+
+TEST(ParallelBenchmark, Uneven)
+{
+    //
+    // Most elements are cheap, a few are very expensive, and they are
+    // clustered so that a static split would leave threads idle.
+    //
+    std::vector<std::uint64_t> v(200'000);
+    std::iota(v.begin(), v.end(), 1);
+
+    std::vector<std::uint64_t> single(v.size()), std_par(v.size()), pool(v.size());
+
+    auto const work = [&v](std::uint64_t n) {
+        auto const repeat = (n > v.size() * 9 / 10) ? 200 : 1;
+
+        std::uint64_t steps = 0;
+        for (int i = 0; i < repeat; i++)
+            steps += collatz_steps(n + static_cast<std::uint64_t>(i));
+
+        return steps;
+    };
+
+    auto const t_single = time([&]() { std::transform(v.begin(), v.end(), single.begin(), work); });
+
+    auto const t_std_par = time([&]() {
+        std::transform(std::execution::par, v.begin(), v.end(), std_par.begin(), work);
+    });
+
+    auto const t_pool = time([&]() {
+        m::threadpool->parallel_for(v, 256, [&](std::uint64_t& n) { pool[n - 1] = work(n); });
+    });
+
+    report("uneven", t_single, t_std_par, t_pool);
+
+    EXPECT_EQ(pool, single);
+    EXPECT_EQ(std_par, single);
+}
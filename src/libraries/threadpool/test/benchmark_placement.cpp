@@ -0,0 +1,132 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <print>
+#include <string_view>
+#include <vector>
+
+#include <m/threadpool/threadpool.h>
+
+//
+// Memory bound work on pools with different worker placements.
+//
+// The data is split into partitions, each owned by a NUMA node. A task on
+// the owning node first writes the partition, so that the kernel's first
+// touch policy allocates its pages on that node, and then repeated passes
+// sum every partition. With pinned, per node workers and submit_on_node
+// the passes read local memory; unpinned workers read whatever node the
+// pages happened to land on. On a machine with a single node all three
+// should come out about the same.
+//
+
+namespace
+{
+    constexpr std::size_t partition_count = 64;
+    constexpr std::size_t partition_words = 128 * 1024; // 1MiB
+    constexpr int         pass_count      = 20;
+
+    struct partition
+    {
+        std::unique_ptr<std::uint64_t[]> m_data;
+        std::size_t                      m_node{};
+        std::uint64_t                    m_sum{};
+    };
+
+    //
+    // Runs `f` once per partition, on the partition's node when
+    // `use_nodes`, and waits for all of them.
+    //
+    template <typename F>
+    void
+    for_each_partition(m::threadpool_class&    pool,
+                       std::vector<partition>& partitions,
+                       bool                    use_nodes,
+                       F const&                f)
+    {
+        struct state
+        {
+            std::atomic<std::size_t> m_remaining;
+            std::promise<void>       m_done;
+        };
+
+        // Shared with the tasks, as the last one may still be inside
+        // set_value() when the wait below returns
+        auto const s = std::make_shared<state>(partitions.size());
+        auto       done   = s->m_done.get_future();
+
+        for (auto& p: partitions)
+        {
+            auto work = [&f, &p, s]() {
+                f(p);
+                if (--s->m_remaining == 0)
+                    s->m_done.set_value();
+            };
+
+            if (use_nodes)
+                pool.submit_on_node(p.m_node, work);
+            else
+                pool.submit(work);
+        }
+
+        done.wait();
+    }
+
+    void
+    run(std::string_view name, m::threadpool_options const& options, bool use_nodes)
+    {
+        auto const pool  = m::make_platform_threadpool(options);
+        auto const nodes = pool->node_count();
+
+        std::vector<partition> partitions(partition_count);
+
+        for (std::size_t i = 0; i < partitions.size(); i++)
+            partitions[i].m_node = i % nodes;
+
+        for_each_partition(*pool, partitions, use_nodes, [](partition& p) {
+            p.m_data = std::make_unique_for_overwrite<std::uint64_t[]>(partition_words);
+            for (std::size_t i = 0; i < partition_words; i++)
+                p.m_data[i] = i;
+        });
+
+        auto const start = std::chrono::steady_clock::now();
+
+        for (int pass = 0; pass < pass_count; pass++)
+        {
+            for_each_partition(*pool, partitions, use_nodes, [](partition& p) {
+                std::uint64_t sum = 0;
+                for (std::size_t i = 0; i < partition_words; i++)
+                    sum += p.m_data[i];
+                p.m_sum = sum;
+            });
+        }
+
+        auto const elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        std::println("{:10} workers {:>4}  nodes {:>2}  {} passes over {}MiB {:>10}",
+                     name,
+                     pool->concurrency(),
+                     nodes,
+                     pass_count,
+                     partition_count * partition_words * sizeof(std::uint64_t) / (1024 * 1024),
+                     elapsed);
+
+        for (auto const& p: partitions)
+            EXPECT_EQ(p.m_sum, partition_words * (partition_words - 1) / 2);
+    }
+} // namespace
+
+TEST(PlacementBenchmark, MemoryBound)
+{
+    run("unpinned", {}, false);
+    run("per core", {.m_placement = m::worker_placement::per_core}, true);
+    run("per node", {.m_placement = m::worker_placement::per_node}, true);
+}
@@ -0,0 +1,106 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <print>
+#include <random>
+#include <vector>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+#include <m/threadpool/threadpool.h>
+
+using namespace std::chrono_literals;
+
+//
+// Arms a few thousand timers spread over a second, the way retries and
+// idle sweeps tend to be, once with no tolerance and once with a tolerance
+// window, and compares how often the process had to be woken up.
+//
+// On Linux the context switch counters from getrusage() cover every thread
+// in the process: the timer engine, the workers running the callbacks and
+// the thread waiting for them. They are a fair proxy for idle CPU wakeups.
+//
+
+namespace
+{
+    constexpr std::size_t timer_count = 5'000;
+    constexpr auto        spread      = 1000ms;
+
+    struct run_result
+    {
+        std::chrono::steady_clock::duration m_elapsed;
+        std::int64_t                        m_context_switches;
+    };
+
+    std::int64_t
+    context_switches()
+    {
+#ifdef WIN32
+        return 0;
+#else
+        rusage usage{};
+        ::getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_nvcsw + usage.ru_nivcsw;
+#endif
+    }
+
+    run_result
+    run(m::threadpool_types::duration tolerance)
+    {
+        std::atomic<std::size_t> fired{0};
+
+        std::vector<std::shared_ptr<m::timer>> timers;
+        timers.reserve(timer_count);
+
+        for (std::size_t i = 0; i < timer_count; i++)
+        {
+            timers.push_back(m::threadpool->create_timer([&fired]() {
+                if (fired.fetch_add(1, std::memory_order_acq_rel) + 1 == timer_count)
+                    fired.notify_all();
+            }));
+        }
+
+        std::mt19937                             rng(4242);
+        std::uniform_int_distribution<long long> dist(1, spread.count());
+
+        auto const start_switches = context_switches();
+        auto const start          = std::chrono::steady_clock::now();
+
+        for (auto& t: timers)
+            t->set(std::chrono::milliseconds(dist(rng)), tolerance);
+
+        for (auto n = fired.load(std::memory_order_acquire); n != timer_count;
+             n      = fired.load(std::memory_order_acquire))
+        {
+            fired.wait(n, std::memory_order_acquire);
+        }
+
+        return {std::chrono::steady_clock::now() - start, context_switches() - start_switches};
+    }
+} // namespace
+
+TEST(TimerCoalescing, WakeupReduction)
+{
+#ifdef WIN32
+    GTEST_SKIP() << "context switch counts are only collected on Linux";
+#else
+    auto const exact     = run(m::threadpool_types::duration::zero());
+    auto const coalesced = run(50ms);
+
+    std::println("{} timers over {}:", timer_count, spread);
+    std::println("  no tolerance:   {} context switches in {}",
+                 exact.m_context_switches,
+                 std::chrono::duration_cast<std::chrono::milliseconds>(exact.m_elapsed));
+    std::println("  50ms tolerance: {} context switches in {}",
+                 coalesced.m_context_switches,
+                 std::chrono::duration_cast<std::chrono::milliseconds>(coalesced.m_elapsed));
+#endif
+}
@@ -0,0 +1,128 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#ifndef WIN32
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <system_error>
+#include <thread>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <m/threadpool/threadpool.h>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    struct pipe_fds
+    {
+        pipe_fds()
+        {
+            int fds[2];
+            EXPECT_EQ(::pipe(fds), 0);
+            m_read  = fds[0];
+            m_write = fds[1];
+        }
+
+        ~pipe_fds()
+        {
+            ::close(m_read);
+            ::close(m_write);
+        }
+
+        int m_read{-1};
+        int m_write{-1};
+    };
+} // namespace
+
+TEST(FdWait, PipeBecomesReadable)
+{
+    pipe_fds p;
+
+    auto const ready  = std::make_shared<std::promise<m::fd_events>>();
+    auto       future = ready->get_future();
+
+    auto const wait = m::threadpool->wait_for_fd(
+        p.m_read, m::fd_events::readable, [ready](m::fd_events e) { ready->set_value(e); });
+
+    EXPECT_EQ(future.wait_for(20ms), std::future_status::timeout);
+
+    char const c = 'x';
+    ASSERT_EQ(::write(p.m_write, &c, 1), 1);
+
+    ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+    EXPECT_EQ(future.get() & m::fd_events::readable, m::fd_events::readable);
+}
+
+TEST(FdWait, RearmFromCallback)
+{
+    auto const efd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    ASSERT_NE(efd, -1);
+
+    std::atomic<int> signalled{0};
+    auto const       done   = std::make_shared<std::promise<void>>();
+    auto             future = done->get_future();
+
+    std::shared_ptr<m::fd_wait> wait;
+
+    wait = m::threadpool->wait_for_fd(efd, m::fd_events::readable, [&, done](m::fd_events) {
+        std::uint64_t value{};
+        static_cast<void>(::read(efd, &value, sizeof(value)));
+
+        if (++signalled == 3)
+            done->set_value();
+        else
+            wait->rearm();
+    });
+
+    for (int i = 0; i < 3; i++)
+    {
+        auto const before = signalled.load();
+
+        std::uint64_t const one = 1;
+        ASSERT_EQ(::write(efd, &one, sizeof(one)), static_cast<ssize_t>(sizeof(one)));
+
+        for (auto const deadline = std::chrono::steady_clock::now() + 10s;
+             signalled == before && std::chrono::steady_clock::now() < deadline;)
+            std::this_thread::sleep_for(1ms);
+    }
+
+    EXPECT_EQ(future.wait_for(10s), std::future_status::ready);
+
+    wait.reset();
+    ::close(efd);
+}
+
+TEST(FdWait, CancelledWaitNeverCalls)
+{
+    pipe_fds p;
+
+    std::atomic<bool> called{false};
+
+    auto const wait = m::threadpool->wait_for_fd(
+        p.m_read, m::fd_events::readable, [&](m::fd_events) { called = true; });
+
+    EXPECT_TRUE(wait->cancel());
+
+    char const c = 'x';
+    ASSERT_EQ(::write(p.m_write, &c, 1), 1);
+
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(called);
+}
+
+TEST(FdWait, InvalidDescriptorThrows)
+{
+    EXPECT_THROW(m::threadpool->wait_for_fd(-1, m::fd_events::readable, [](m::fd_events) {}),
+                 std::system_error);
+}
+
+#endif
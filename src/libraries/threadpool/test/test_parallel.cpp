@@ -0,0 +1,103 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <m/threadpool/threadpool.h>
+
+TEST(Parallel, ForVisitsEveryElementOnce)
+{
+    std::vector<std::atomic<int>> visits(100'003);
+
+    m::threadpool->parallel_for(visits, 100, [](std::atomic<int>& v) { v.fetch_add(1); });
+
+    for (auto& v: visits)
+        EXPECT_EQ(v.load(), 1);
+}
+
+TEST(Parallel, ForEmptyRange)
+{
+    std::vector<int> empty;
+    bool             called = false;
+
+    m::threadpool->parallel_for(empty, 16, [&](int) { called = true; });
+
+    EXPECT_FALSE(called);
+}
+
+TEST(Parallel, ForZeroGrain)
+{
+    std::vector<int>  v(1000, 1);
+    std::atomic<long> sum{0};
+
+    m::threadpool->parallel_for(v, 0, [&](int i) { sum.fetch_add(i); });
+
+    EXPECT_EQ(sum.load(), 1000);
+}
+
+TEST(Parallel, ForPropagatesException)
+{
+    std::vector<int> v(10'000);
+    std::iota(v.begin(), v.end(), 0);
+
+    EXPECT_THROW(m::threadpool->parallel_for(v,
+                                             10,
+                                             [](int i) {
+                                                 if (i == 5'000)
+                                                     throw std::runtime_error("boom");
+                                             }),
+                 std::runtime_error);
+}
+
+TEST(Parallel, ForNested)
+{
+    std::vector<int>           outer(64);
+    std::vector<std::uint64_t> sums(outer.size());
+    std::vector<int>           inner(10'000, 1);
+
+    std::iota(outer.begin(), outer.end(), 0);
+
+    m::threadpool->parallel_for(outer, 1, [&](int i) {
+        std::atomic<std::uint64_t> sum{0};
+        m::threadpool->parallel_for(inner, 256, [&](int x) { sum.fetch_add(x); });
+        sums[i] = sum.load();
+    });
+
+    for (auto s: sums)
+        EXPECT_EQ(s, inner.size());
+}
+
+TEST(Parallel, ReduceMatchesSequential)
+{
+    std::vector<std::uint64_t> v(1'000'000);
+    std::iota(v.begin(), v.end(), 1);
+
+    auto const sum = m::threadpool->parallel_reduce(v, 1000, std::uint64_t{0}, std::plus<>{});
+
+    EXPECT_EQ(sum, std::accumulate(v.begin(), v.end(), std::uint64_t{0}));
+}
+
+TEST(Parallel, ReducePreservesOrder)
+{
+    // Concatenation is associative but not commutative
+    std::vector<int> v(5'000);
+    std::iota(v.begin(), v.end(), 0);
+
+    auto const to_string = [](int i) { return std::to_string(i) + ","; };
+
+    auto const parallel =
+        m::threadpool->parallel_reduce(v, 7, std::string{}, std::plus<>{}, to_string);
+
+    std::string sequential;
+    for (auto i: v)
+        sequential += to_string(i);
+
+    EXPECT_EQ(parallel, sequential);
+}
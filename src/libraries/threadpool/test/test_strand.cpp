@@ -0,0 +1,130 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <m/threadpool/strand.h>
+#include <m/threadpool/threadpool.h>
+
+using namespace std::chrono_literals;
+
+TEST(Strand, SerialAndInOrder)
+{
+    constexpr std::size_t producer_count = 4;
+    constexpr std::size_t per_producer   = 2'500;
+
+    auto const s = m::threadpool->make_strand();
+
+    // Only ever touched from the strand, so no synchronization
+    std::vector<std::size_t> last_seen(producer_count);
+    std::size_t              out_of_order{0};
+    std::size_t              ran{0};
+
+    std::atomic<bool> inside{false};
+    std::atomic<bool> overlapped{false};
+    auto const        done   = std::make_shared<std::promise<void>>();
+    auto              future = done->get_future();
+
+    std::vector<std::thread> producers;
+
+    for (std::size_t p = 0; p < producer_count; p++)
+    {
+        producers.emplace_back([&, p]() {
+            for (std::size_t i = 1; i <= per_producer; i++)
+            {
+                s->post([&, done, p, i]() {
+                    if (inside.exchange(true))
+                        overlapped = true;
+
+                    if (last_seen[p] + 1 != i)
+                        out_of_order++;
+
+                    last_seen[p] = i;
+
+                    inside = false;
+
+                    if (++ran == producer_count * per_producer)
+                        done->set_value();
+                });
+            }
+        });
+    }
+
+    for (auto& t: producers)
+        t.join();
+
+    ASSERT_EQ(future.wait_for(30s), std::future_status::ready);
+
+    EXPECT_FALSE(overlapped);
+    EXPECT_EQ(out_of_order, 0u);
+}
+
+TEST(Strand, RunningInThisThread)
+{
+    auto const s     = m::threadpool->make_strand();
+    auto const other = m::threadpool->make_strand();
+
+    EXPECT_FALSE(s->running_in_this_thread());
+
+    auto const result = std::make_shared<std::promise<std::pair<bool, bool>>>();
+    auto       future = result->get_future();
+
+    s->post([s, other, result]() {
+        result->set_value({s->running_in_this_thread(), other->running_in_this_thread()});
+    });
+
+    auto const [in_s, in_other] = future.get();
+
+    EXPECT_TRUE(in_s);
+    EXPECT_FALSE(in_other);
+}
+
+TEST(Strand, RestartsAfterIdle)
+{
+    auto const s = m::threadpool->make_strand(m::work_priority::high);
+
+    for (int round = 0; round < 3; round++)
+    {
+        auto const ran    = std::make_shared<std::promise<void>>();
+        auto       future = ran->get_future();
+
+        s->post([ran]() { ran->set_value(); });
+
+        EXPECT_EQ(future.wait_for(10s), std::future_status::ready);
+
+        // Give the strand time to go idle again
+        std::this_thread::sleep_for(5ms);
+    }
+}
+
+TEST(Strand, KeepsDrainingAfterWorkThrows)
+{
+    auto const s = m::threadpool->make_strand();
+
+    for (int round = 0; round < 2; round++)
+    {
+        auto const ran    = std::make_shared<std::promise<bool>>();
+        auto       future = ran->get_future();
+
+        s->post([]() { throw std::runtime_error("posted work failed"); });
+        s->post([s, ran]() { ran->set_value(s->running_in_this_thread()); });
+
+        ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+        EXPECT_TRUE(future.get());
+
+        // The second round starts a new run on an idle strand
+        std::this_thread::sleep_for(5ms);
+    }
+
+    EXPECT_FALSE(s->running_in_this_thread());
+}
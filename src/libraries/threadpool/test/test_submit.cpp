@@ -0,0 +1,298 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <m/threadpool/threadpool.h>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    //
+    // Holds pool threads until released so that tests can control what is
+    // queued behind them.
+    //
+    class gate
+    {
+    public:
+        void
+        pass()
+        {
+            auto l = std::unique_lock(m_mutex);
+            m_arrived++;
+            m_cv.notify_all();
+            m_cv.wait(l, [this]() { return m_open; });
+        }
+
+        bool
+        wait_for_arrivals(std::size_t count)
+        {
+            auto l = std::unique_lock(m_mutex);
+            return m_cv.wait_for(l, 10s, [&]() { return m_arrived >= count; });
+        }
+
+        void
+        open()
+        {
+            auto l = std::unique_lock(m_mutex);
+            m_open = true;
+            m_cv.notify_all();
+        }
+
+    private:
+        std::mutex              m_mutex;
+        std::condition_variable m_cv;
+        std::size_t             m_arrived{};
+        bool                    m_open{false};
+    };
+} // namespace
+
+TEST(Submit, RunsWork)
+{
+    auto const done   = std::make_shared<std::promise<void>>();
+    auto       future = done->get_future();
+
+    m::threadpool->submit([done]() { done->set_value(); });
+
+    EXPECT_EQ(future.wait_for(10s), std::future_status::ready);
+}
+
+TEST(Submit, HigherPriorityRunsFirst)
+{
+    constexpr std::size_t per_priority = 20;
+
+    gate                     g;
+    std::atomic<std::size_t> next{0};
+    std::atomic<std::size_t> position_sum[3]{};
+    std::atomic<std::size_t> remaining{3 * per_priority};
+    std::promise<void>       done;
+
+    // Declared last so that its workers are joined before the above go away
+    auto const pool    = m::make_platform_default_threadpool();
+    auto const workers = pool->concurrency();
+
+    for (std::size_t i = 0; i < workers; i++)
+        pool->submit([&]() { g.pass(); });
+
+    ASSERT_TRUE(g.wait_for_arrivals(workers));
+
+    auto const record = [&](m::work_priority p) {
+        position_sum[static_cast<std::size_t>(p)] += next++;
+        if (--remaining == 0)
+            done.set_value();
+    };
+
+    // Queue in the opposite order to the one they should run in
+    for (std::size_t i = 0; i < per_priority; i++)
+    {
+        pool->submit([&]() { record(m::work_priority::low); }, m::work_priority::low);
+        pool->submit([&]() { record(m::work_priority::normal); }, m::work_priority::normal);
+        pool->submit([&]() { record(m::work_priority::high); }, m::work_priority::high);
+    }
+
+    g.open();
+
+    ASSERT_EQ(done.get_future().wait_for(10s), std::future_status::ready);
+
+    // Workers racing to record their position can blur the boundaries a
+    // little, but not move the averages past one another.
+    EXPECT_LT(position_sum[0], position_sum[1]);
+    EXPECT_LT(position_sum[1], position_sum[2]);
+}
+
+TEST(Submit, BlockingWorkDoesNotStarveCpuWork)
+{
+    gate               g;
+    std::promise<void> done;
+
+    auto const pool     = m::make_platform_default_threadpool();
+    auto const blockers = pool->concurrency() * 2;
+
+    for (std::size_t i = 0; i < blockers; i++)
+        pool->submit_blocking([&]() { g.pass(); });
+
+    // More blocking work than there are CPU workers is all running at once
+    EXPECT_TRUE(g.wait_for_arrivals(blockers));
+
+    pool->submit([&]() { done.set_value(); });
+
+    EXPECT_EQ(done.get_future().wait_for(10s), std::future_status::ready);
+
+    g.open();
+}
+
+TEST(Submit, PinnedPlacements)
+{
+    for (auto const placement: {m::worker_placement::per_core, m::worker_placement::per_node})
+    {
+        auto const pool = m::make_platform_threadpool({.m_placement = placement});
+
+        ASSERT_GE(pool->concurrency(), 1u);
+        ASSERT_GE(pool->node_count(), 1u);
+
+        std::atomic<std::size_t> ran{0};
+        auto const               total  = pool->node_count() + 1;
+        auto const               done   = std::make_shared<std::promise<void>>();
+        auto                     future = done->get_future();
+
+        auto const work = [&ran, total, done]() {
+            if (++ran == total)
+                done->set_value();
+        };
+
+        for (std::size_t node = 0; node < pool->node_count(); node++)
+            pool->submit_on_node(node, work);
+
+        // Out of range is no preference rather than an error
+        pool->submit_on_node(pool->node_count(), work);
+
+        EXPECT_EQ(future.wait_for(10s), std::future_status::ready);
+
+        std::vector<int> v(10'000, 1);
+        EXPECT_EQ(pool->parallel_reduce(v, 100, 0, std::plus<>{}), 10'000);
+    }
+}
+
+TEST(Submit, Statistics)
+{
+    auto const pool = m::make_platform_threadpool({.m_statistics_by_description = true});
+
+    std::atomic<std::size_t> remaining{12};
+    auto const               done   = std::make_shared<std::promise<void>>();
+    auto                     future = done->get_future();
+
+    auto const work = [&remaining, done]() {
+        if (--remaining == 0)
+            done->set_value();
+    };
+
+    for (std::size_t i = 0; i < 10; i++)
+        pool->submit(work, m::work_priority::normal, L"decode");
+
+    pool->submit_blocking(work);
+
+    auto const timer = pool->create_timer(work);
+    timer->set(1ms);
+
+    ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+
+    // The counts are updated just after the work returns
+    auto const settled = [](m::threadpool_statistics const& s) {
+        return s.m_by_priority[1].m_completed == 11 && s.m_blocking.m_completed == 1;
+    };
+
+    auto stats = pool->statistics();
+    for (auto const deadline = std::chrono::steady_clock::now() + 10s;
+         !settled(stats) && std::chrono::steady_clock::now() < deadline;
+         stats = pool->statistics())
+        std::this_thread::sleep_for(1ms);
+
+    // The timer callback runs as normal priority work
+    EXPECT_EQ(stats.m_by_priority[1].m_completed, 11u);
+    EXPECT_EQ(stats.m_by_priority[1].m_queue_wait.m_count, 11u);
+    EXPECT_EQ(stats.m_by_priority[1].m_queued, 0u);
+    EXPECT_EQ(stats.m_blocking.m_completed, 1u);
+    EXPECT_EQ(stats.m_timer_lateness.m_count, 1u);
+    EXPECT_EQ(stats.m_workers, pool->concurrency());
+
+    auto const decode = stats.m_by_description.find(L"decode");
+    ASSERT_NE(decode, stats.m_by_description.end());
+    EXPECT_EQ(decode->second.m_completed, 10u);
+}
+
+TEST(Submit, LatencyHistogramPercentile)
+{
+    m::latency_histogram h;
+
+    EXPECT_EQ(h.percentile(0.5), 0us);
+
+    // 90 samples in [1, 2)us and 10 in [512, 1024)us
+    h.m_buckets[1]  = 90;
+    h.m_buckets[10] = 10;
+    h.m_count       = 100;
+    h.m_max         = 700us;
+
+    EXPECT_EQ(h.percentile(0.5), 2us);
+    EXPECT_EQ(h.percentile(0.9), 2us);
+    EXPECT_EQ(h.percentile(0.95), 700us);
+    EXPECT_EQ(h.percentile(1.0), 700us);
+}
+
+TEST(Submit, BlockingRegionCompensates)
+{
+    std::promise<void> blocked_release;
+    auto               blocked_released = blocked_release.get_future().share();
+    auto const         other_ran        = std::make_shared<std::promise<void>>();
+    auto               other_future     = other_ran->get_future();
+
+    auto const pool =
+        m::make_platform_threadpool({.m_worker_count = 1, .m_idle_timeout = 10ms});
+
+    pool->submit([blocked_released]() {
+        m::blocking_region region;
+        blocked_released.wait();
+    });
+
+    // Only runs if another worker stands in for the blocked one
+    pool->submit([other_ran]() { other_ran->set_value(); });
+
+    EXPECT_EQ(other_future.wait_for(10s), std::future_status::ready);
+
+    blocked_release.set_value();
+
+#ifndef WIN32
+    auto stats = pool->statistics();
+    for (auto const deadline = std::chrono::steady_clock::now() + 10s;
+         stats.m_worker_threads != 1 && std::chrono::steady_clock::now() < deadline;
+         stats = pool->statistics())
+        std::this_thread::sleep_for(1ms);
+
+    EXPECT_GE(stats.m_compensating_threads, 1u);
+    EXPECT_GE(stats.m_threads_retired, 1u);
+    EXPECT_EQ(stats.m_worker_threads, 1u);
+    EXPECT_EQ(stats.m_blocked_workers, 0u);
+#endif
+}
+
+TEST(Submit, AdaptiveWorkerCount)
+{
+    constexpr std::size_t item_count = 1'000;
+
+    std::atomic<std::size_t> remaining{item_count};
+    auto const               done   = std::make_shared<std::promise<void>>();
+    auto                     future = done->get_future();
+
+    auto const pool = m::make_platform_threadpool({.m_worker_count = 1, .m_max_worker_count = 4});
+
+    // Work that waits without saying so gets more done with more workers
+    for (std::size_t i = 0; i < item_count; i++)
+    {
+        pool->submit([&remaining, done]() {
+            std::this_thread::sleep_for(1ms);
+            if (--remaining == 0)
+                done->set_value();
+        });
+    }
+
+    ASSERT_EQ(future.wait_for(30s), std::future_status::ready);
+
+#ifndef WIN32
+    auto const stats = pool->statistics();
+
+    EXPECT_GE(stats.m_target_raised, 1u);
+    EXPECT_GE(stats.m_threads_started, 1u);
+    EXPECT_LE(stats.m_worker_target, 4u);
+#endif
+}
@@ -3,12 +3,17 @@
 
 #include <gtest/gtest.h>
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <filesystem>
+#include <format>
 #include <latch>
+#include <random>
 #include <span>
 #include <string_view>
+#include <thread>
+#include <vector>
 
 #include <m/debugging/dbg_format.h>
 #include <m/threadpool/threadpool.h>
@@ -323,3 +328,424 @@ TEST(Timer, EnsureDestructionDelayed)
     EXPECT_TRUE(ran);
 }
 
+
+TEST(Timer, TryCancelBeforeExpiry)
+{
+    std::atomic<bool> ran{false};
+
+    auto t1 = m::threadpool->create_timer([&]() { ran.store(true, std::memory_order_release); });
+
+    t1->set(10s);
+    EXPECT_FALSE(t1->done());
+
+    t1->try_cancel();
+
+    EXPECT_TRUE(t1->cancel_requested());
+    EXPECT_TRUE(t1->done());
+
+    t1.reset();
+    EXPECT_FALSE(ran);
+}
+
+TEST(Timer, SetWhileArmedMovesTheExpiry)
+{
+    std::atomic<int> calls{0};
+
+    auto t1 = m::threadpool->create_timer([&]() {
+        calls.fetch_add(1, std::memory_order_acq_rel);
+        calls.notify_all();
+    });
+
+    // Moved twice while in the wheel; it must be in one slot, once
+    t1->set(1h);
+    t1->set(10ms);
+    t1->set(20ms);
+
+    calls.wait(0, std::memory_order_acquire);
+    std::this_thread::sleep_for(100ms);
+    EXPECT_EQ(calls.load(), 1);
+
+    // Moved out past the end of the test, so the earlier expiry is gone
+    t1->set(10ms);
+    t1->set(1h);
+    std::this_thread::sleep_for(100ms);
+    EXPECT_EQ(calls.load(), 1);
+}
+
+TEST(Timer, SetWhileRunningRunsAgainAfterwards)
+{
+    std::atomic<int>  calls{0};
+    std::atomic<int>  running{0};
+    std::atomic<int>  overlaps{0};
+    std::atomic<bool> go{false};
+    std::latch        started(1);
+
+    auto t1 = m::threadpool->create_timer([&]() {
+        if (running.fetch_add(1, std::memory_order_acq_rel) != 0)
+            overlaps.fetch_add(1, std::memory_order_relaxed);
+
+        if (calls.fetch_add(1, std::memory_order_acq_rel) == 0)
+        {
+            started.count_down();
+            go.wait(false, std::memory_order_acquire);
+        }
+
+        running.fetch_sub(1, std::memory_order_acq_rel);
+        calls.notify_all();
+    });
+
+    t1->set(0s);
+    started.wait();
+
+    // Blocks until the callback has returned, then arms it again
+    auto setter = std::thread([&]() { t1->set(0s); });
+
+    std::this_thread::sleep_for(20ms);
+    go.store(true, std::memory_order_release);
+    go.notify_all();
+    setter.join();
+
+    for (auto n = calls.load(); n < 2; n = calls.load())
+        calls.wait(n, std::memory_order_acquire);
+
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(calls.load(), 2);
+    EXPECT_EQ(overlaps.load(), 0);
+}
+
+TEST(Timer, SetWhileQueuedIsNotSubmittedTwice)
+{
+    std::atomic<int> calls{0};
+    std::atomic<int> running{0};
+    std::atomic<int> overlaps{0};
+
+    auto t1 = m::threadpool->create_timer([&]() {
+        if (running.fetch_add(1, std::memory_order_acq_rel) != 0)
+            overlaps.fetch_add(1, std::memory_order_relaxed);
+
+        std::this_thread::sleep_for(10ms);
+
+        running.fetch_sub(1, std::memory_order_acq_rel);
+        calls.fetch_add(1, std::memory_order_acq_rel);
+        calls.notify_all();
+    });
+
+    //
+    // Either the second set finds the first expiry still in flight and
+    // arms the timer once it has finished, or it comes after; it runs
+    // twice in a row either way.
+    //
+    t1->set(0s);
+    t1->set(0s);
+
+    for (auto n = calls.load(); n < 2; n = calls.load())
+        calls.wait(n, std::memory_order_acquire);
+
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(calls.load(), 2);
+    EXPECT_EQ(overlaps.load(), 0);
+}
+
+TEST(Timer, ToleranceNeverFiresEarly)
+{
+    std::atomic<bool>                     ran{false};
+    std::chrono::steady_clock::time_point fired_at;
+
+    auto t1 = m::threadpool->create_timer([&]() {
+        fired_at = std::chrono::steady_clock::now();
+        ran.store(true, std::memory_order_release);
+        ran.notify_all();
+    });
+
+    auto const start = std::chrono::steady_clock::now();
+
+    t1->set(50ms, 200ms);
+    ran.wait(false, std::memory_order_acquire);
+    t1.reset();
+
+    EXPECT_GE(fired_at - start, 50ms);
+}
+
+TEST(Timer, ManyConcurrentTimers)
+{
+    //
+    // Enough timers, spread over enough time, that they land on more than
+    // one level of a hierarchical timer implementation.
+    //
+    constexpr std::size_t timer_count = 100'000;
+    constexpr auto        max_delay   = 600ms;
+
+    std::atomic<std::size_t> fired{0};
+    std::atomic<std::size_t> early{0};
+
+    struct timer_data
+    {
+        std::chrono::steady_clock::time_point m_deadline;
+        std::shared_ptr<m::timer>             m_timer;
+    };
+
+    std::vector<timer_data> timers(timer_count);
+    std::mt19937            rng(12345);
+    std::uniform_int_distribution<long long> dist(0, max_delay.count());
+
+    for (auto& t: timers)
+    {
+        t.m_timer = m::threadpool->create_timer([&t, &fired, &early]() {
+            if (std::chrono::steady_clock::now() < t.m_deadline)
+                early.fetch_add(1, std::memory_order_relaxed);
+
+            if (fired.fetch_add(1, std::memory_order_acq_rel) + 1 == timer_count)
+                fired.notify_all();
+        });
+    }
+
+    for (auto& t: timers)
+    {
+        auto const delay = std::chrono::milliseconds(dist(rng));
+        t.m_deadline     = std::chrono::steady_clock::now() + delay;
+        t.m_timer->set(delay);
+    }
+
+    for (auto n = fired.load(std::memory_order_acquire); n != timer_count;
+         n      = fired.load(std::memory_order_acquire))
+    {
+        fired.wait(n, std::memory_order_acquire);
+    }
+
+    EXPECT_EQ(early.load(), 0u);
+
+    for (auto& t: timers)
+        EXPECT_TRUE(t.m_timer->done());
+}
+
+namespace
+{
+    //
+    // Collects the time of each callback of a periodic timer and signals
+    // once `count` of them have happened.
+    //
+    struct tick_recorder
+    {
+        explicit tick_recorder(std::size_t count): m_times(count) {}
+
+        void
+        tick()
+        {
+            auto const n = m_ticks.load(std::memory_order_relaxed);
+
+            if (n < m_times.size())
+                m_times[n] = std::chrono::steady_clock::now();
+
+            m_ticks.store(n + 1, std::memory_order_release);
+            m_ticks.notify_all();
+        }
+
+        // Checks that nothing ticks once the timer is gone
+        void
+        expect_no_more_ticks()
+        {
+            auto const n = m_ticks.load(std::memory_order_acquire);
+            std::this_thread::sleep_for(50ms);
+            EXPECT_EQ(m_ticks.load(std::memory_order_acquire), n);
+        }
+
+        void
+        wait()
+        {
+            for (auto n = m_ticks.load(std::memory_order_acquire); n < m_times.size();
+                 n      = m_ticks.load(std::memory_order_acquire))
+            {
+                m_ticks.wait(n, std::memory_order_acquire);
+            }
+        }
+
+        std::vector<std::chrono::steady_clock::time_point> m_times;
+        std::atomic<std::size_t>                           m_ticks{0};
+    };
+} // namespace
+
+TEST(Timer, PeriodicDoesNotDrift)
+{
+    constexpr std::size_t tick_count = 20;
+
+    tick_recorder recorder(tick_count);
+
+    auto t1 = m::threadpool->create_timer([&]() {
+        recorder.tick();
+        // Callback runtime must not push later ticks back
+        std::this_thread::sleep_for(4ms);
+    });
+
+    auto const start = std::chrono::steady_clock::now();
+
+    t1->set_periodic(10ms, 10ms);
+    recorder.wait();
+    t1->try_cancel();
+    t1.reset();
+
+    //
+    // Every tick keeps to its own slot on the absolute schedule. How late
+    // the ticks run depends on the load on the machine, so there is no
+    // upper bound here; the skip and catch up tests below cover how the
+    // schedule recovers from a late tick.
+    //
+    for (std::size_t i = 0; i < tick_count; i++)
+        EXPECT_GE(recorder.m_times[i] - start, 10ms + i * 10ms);
+
+    EXPECT_GE(recorder.m_ticks.load(), tick_count);
+    recorder.expect_no_more_ticks();
+}
+
+TEST(Timer, PeriodicSkipsMissedTicks)
+{
+    tick_recorder recorder(2);
+
+    auto t1 = m::threadpool->create_timer([&]() {
+        recorder.tick();
+        if (recorder.m_ticks.load() == 1)
+            std::this_thread::sleep_for(70ms);
+    });
+
+    auto const start = std::chrono::steady_clock::now();
+
+    t1->set_periodic(20ms, 0ms, m::missed_tick_policy::skip);
+    recorder.wait();
+    t1->try_cancel();
+    t1.reset();
+
+    // The ticks at 20, 40 and 60ms went by during the first callback
+    EXPECT_GE(recorder.m_times[1] - start, 80ms);
+    recorder.expect_no_more_ticks();
+}
+
+TEST(Timer, PeriodicCatchesUpMissedTicks)
+{
+    tick_recorder recorder(4);
+
+    auto t1 = m::threadpool->create_timer([&]() {
+        recorder.tick();
+        if (recorder.m_ticks.load() == 1)
+            std::this_thread::sleep_for(200ms);
+    });
+
+    auto const start = std::chrono::steady_clock::now();
+
+    t1->set_periodic(20ms, 0ms, m::missed_tick_policy::catch_up);
+    recorder.wait();
+    t1->try_cancel();
+    t1.reset();
+
+    //
+    // The ticks at 20, 40 and 60ms are all still run, one after the other
+    // once the first callback has returned, and none of them earlier.
+    //
+    for (std::size_t i = 1; i < 4; i++)
+        EXPECT_GE(recorder.m_times[i] - start, 200ms);
+
+    EXPECT_GE(recorder.m_ticks.load(), 4u);
+    recorder.expect_no_more_ticks();
+}
+
+TEST(Timer, PeriodicTryCancel)
+{
+    std::atomic<std::size_t> ticks{0};
+
+    auto t1 = m::threadpool->create_timer([&]() { ticks.fetch_add(1); });
+
+    t1->set_periodic(1h, 1h);
+    EXPECT_FALSE(t1->done());
+
+    t1->try_cancel();
+    EXPECT_TRUE(t1->done());
+    EXPECT_EQ(ticks.load(), 0u);
+}
+
+namespace
+{
+    // Counts the times it is formatted
+    struct format_counter
+    {
+        std::atomic<int>* m_count;
+    };
+} // namespace
+
+template <>
+struct std::formatter<format_counter, wchar_t>
+{
+    constexpr auto
+    parse(auto& ctx)
+    {
+        return ctx.begin();
+    }
+
+    auto
+    format(format_counter const& c, auto& ctx) const
+    {
+        return std::format_to(ctx.out(), L"{}", c.m_count->fetch_add(1) + 1);
+    }
+};
+
+TEST(Timer, DescriptionNotFormattedUnlessFired)
+{
+    std::atomic<int> formatted{0};
+
+    {
+        auto t1 =
+            m::threadpool->create_timer([]() {}, L"never fires {}", format_counter{&formatted});
+
+        t1->set(1h);
+        t1->try_cancel();
+        EXPECT_TRUE(t1->done());
+    }
+
+    EXPECT_EQ(formatted.load(), 0);
+}
+
+TEST(Timer, LargeCallback)
+{
+    // Too big to be stored in the timer itself
+    std::array<std::size_t, 64> values{};
+    values.back() = 42;
+
+    std::atomic<std::size_t> seen{0};
+
+    auto t1 = m::threadpool->create_timer([&seen, values]() {
+        seen.store(values.back(), std::memory_order_release);
+        seen.notify_all();
+    });
+
+    t1->set(0s);
+
+    seen.wait(0, std::memory_order_acquire);
+    EXPECT_EQ(seen.load(), 42u);
+}
+
+TEST(Timer, ManyShortLivedTimers)
+{
+    //
+    // The per request deadline pattern: almost every timer is cancelled
+    // long before it would fire, and a few do fire.
+    //
+    std::atomic<std::size_t> fired{0};
+
+    for (int i = 0; i < 20'000; i++)
+    {
+        auto t1 = m::threadpool->create_timer([&fired]() { fired.fetch_add(1); },
+                                              L"request {} deadline",
+                                              i);
+
+        if (i % 1000 == 0)
+        {
+            t1->set(0s);
+            while (!t1->done())
+                std::this_thread::yield();
+        }
+        else
+        {
+            t1->set(30s);
+            t1->try_cancel();
+        }
+    }
+
+    EXPECT_EQ(fired.load(), 20u);
+}
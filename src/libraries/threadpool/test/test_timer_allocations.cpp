@@ -0,0 +1,107 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+//
+// Built on its own, as it replaces the global operator new to count every
+// allocation in the process.
+//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include <m/threadpool/threadpool.h>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    std::atomic<std::size_t> allocations;
+
+    void*
+    counted_allocate(std::size_t size, std::size_t alignment)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+
+        // aligned_alloc wants a whole number of alignments
+        size = (std::max)(size, std::size_t{1});
+        size = (size + alignment - 1) / alignment * alignment;
+
+        auto const p = alignment <= alignof(std::max_align_t) ? std::malloc(size) :
+                                                                std::aligned_alloc(alignment, size);
+
+        if (!p)
+            throw std::bad_alloc();
+
+        return p;
+    }
+
+    void
+    create_and_cancel(std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            auto const t = m::threadpool->create_timer([]() {});
+
+            t->set(1h);
+            t->try_cancel();
+        }
+    }
+} // namespace
+
+void*
+operator new(std::size_t size)
+{
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void*
+operator new(std::size_t size, std::align_val_t alignment)
+{
+    return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+TEST(Timer, SteadyStateDoesNotAllocate)
+{
+    //
+    // The first round fills the timer slab and grows whatever the timer
+    // engine keeps to its working size. After that, timers come and go
+    // without touching the heap.
+    //
+    create_and_cancel(1000);
+
+    auto const before = allocations.load();
+
+    create_and_cancel(1000);
+
+    EXPECT_EQ(allocations.load() - before, 0u);
+}
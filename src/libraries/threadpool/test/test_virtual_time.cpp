@@ -0,0 +1,158 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <m/threadpool/task.h>
+#include <m/threadpool/virtual_time.h>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    m::task<std::chrono::microseconds>
+    wait_an_hour(m::virtual_time_threadpool& pool)
+    {
+        co_await pool.schedule();
+        co_await pool.delay(1h);
+        co_return pool.now();
+    }
+} // namespace
+
+TEST(VirtualTime, OneShotFiresAtDeadline)
+{
+    auto const pool = m::make_virtual_time_threadpool();
+
+    std::atomic<int> fired{0};
+
+    auto const t = pool->create_timer([&]() { fired++; });
+    t->set(10s);
+
+    pool->advance(9s);
+    EXPECT_EQ(fired, 0);
+    EXPECT_FALSE(t->done());
+
+    pool->advance(1s);
+    EXPECT_EQ(fired, 1);
+    EXPECT_TRUE(t->done());
+    EXPECT_EQ(pool->now(), 10s);
+}
+
+TEST(VirtualTime, FiresInDeadlineOrder)
+{
+    auto const pool = m::make_virtual_time_threadpool();
+
+    std::mutex       mutex;
+    std::vector<int> order;
+
+    auto const record = [&](int i) {
+        return pool->create_timer([&, i]() {
+            auto l = std::unique_lock(mutex);
+            order.push_back(i);
+        });
+    };
+
+    auto const t3 = record(3);
+    auto const t1 = record(1);
+    auto const t2 = record(2);
+
+    t3->set(3min);
+    t1->set(1min);
+    t2->set(2min);
+
+    pool->advance(1h);
+
+    EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(VirtualTime, PeriodicTicksUntilCancelled)
+{
+    auto const pool = m::make_virtual_time_threadpool();
+
+    std::atomic<int> ticks{0};
+
+    auto const t = pool->create_timer([&]() { ticks++; });
+    t->set_periodic(1s, 1s);
+
+    pool->advance(10s);
+    EXPECT_EQ(ticks, 10);
+
+    t->try_cancel();
+    pool->advance(10s);
+    EXPECT_EQ(ticks, 10);
+    EXPECT_TRUE(t->done());
+}
+
+TEST(VirtualTime, CallbacksArmTimers)
+{
+    auto const pool = m::make_virtual_time_threadpool();
+
+    std::chrono::microseconds fired_at{};
+
+    auto const second = pool->create_timer([&]() { fired_at = pool->now(); });
+    auto const first  = pool->create_timer([&]() { second->set(30s); });
+
+    first->set(1min);
+
+    // Both fall within the step, the second only once the first has run
+    pool->advance(2min);
+
+    EXPECT_EQ(fired_at, 90s);
+}
+
+TEST(VirtualTime, CancelledTimerNeverFires)
+{
+    auto const pool = m::make_virtual_time_threadpool();
+
+    std::atomic<int> fired{0};
+
+    auto const t = pool->create_timer([&]() { fired++; });
+    t->set(5s);
+    t->try_cancel();
+
+    EXPECT_TRUE(t->done());
+
+    pool->advance(10s);
+    EXPECT_EQ(fired, 0);
+}
+
+TEST(VirtualTime, RunUntilIdleWaitsForWork)
+{
+    auto const pool = m::make_virtual_time_threadpool();
+
+    std::atomic<int> ran{0};
+
+    for (int i = 0; i < 10; i++)
+    {
+        pool->submit([&]() {
+            std::this_thread::sleep_for(1ms);
+            ran++;
+        });
+    }
+
+    pool->run_until_idle();
+
+    EXPECT_EQ(ran, 10);
+    EXPECT_EQ(pool->now(), 0s);
+}
+
+TEST(VirtualTime, CoroutineDelay)
+{
+    auto const pool = m::make_virtual_time_threadpool();
+
+    auto result =
+        std::async(std::launch::async, [&]() { return m::sync_wait(wait_an_hour(*pool)); });
+
+    // The task arms its timer at some point after it starts
+    while (result.wait_for(0s) != std::future_status::ready)
+        pool->advance(10min);
+
+    EXPECT_GE(result.get(), 1h);
+}